@@ -60,6 +60,8 @@ typedef enum nfc_adapter_property {
     /* Since 1.2.0 */
     NFC_ADAPTER_PROPERTY_T4_NDEF,
     NFC_ADAPTER_PROPERTY_LA_NFCID1,
+    /* Since 1.3.0 */
+    NFC_ADAPTER_PROPERTY_RETRYING,
     /* Moving target: */
     NFC_ADAPTER_PROPERTY_COUNT
 } NFC_ADAPTER_PROPERTY;
@@ -109,6 +111,8 @@ struct nfc_adapter_client {
     int version;                /* Adapter D-Bus interface version */
     gboolean t4_ndef;           /* TRUE for nfcd < 1.2.2 */
     const GUtilData* la_nfcid1; /* NULL for nfcd < 1.2.2 */
+    /* Since 1.3.0 */
+    gboolean retrying;          /* Waiting to retry initialization */
 };
 
 typedef
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_ADAPTER_POOL_H
+#define NFCDC_ADAPTER_POOL_H
+
+#include <nfcdc_adapter.h>
+
+/* This API exists since 1.3.0 */
+
+G_BEGIN_DECLS
+
+/*
+ * NfcAdapterPool tracks all adapters known to nfcd. Tags and peers
+ * present on all of them are aggregated into single lists, arrivals
+ * and departures are reported together with the adapter they belong to.
+ *
+ * Jobs submitted to the pool (e.g. card personalization) get exclusive
+ * access to an adapter, one job per adapter at a time. If more than one
+ * adapter is idle, the one which has spent the least time running jobs
+ * gets picked. Jobs which can't be started right away are queued and
+ * started in the order they were submitted. The start callback is never
+ * invoked by nfc_adapter_pool_job_submit() itself. A running job keeps
+ * its adapter until nfc_adapter_pool_job_done() is called, even if the
+ * adapter disappears in the meantime.
+ */
+
+typedef enum nfc_adapter_pool_property {
+    NFC_ADAPTER_POOL_PROPERTY_ANY,
+    NFC_ADAPTER_POOL_PROPERTY_VALID,
+    NFC_ADAPTER_POOL_PROPERTY_ADAPTERS,
+    NFC_ADAPTER_POOL_PROPERTY_TAGS,
+    NFC_ADAPTER_POOL_PROPERTY_PEERS,
+    NFC_ADAPTER_POOL_PROPERTY_BUSY,
+    NFC_ADAPTER_POOL_PROPERTY_QUEUED,
+    NFC_ADAPTER_POOL_PROPERTY_COUNT
+} NFC_ADAPTER_POOL_PROPERTY;
+
+typedef enum nfc_adapter_pool_event {
+    NFC_ADAPTER_POOL_TAG_ARRIVED,
+    NFC_ADAPTER_POOL_TAG_LEFT,
+    NFC_ADAPTER_POOL_PEER_ARRIVED,
+    NFC_ADAPTER_POOL_PEER_LEFT,
+    NFC_ADAPTER_POOL_EVENT_COUNT
+} NFC_ADAPTER_POOL_EVENT;
+
+struct nfc_adapter_pool {
+    gboolean valid;
+    const GStrV* adapters;      /* Present adapters */
+    const GStrV* tags;          /* Tags present on all adapters */
+    const GStrV* peers;         /* Peers present on all adapters */
+    guint busy;                 /* Number of running jobs */
+    guint queued;               /* Number of jobs waiting for an adapter */
+};
+
+/* Utilization is busy_time/tracked_time */
+typedef struct nfc_adapter_pool_stats {
+    guint64 tracked_time;       /* Microseconds since joining the pool */
+    guint64 busy_time;          /* Microseconds spent running jobs */
+    guint jobs;                 /* Number of completed jobs */
+    guint tags;                 /* Number of tag arrivals */
+    gboolean busy;              /* TRUE if a job is running */
+} NfcAdapterPoolStats;
+
+typedef struct nfc_adapter_pool_job NfcAdapterPoolJob;
+
+typedef
+void
+(*NfcAdapterPoolPropertyFunc)(
+    NfcAdapterPool* pool,
+    NFC_ADAPTER_POOL_PROPERTY property,
+    void* user_data);
+
+typedef
+void
+(*NfcAdapterPoolTargetFunc)(
+    NfcAdapterPool* pool,
+    NfcAdapterClient* adapter,
+    const char* path,
+    void* user_data);
+
+typedef
+void
+(*NfcAdapterPoolJobFunc)(
+    NfcAdapterPool* pool,
+    NfcAdapterPoolJob* job,
+    NfcAdapterClient* adapter,
+    void* user_data);
+
+NfcAdapterPool*
+nfc_adapter_pool_new(
+    void);
+
+NfcAdapterPool*
+nfc_adapter_pool_ref(
+    NfcAdapterPool* pool);
+
+void
+nfc_adapter_pool_unref(
+    NfcAdapterPool* pool);
+
+gboolean
+nfc_adapter_pool_get_stats(
+    NfcAdapterPool* pool,
+    const char* adapter_path,
+    NfcAdapterPoolStats* stats);
+
+gulong
+nfc_adapter_pool_add_property_handler(
+    NfcAdapterPool* pool,
+    NFC_ADAPTER_POOL_PROPERTY property,
+    NfcAdapterPoolPropertyFunc callback,
+    void* user_data);
+
+gulong
+nfc_adapter_pool_add_target_handler(
+    NfcAdapterPool* pool,
+    NFC_ADAPTER_POOL_EVENT event,
+    NfcAdapterPoolTargetFunc callback,
+    void* user_data);
+
+void
+nfc_adapter_pool_remove_handler(
+    NfcAdapterPool* pool,
+    gulong id);
+
+void
+nfc_adapter_pool_remove_handlers(
+    NfcAdapterPool* pool,
+    gulong* ids,
+    guint count);
+
+#define nfc_adapter_pool_remove_all_handlers(pool, ids) \
+    nfc_adapter_pool_remove_handlers(pool, ids, G_N_ELEMENTS(ids))
+
+/* N.B. NfcAdapterPoolJob holds a reference to NfcAdapterPool */
+NfcAdapterPoolJob*
+nfc_adapter_pool_job_submit(
+    NfcAdapterPool* pool,
+    NfcAdapterPoolJobFunc start,
+    void* user_data,
+    GDestroyNotify destroy);
+
+/* Releases the adapter of a running job or cancels a queued one */
+void
+nfc_adapter_pool_job_done(
+    NfcAdapterPoolJob* job);
+
+G_END_DECLS
+
+#endif /* NFCDC_ADAPTER_POOL_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_DEBUG_H
+#define NFCDC_DEBUG_H
+
+#include <nfcdc_types.h>
+
+/* This API exists since 1.3.0 */
+
+G_BEGIN_DECLS
+
+/*
+ * Controls the debug dumps (tag lists, parameter values and such) which
+ * the library produces at debug log level.
+ *
+ * The rate limit applies to each category of dumps separately, lines
+ * exceeding the limit are dropped and counted. Zero (the default) means
+ * no limit.
+ *
+ * In ring mode the dumps are recorded regardless of the log level into
+ * a fixed size in-memory ring instead of going to the log. Recording
+ * is lock-free and doesn't allocate memory, so it can be left on in
+ * production and the contents fetched when something goes wrong.
+ */
+
+void
+nfc_debug_set_rate_limit(
+    guint lines_per_sec);
+
+void
+nfc_debug_set_ring_enabled(
+    gboolean enabled);
+
+/* Oldest line first, one per line, free with g_free() */
+char*
+nfc_debug_ring_dump(
+    void)
+    G_GNUC_WARN_UNUSED_RESULT;
+
+G_END_DECLS
+
+#endif /* NFCDC_DEBUG_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
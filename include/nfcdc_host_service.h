@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_HOST_SERVICE_H
+#define NFCDC_HOST_SERVICE_H
+
+#include <nfcdc_isodep.h>
+
+/* This API exists since 1.3.0 */
+
+G_BEGIN_DECLS
+
+typedef enum nfc_host_service_property {
+    NFC_HOST_SERVICE_PROPERTY_ANY,
+    NFC_HOST_SERVICE_PROPERTY_REGISTERED,
+    NFC_HOST_SERVICE_PROPERTY_COUNT
+} NFC_HOST_SERVICE_PROPERTY;
+
+typedef enum nfc_host_app_flags {
+    NFC_HOST_APP_FLAGS_NONE = 0x00,
+    NFC_HOST_APP_MATCH_EXACT = 0x01,
+    NFC_HOST_APP_MATCH_PREFIX = 0x02
+} NFC_HOST_APP_FLAGS;
+
+#define NFC_HOST_APDU_HEADER(cla,ins,p1,p2) \
+    ((((guint32)(cla) & 0xff) << 24) | (((guint32)(ins) & 0xff) << 16) | \
+     (((guint32)(p1) & 0xff) << 8) | ((guint32)(p2) & 0xff))
+
+/*
+ * APDU header is compared against the header field, only the bits set
+ * in the mask are compared. NULL data matches any command data.
+ */
+typedef struct nfc_host_static_response {
+    guint32 header;         /* NFC_HOST_APDU_HEADER(CLA,INS,P1,P2) */
+    guint32 mask;           /* Header bits to compare */
+    const GUtilData* data;  /* Command data to match, NULL for any */
+    GUtilData response;     /* Response data */
+    guint sw;               /* 16 bits (SW1 << 8)|SW2 */
+} NfcHostStaticResponse;
+
+struct nfc_host_service {
+    const char* path;
+    const char* name;
+    gboolean registered;
+};
+
+/*
+ * Incoming command APDU.
+ *
+ * Passed to NfcHostServiceProcessFunc, must be eventually answered with
+ * nfc_host_request_respond() or nfc_host_request_respond_bytes(). The
+ * response can be sent later, in which case the handler has to add a
+ * reference to the request and drop it after responding.
+ *
+ * If the last reference is dropped without responding, the request is
+ * answered with 6F00 (no precise diagnosis).
+ *
+ * The response goes back to nfcd as the reply to the original D-Bus
+ * call, i.e. no extra bus traffic is generated.
+ */
+
+struct nfc_host_request {
+    const char* host;
+    NfcIsoDepApdu apdu;
+};
+
+typedef
+void
+(*NfcHostServiceProcessFunc)(
+    NfcHostService* service,
+    NfcHostRequest* request,
+    void* user_data);
+
+typedef
+void
+(*NfcHostServicePropertyFunc)(
+    NfcHostService* service,
+    NFC_HOST_SERVICE_PROPERTY property,
+    void* user_data);
+
+typedef
+void
+(*NfcHostServiceHostFunc)(
+    NfcHostService* service,
+    const char* host,
+    void* user_data);
+
+NfcHostService*
+nfc_host_service_new(
+    const char* path,
+    const char* name,
+    NfcHostServiceProcessFunc process,
+    void* user_data);
+
+NfcHostService*
+nfc_host_service_ref(
+    NfcHostService* service);
+
+void
+nfc_host_service_unref(
+    NfcHostService* service);
+
+gulong
+nfc_host_service_add_property_handler(
+    NfcHostService* service,
+    NFC_HOST_SERVICE_PROPERTY property,
+    NfcHostServicePropertyFunc func,
+    void* user_data);
+
+gulong
+nfc_host_service_add_start_handler(
+    NfcHostService* service,
+    NfcHostServiceHostFunc func,
+    void* user_data);
+
+gulong
+nfc_host_service_add_restart_handler(
+    NfcHostService* service,
+    NfcHostServiceHostFunc func,
+    void* user_data);
+
+gulong
+nfc_host_service_add_stop_handler(
+    NfcHostService* service,
+    NfcHostServiceHostFunc func,
+    void* user_data);
+
+void
+nfc_host_service_remove_handler(
+    NfcHostService* service,
+    gulong id);
+
+void
+nfc_host_service_remove_handlers(
+    NfcHostService* service,
+    gulong* ids,
+    guint count);
+
+#define nfc_host_service_remove_all_handlers(service, ids) \
+    nfc_host_service_remove_handlers(service, ids, G_N_ELEMENTS(ids))
+
+/*
+ * Apps are routed by AID. SELECT by name switches the service to the app
+ * which has the exact match for the AID, or else the longest prefix
+ * match. All other APDUs go to the currently selected app. If no app is
+ * selected, APDUs go to the NfcHostServiceProcessFunc passed to
+ * nfc_host_service_new(). Start, Restart and Stop deselect the app.
+ *
+ * Zero flags are equivalent to NFC_HOST_APP_MATCH_EXACT. Returns zero
+ * if the AID slot is already taken, in which case the destroy callback
+ * is invoked right away.
+ */
+guint
+nfc_host_service_add_app(
+    NfcHostService* service,
+    const GUtilData* aid,
+    NFC_HOST_APP_FLAGS flags,
+    NfcHostServiceProcessFunc process,
+    void* user_data,
+    GDestroyNotify destroy);
+
+void
+nfc_host_service_remove_app(
+    NfcHostService* service,
+    guint id);
+
+/*
+ * Static responses are sent directly from the D-Bus dispatch path,
+ * bypassing the main loop and the process callbacks. Zero app_id means
+ * that the responses apply regardless of which app is selected, but
+ * the responses of the selected app take precedence. Entries are
+ * matched in order, the first match wins. The table is copied.
+ * NULL or empty table removes the previously set one.
+ */
+gboolean
+nfc_host_service_set_static_responses(
+    NfcHostService* service,
+    guint app_id,
+    const NfcHostStaticResponse* responses,
+    guint count);
+
+NfcHostRequest*
+nfc_host_request_ref(
+    NfcHostRequest* request);
+
+void
+nfc_host_request_unref(
+    NfcHostRequest* request);
+
+gboolean
+nfc_host_request_respond(
+    NfcHostRequest* request,
+    const GUtilData* data,
+    guint sw); /* 16 bits (SW1 << 8)|SW2 */
+
+gboolean
+nfc_host_request_respond_bytes(
+    NfcHostRequest* request,
+    GBytes* data,
+    guint sw); /* 16 bits (SW1 << 8)|SW2 */
+
+G_END_DECLS
+
+#endif /* NFCDC_HOST_SERVICE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -40,7 +40,7 @@
 #ifndef NFCDC_ISODEP_H
 #define NFCDC_ISODEP_H
 
-#include <nfcdc_types.h>
+#include <nfcdc_scheduler.h>
 
 #include <gio/gio.h>
 
@@ -55,6 +55,7 @@ typedef enum nfc_isodep_property {
     NFC_ISODEP_PROPERTY_ANY,
     NFC_ISODEP_PROPERTY_VALID,
     NFC_ISODEP_PROPERTY_PRESENT,
+    NFC_ISODEP_PROPERTY_RETRYING, /* Since 1.3.0 */
     NFC_ISODEP_PROPERTY_COUNT
 } NFC_ISODEP_PROPERTY;
 
@@ -76,6 +77,7 @@ struct nfc_isodep_client {
     const char* path;
     gboolean valid;
     gboolean present;
+    gboolean retrying; /* Since 1.3.0 */
 };
 
 struct nfc_isodep_apdu {
@@ -110,6 +112,16 @@ void
     const GError* error,
     void* user_data); /* Since 1.1.0 */
 
+typedef
+void
+(*NfcIsoDepSessionFunc)(
+    NfcIsoDepClient* isodep,
+    NfcTagClientLock* lock,      /* NULL on failure */
+    const GUtilData* response,   /* SELECT response */
+    guint sw,                    /* 16 bits (SW1 << 8)|SW2 */
+    const GError* error,
+    void* user_data); /* Since 1.3.0 */
+
 NfcIsoDepClient*
 nfc_isodep_client_new(
     const char* path);
@@ -131,6 +143,11 @@ nfc_isodep_client_act_param(
     NfcIsoDepClient* isodep,
     NFC_ISODEP_ACT_PARAM param); /* Since 1.0.8 */
 
+/*
+ * Since 1.3.0, SELECT by name of the applet which has been selected by
+ * nfc_isodep_client_open_session() completes locally, with the FCI
+ * returned by that SELECT, for as long as the session lock is held.
+ */
 gboolean
 nfc_isodep_client_transmit(
     NfcIsoDepClient* isodep,
@@ -140,6 +157,36 @@ nfc_isodep_client_transmit(
     void* user_data,
     GDestroyNotify destroy);
 
+/*
+ * Same as nfc_isodep_client_transmit() but fails with G_IO_ERROR_TIMED_OUT
+ * as soon as the deadline (absolute g_get_monotonic_time() value) expires
+ * and then deactivates the tag, to abort the transfer that got stuck.
+ */
+gboolean
+nfc_isodep_client_transmit_with_deadline(
+    NfcIsoDepClient* isodep,
+    const NfcIsoDepApdu* apdu,
+    gint64 deadline,
+    GCancellable* cancel,
+    NfcIsoDepTransmitFunc complete,
+    void* user_data,
+    GDestroyNotify destroy); /* Since 1.3.0 */
+
+/*
+ * Same as nfc_isodep_client_transmit_with_deadline() but the call gets
+ * queued with the specified priority. Zero deadline means no deadline.
+ */
+gboolean
+nfc_isodep_client_transmit_with_priority(
+    NfcIsoDepClient* isodep,
+    const NfcIsoDepApdu* apdu,
+    NFC_CALL_PRIORITY priority,
+    gint64 deadline,
+    GCancellable* cancel,
+    NfcIsoDepTransmitFunc complete,
+    void* user_data,
+    GDestroyNotify destroy); /* Since 1.3.0 */
+
 gboolean
 nfc_isodep_reset(
     NfcIsoDepClient* isodep,
@@ -148,6 +195,22 @@ nfc_isodep_reset(
     void* user_data,
     GDestroyNotify destroy); /* Since 1.1.0 */
 
+/*
+ * Acquires the lock and selects the applet. If that's SELECT by name,
+ * the FCI gets cached until the lock is released or something else
+ * gets selected. Holding the lock keeps other processes away from the
+ * card, so the cache can't get stale.
+ */
+gboolean
+nfc_isodep_client_open_session(
+    NfcIsoDepClient* isodep,
+    const NfcIsoDepApdu* select,
+    gboolean wait,
+    GCancellable* cancel,
+    NfcIsoDepSessionFunc complete,
+    void* user_data,
+    GDestroyNotify destroy); /* Since 1.3.0 */
+
 gulong
 nfc_isodep_client_add_property_handler(
     NfcIsoDepClient* isodep,
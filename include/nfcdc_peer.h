@@ -53,6 +53,8 @@ typedef enum nfc_peer_property {
     NFC_PEER_PROPERTY_VALID,
     NFC_PEER_PROPERTY_PRESENT,
     NFC_PEER_PROPERTY_WKS,
+    NFC_PEER_PROPERTY_RETRYING,  /* Since 1.3.0 */
+    NFC_PEER_PROPERTY_CONGESTED, /* Since 1.3.0 */
     NFC_PEER_PROPERTY_COUNT
 } NFC_PEER_PROPERTY;
 
@@ -61,6 +63,8 @@ struct nfc_peer_client {
     gboolean valid;
     gboolean present;
     guint wks;
+    gboolean retrying;  /* Since 1.3.0 */
+    gboolean congested; /* Since 1.3.0 */
 };
 
 typedef
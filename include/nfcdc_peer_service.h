@@ -77,6 +77,14 @@ void
     const char* path,
     void* user_data);
 
+typedef
+void
+(*NfcPeerServiceDatagramFunc)(
+    NfcPeerService* service,
+    guint rsap,
+    const GUtilData* data,  /* Only valid during the callback */
+    void* user_data); /* Since 1.3.0 */
+
 NfcPeerService*
 nfc_peer_service_new(
     const char* path,
@@ -111,6 +119,29 @@ nfc_peer_service_add_peer_left_handler(
     NfcPeerServicePathFunc func,
     void* user_data);
 
+gulong
+nfc_peer_service_add_datagram_handler(
+    NfcPeerService* service,
+    NfcPeerServiceDatagramFunc func,
+    void* user_data); /* Since 1.3.0 */
+
+/*
+ * By default, NfcPeerServiceHandlerFunc is invoked synchronously from
+ * the Accept call handler. Non-zero backlog switches the service into
+ * asynchronous mode, where up to backlog incoming connections are queued
+ * and delivered to the handler from the main loop. At most max_active
+ * (unless it's zero) delivered connections can exist at any time, the
+ * next one is delivered when one of them gets finalized. Connections
+ * which don't fit into the backlog are rejected right away. Zero
+ * backlog switches back to synchronous mode rejecting the queued
+ * connections.
+ */
+void
+nfc_peer_service_set_accept_queue(
+    NfcPeerService* service,
+    guint backlog,
+    guint max_active); /* Since 1.3.0 */
+
 void
 nfc_peer_service_remove_handler(
     NfcPeerService* service,
@@ -139,6 +170,9 @@ nfc_peer_service_remove_handlers(
  * Not doing anything is equivalent to rejecting the connection.
  * File descriptor is owned by NfcServiceConnection and closed
  * when connection is finalized (ref count drops to zero).
+ *
+ * Since 1.3.0, nfc_service_connection_accept(), _ref() and _unref()
+ * can be called on any thread.
  */
 
 struct nfc_service_connection {
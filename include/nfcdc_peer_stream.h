@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_PEER_STREAM_H
+#define NFCDC_PEER_STREAM_H
+
+#include <nfcdc_types.h>
+
+/* This API exists since 1.3.0 */
+
+G_BEGIN_DECLS
+
+/*
+ * Buffered I/O over an LLCP connection socket, either the one returned
+ * by nfc_peer_client_connect_sap()/nfc_peer_client_connect_sn() or the
+ * one from an accepted NfcServiceConnection.
+ *
+ * The descriptor is duplicated, the caller still owns the original one.
+ * Note that the duplicate shares the file status flags with the original,
+ * which therefore becomes non-blocking too. Outgoing data is coalesced
+ * into packets of up to MIU bytes, each one becoming a single I-PDU.
+ * Incoming data is collected in a ring buffer and the read callback is
+ * invoked when there's something to read. When the ring buffer is full,
+ * reading stops until the application drains the buffer.
+ *
+ * The write queue is limited to 64K. A write which doesn't fit is
+ * refused (FALSE is returned but the stream remains open) and the write
+ * callback is invoked once the queue has drained enough to try again.
+ */
+
+struct nfc_peer_stream {
+    int fd;
+    guint miu;
+    gsize available;    /* Bytes available for reading */
+    gsize pending;      /* Bytes queued for writing */
+    gboolean closed;
+};
+
+typedef
+void
+(*NfcPeerStreamFunc)(
+    NfcPeerStream* stream,
+    void* user_data);
+
+typedef
+void
+(*NfcPeerStreamSendFunc)(
+    NfcPeerStream* stream,
+    gsize sent,
+    const GError* error,
+    void* user_data);
+
+NfcPeerStream*
+nfc_peer_stream_new(
+    int fd,
+    guint miu, /* Zero for the default (128 bytes) */
+    gsize buffer_size, /* Read buffer size, zero for the default */
+    NfcPeerStreamFunc read,
+    NfcPeerStreamFunc closed,
+    void* user_data);
+
+NfcPeerStream*
+nfc_peer_stream_ref(
+    NfcPeerStream* stream);
+
+void
+nfc_peer_stream_unref(
+    NfcPeerStream* stream);
+
+void
+nfc_peer_stream_close(
+    NfcPeerStream* stream);
+
+void
+nfc_peer_stream_set_write_func(
+    NfcPeerStream* stream,
+    NfcPeerStreamFunc writable);
+
+gboolean
+nfc_peer_stream_write(
+    NfcPeerStream* stream,
+    const void* data,
+    gsize size);
+
+gboolean
+nfc_peer_stream_writev(
+    NfcPeerStream* stream,
+    const GUtilData* chunks,
+    guint count);
+
+gsize
+nfc_peer_stream_read(
+    NfcPeerStream* stream,
+    void* buf,
+    gsize size);
+
+gsize
+nfc_peer_stream_peek(
+    NfcPeerStream* stream,
+    void* buf,
+    gsize size);
+
+/*
+ * Sends up to count bytes (or until EOF if count is zero) from the file
+ * descriptor, with splice() for pipes and sendfile() for everything else
+ * (falling back to read() + send() if the kernel can't do it). Only one
+ * bulk transfer at a time. It starts after the data queued with the
+ * write calls has been sent. Data written while the transfer is in
+ * progress is held back (and not counted as pending) until the transfer
+ * has finished. The descriptor must stay open until the completion
+ * callback is invoked. It's switched to non-blocking mode
+ * for the duration of the transfer, the original flags are restored
+ * when it's done. The destroy callback is always invoked, even if FALSE
+ * is returned.
+ */
+gboolean
+nfc_peer_stream_send_fd(
+    NfcPeerStream* stream,
+    int fd,
+    gsize count,
+    NfcPeerStreamSendFunc complete,
+    void* user_data,
+    GDestroyNotify destroy);
+
+G_END_DECLS
+
+#endif /* NFCDC_PEER_STREAM_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
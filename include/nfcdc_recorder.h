@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_RECORDER_H
+#define NFCDC_RECORDER_H
+
+#include <nfcdc_types.h>
+
+/* This API exists since 1.3.0 */
+
+G_BEGIN_DECLS
+
+/*
+ * Traffic recorder. Once started, every message (method call, reply,
+ * error and signal) sent or received over the library's D-Bus
+ * connection is written to a memory-mapped ring file. When the ring
+ * is full, the oldest records get overwritten. Nothing is done while
+ * there's no traffic, and nothing at all while the recorder is stopped.
+ *
+ * The file starts with NfcRecorderHeader followed by data_size bytes
+ * of ring. All numbers are in host byte order (which can be figured
+ * out from the version field). Valid records start at the tail offset
+ * and end at the head, each one being NfcRecorderRecord followed by
+ * object path, member (or error name), body signature and serialized
+ * body, none of them NUL-terminated, padded to 8 bytes. A zero size
+ * field, or less than a record header left before the end of the ring,
+ * means that the next record is at offset zero.
+ */
+
+#define NFC_RECORDER_MAGIC "NFCDCREC"
+#define NFC_RECORDER_VERSION (1)
+
+typedef struct nfc_recorder_header {
+    char magic[8];
+    guint32 version;
+    guint32 header_size;
+    guint64 data_size;
+    guint64 head;
+    guint64 tail;
+    guint64 count;
+    gint64 start_time;      /* g_get_monotonic_time() */
+    gint64 start_real_time; /* g_get_real_time() */
+} NfcRecorderHeader;
+
+typedef enum nfc_recorder_flags {
+    NFC_RECORDER_FLAG_INCOMING = 0x01,
+    NFC_RECORDER_FLAG_TRUNCATED = 0x02
+} NFC_RECORDER_FLAGS;
+
+typedef struct nfc_recorder_record {
+    guint32 size;           /* Including the header and padding */
+    guint8 type;            /* GDBusMessageType */
+    guint8 flags;           /* NFC_RECORDER_FLAGS */
+    guint8 member_len;
+    guint8 signature_len;
+    guint16 path_len;
+    guint16 reserved;
+    guint32 serial;
+    guint32 reply_serial;
+    guint32 body_len;
+    gint64 time;            /* g_get_monotonic_time() */
+} NfcRecorderRecord;
+
+/* Replaces the existing file, if any */
+gboolean
+nfc_recorder_start(
+    const char* path,
+    gsize size);
+
+void
+nfc_recorder_stop(
+    void);
+
+gboolean
+nfc_recorder_active(
+    void);
+
+G_END_DECLS
+
+#endif /* NFCDC_RECORDER_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
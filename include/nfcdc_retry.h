@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_RETRY_H
+#define NFCDC_RETRY_H
+
+#include <nfcdc_types.h>
+
+/* This API exists since 1.3.0 */
+
+G_BEGIN_DECLS
+
+/*
+ * When initialization of an adapter, tag, peer or ISO-DEP client fails,
+ * the client retries with jittered exponential backoff: the n-th retry
+ * is scheduled after a random delay between d/2 and d, where d is
+ * initial_delay_ms * 2^(n-1) but no more than max_delay_ms. Once
+ * max_retries consecutive attempts have failed, the client gives up
+ * until the next successful initialization or until the object gets
+ * reinitialized for some other reason. Zero max_retries disables the
+ * retries. While a retry is pending, the client's retrying flag is set.
+ *
+ * The policy is global and applies to retries scheduled after it's
+ * been changed.
+ */
+
+typedef struct nfc_client_retry_policy {
+    guint initial_delay_ms;
+    guint max_delay_ms;
+    guint max_retries;
+} NfcClientRetryPolicy;
+
+void
+nfc_client_retry_get_policy(
+    NfcClientRetryPolicy* policy);
+
+/* NULL restores the defaults */
+void
+nfc_client_retry_set_policy(
+    const NfcClientRetryPolicy* policy);
+
+G_END_DECLS
+
+#endif /* NFCDC_RETRY_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
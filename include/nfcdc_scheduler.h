@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_SCHEDULER_H
+#define NFCDC_SCHEDULER_H
+
+#include <nfcdc_types.h>
+
+/* This API exists since 1.3.0 */
+
+G_BEGIN_DECLS
+
+/*
+ * Tag transceive, ISO-DEP transmit and reset, tag property queries and
+ * peer connection requests are queued locally and submitted to nfcd
+ * when there's room for them in the window of calls in flight (one
+ * window per tag, shared with its ISO-DEP client, and one per peer).
+ * Higher priority calls get submitted first, calls of the same priority
+ * are submitted in order.
+ *
+ * The priority is passed with each call, see
+ * nfc_tag_client_transceive_with_priority() and
+ * nfc_isodep_client_transmit_with_priority(). Other calls are submitted
+ * with NFC_CALL_PRIORITY_DEFAULT, and the property queries with
+ * NFC_CALL_PRIORITY_BACKGROUND, so that they don't hold up the data
+ * exchange.
+ *
+ * By default the window is zero, which means no limit, i.e. everything
+ * is submitted right away and the priorities don't matter. Applications
+ * which want the calls to be scheduled have to set the window. While
+ * calls are waiting for their turn, the congested flag of the tag or
+ * peer is set, which can be used as a back-pressure signal.
+ */
+
+typedef enum nfc_call_priority {
+    NFC_CALL_PRIORITY_BACKGROUND,
+    NFC_CALL_PRIORITY_NORMAL,
+    NFC_CALL_PRIORITY_FOREGROUND,
+    NFC_CALL_PRIORITY_COUNT
+} NFC_CALL_PRIORITY;
+
+#define NFC_CALL_PRIORITY_DEFAULT NFC_CALL_PRIORITY_NORMAL
+
+void
+nfc_call_scheduler_set_window(
+    guint window);
+
+guint
+nfc_call_scheduler_window(
+    void);
+
+G_END_DECLS
+
+#endif /* NFCDC_SCHEDULER_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
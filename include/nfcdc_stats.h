@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_STATS_H
+#define NFCDC_STATS_H
+
+#include <nfcdc_types.h>
+
+/* This API exists since 1.3.0 */
+
+G_BEGIN_DECLS
+
+/*
+ * Latency histograms for the D-Bus calls issued by the library, broken
+ * down by adapter and operation. Calls made by the daemon client (and
+ * the mode/tech requests) are accounted under "/".
+ *
+ * Collection is off by default. Latencies are in microseconds, stored
+ * in log-linear buckets: each power of two is split into 4 linear
+ * sub-buckets, which keeps the relative error under 25%.
+ */
+
+typedef enum nfc_client_op {
+    NFC_CLIENT_OP_TRANSMIT,
+    NFC_CLIENT_OP_TRANSCEIVE,
+    NFC_CLIENT_OP_ACQUIRE,
+    NFC_CLIENT_OP_DAEMON_GET_ALL,
+    NFC_CLIENT_OP_DAEMON_GET_ALL2,
+    NFC_CLIENT_OP_DAEMON_GET_ALL3,
+    NFC_CLIENT_OP_DAEMON_GET_ALL4,
+    NFC_CLIENT_OP_ADAPTER_GET_ALL,
+    NFC_CLIENT_OP_ADAPTER_GET_ALL2,
+    NFC_CLIENT_OP_ADAPTER_GET_ALL3,
+    NFC_CLIENT_OP_ADAPTER_GET_ALL4,
+    NFC_CLIENT_OP_TAG_GET_ALL,
+    NFC_CLIENT_OP_TAG_GET_ALL3,
+    NFC_CLIENT_OP_ISODEP_GET_ALL,
+    NFC_CLIENT_OP_ISODEP_GET_ALL2,
+    NFC_CLIENT_OP_PEER_GET_ALL,
+    NFC_CLIENT_OP_REQUEST_MODE,
+    NFC_CLIENT_OP_RELEASE_MODE,
+    NFC_CLIENT_OP_REQUEST_TECHS,
+    NFC_CLIENT_OP_RELEASE_TECHS,
+    NFC_CLIENT_OP_COUNT
+} NFC_CLIENT_OP;
+
+#define NFC_CLIENT_STATS_BUCKETS (124)
+
+typedef struct nfc_client_stats_histogram {
+    guint64 count;
+    guint64 errors;
+    guint64 sum_us;
+    guint64 min_us;
+    guint64 max_us;
+    guint64 buckets[NFC_CLIENT_STATS_BUCKETS];
+} NfcClientStatsHistogram;
+
+void
+nfc_client_stats_set_enabled(
+    gboolean enabled);
+
+gboolean
+nfc_client_stats_enabled(
+    void);
+
+void
+nfc_client_stats_reset(
+    void);
+
+/* Paths of the adapters with any data collected, free with g_strfreev() */
+char**
+nfc_client_stats_adapters(
+    void)
+    G_GNUC_WARN_UNUSED_RESULT;
+
+/* Copies the histogram, returns FALSE if nothing has been collected */
+gboolean
+nfc_client_stats_get(
+    const char* adapter,
+    NFC_CLIENT_OP op,
+    NfcClientStatsHistogram* histogram);
+
+const char*
+nfc_client_stats_op_name(
+    NFC_CLIENT_OP op);
+
+guint64
+nfc_client_stats_bucket_min(
+    guint bucket);
+
+/* Lower bound of the bucket containing the given percentile */
+guint64
+nfc_client_stats_percentile(
+    const NfcClientStatsHistogram* histogram,
+    double percent);
+
+/*
+ * Number of client objects currently alive, i.e. registered in the
+ * per-path lookup tables. Always available, doesn't depend on whether
+ * stats collection is enabled. Meant for leak checks.
+ */
+
+typedef enum nfc_client_object {
+    NFC_CLIENT_OBJECT_ADAPTER,
+    NFC_CLIENT_OBJECT_TAG,
+    NFC_CLIENT_OBJECT_ISODEP,
+    NFC_CLIENT_OBJECT_PEER,
+    NFC_CLIENT_OBJECT_COUNT
+} NFC_CLIENT_OBJECT;
+
+guint
+nfc_client_stats_live_objects(
+    NFC_CLIENT_OBJECT type);
+
+G_END_DECLS
+
+#endif /* NFCDC_STATS_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
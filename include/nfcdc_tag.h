@@ -40,7 +40,7 @@
 #ifndef NFCDC_TAG_H
 #define NFCDC_TAG_H
 
-#include <nfcdc_types.h>
+#include <nfcdc_scheduler.h>
 
 #include <gio/gio.h>
 
@@ -57,6 +57,10 @@ typedef enum nfc_tag_property {
     NFC_TAG_PROPERTY_NDEF_RECORDS,
     /* Since 1.1.0 */
     NFC_TAG_PROPERTY_TECHNOLOGY,
+    /* Since 1.3.0 */
+    NFC_TAG_PROPERTY_CONGESTED,
+    NFC_TAG_PROPERTY_RETRYING,
+    NFC_TAG_PROPERTY_POLL_PARAMS,
     /* Moving target: */
     NFC_TAG_PROPERTY_COUNT
 } NFC_TAG_PROPERTY;
@@ -80,10 +84,11 @@ struct nfc_tag_client {
     const GStrV* ndef_records;
     /* Since 1.1.0 */
     NFC_TECH technology;
+    /* Since 1.3.0 */
+    gboolean congested;   /* Calls are waiting for their turn */
+    gboolean retrying;    /* Initialization will be retried */
 };
 
-typedef struct nfc_tag_client_lock NfcTagClientLock;
-
 typedef
 void
 (*NfcTagClientCallFunc)(
@@ -118,6 +123,23 @@ NfcTagClient*
 nfc_tag_client_new(
     const char* path);
 
+/*
+ * Lite client fetches only the basics at startup. Interfaces, NDEF
+ * records, technology and poll parameters get fetched when a handler
+ * for the respective property is registered (NFC_TAG_PROPERTY_ANY covers
+ * all of them), poll parameters also on the first
+ * nfc_tag_client_poll_param() call. Until then those remain empty. The
+ * property handler gets invoked when the value arrives. If the fetch
+ * fails, it's repeated on the next request.
+ *
+ * nfc_tag_client_new() for the same path turns the lite client into
+ * a normal one, which remains invalid until all the properties have
+ * been fetched.
+ */
+NfcTagClient*
+nfc_tag_client_new_lite(
+    const char* path); /* Since 1.3.0 */
+
 NfcTagClient*
 nfc_tag_client_ref(
     NfcTagClient* tag);
@@ -139,6 +161,30 @@ nfc_tag_client_acquire_lock(
     void* user_data,
     GDestroyNotify destroy);
 
+/*
+ * The deadline is an absolute g_get_monotonic_time() value, zero means
+ * no deadline. If the deadline expires before the call completes, the
+ * callback gets invoked with G_IO_ERROR_TIMED_OUT right away and the
+ * operation gets aborted: the lock is released as soon as it arrives,
+ * the tag with the stuck transfer gets deactivated. If the deadline has
+ * already expired, the call fails immediately (returns FALSE).
+ */
+gboolean
+nfc_tag_client_acquire_lock_with_deadline(
+    NfcTagClient* tag,
+    gboolean wait,
+    gint64 deadline,
+    GCancellable* cancel,
+    NfcTagClientLockFunc callback,
+    void* user_data,
+    GDestroyNotify destroy); /* Since 1.3.0 */
+
+/*
+ * Lite client may return NULL until the poll parameters have arrived,
+ * which is signaled by NFC_TAG_PROPERTY_POLL_PARAMS (since 1.3.0).
+ * They are never available if nfcd implements org.sailfishos.nfc.Tag
+ * interface older than version 3.
+ */
 const GUtilData*
 nfc_tag_client_poll_param(
     NfcTagClient* tag,
@@ -161,6 +207,31 @@ nfc_tag_client_transceive(
     void* user_data,
     GDestroyNotify destroy); /* Since 1.2.1 */
 
+gboolean
+nfc_tag_client_transceive_with_deadline(
+    NfcTagClient* tag,
+    const GUtilData* data,
+    gint64 deadline,
+    GCancellable* cancel,
+    NfcTagTransceiveFunc complete,
+    void* user_data,
+    GDestroyNotify destroy); /* Since 1.3.0 */
+
+/*
+ * Same as nfc_tag_client_transceive_with_deadline() but the call gets
+ * queued with the specified priority. Zero deadline means no deadline.
+ */
+gboolean
+nfc_tag_client_transceive_with_priority(
+    NfcTagClient* tag,
+    const GUtilData* data,
+    NFC_CALL_PRIORITY priority,
+    gint64 deadline,
+    GCancellable* cancel,
+    NfcTagTransceiveFunc complete,
+    void* user_data,
+    GDestroyNotify destroy); /* Since 1.3.0 */
+
 gulong
 nfc_tag_client_add_property_handler(
     NfcTagClient* tag,
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_TARGET_MONITOR_H
+#define NFCDC_TARGET_MONITOR_H
+
+#include <nfcdc_types.h>
+
+/* This API exists since 1.3.0 */
+
+G_BEGIN_DECLS
+
+/*
+ * NfcTargetMonitor reports tags and peers appearing and disappearing
+ * on all adapters. It listens to the adapter signals connection-wide
+ * and doesn't create any adapter, tag or peer clients, which makes it
+ * cheap enough for logging and statistics.
+ *
+ * Targets which are already present when the monitor starts (or when
+ * nfcd restarts) are not reported as arrivals, the monitor becomes
+ * valid once it knows what's present. Once it's valid, those can be
+ * enumerated with nfc_target_monitor_foreach(). Everything disappears
+ * when nfcd leaves the bus.
+ *
+ * While there are tag-identified handlers, the monitor also queries
+ * the UID and technology of each arriving tag, right when TagsChanged
+ * is received and before the arrival is reported. The result comes as
+ * NFC_TARGET_TAG_IDENTIFIED event, normally well before NfcTagClient
+ * for the same tag would become valid. That's meant for access control
+ * and such, where the UID is all that's needed. Tags found present at
+ * startup (or after nfcd restart) are identified too, provided that
+ * the handlers are already there by then. Otherwise, identification
+ * can be requested with nfc_target_monitor_identify_tag().
+ */
+
+typedef enum nfc_target_monitor_property {
+    NFC_TARGET_MONITOR_PROPERTY_ANY,
+    NFC_TARGET_MONITOR_PROPERTY_VALID,
+    NFC_TARGET_MONITOR_PROPERTY_COUNT
+} NFC_TARGET_MONITOR_PROPERTY;
+
+typedef enum nfc_target_event_type {
+    NFC_TARGET_TAG_ARRIVED,
+    NFC_TARGET_TAG_LEFT,
+    NFC_TARGET_PEER_ARRIVED,
+    NFC_TARGET_PEER_LEFT,
+    NFC_TARGET_TAG_IDENTIFIED
+} NFC_TARGET_EVENT_TYPE;
+
+typedef struct nfc_target_event {
+    NFC_TARGET_EVENT_TYPE type;
+    const char* adapter;        /* Adapter path */
+    const char* path;           /* Tag or peer path */
+    gint64 time;                /* Monotonic time of the D-Bus signal */
+    /* NFC_TARGET_TAG_IDENTIFIED only: */
+    NFC_TECH technology;        /* NFC_TECH_NONE if unknown */
+    const GUtilData* uid;       /* NFCID1 or NFCID0, NULL if unknown */
+} NfcTargetEvent;
+
+struct nfc_target_monitor {
+    gboolean valid;
+};
+
+typedef
+void
+(*NfcTargetMonitorPropertyFunc)(
+    NfcTargetMonitor* monitor,
+    NFC_TARGET_MONITOR_PROPERTY property,
+    void* user_data);
+
+typedef
+void
+(*NfcTargetMonitorEventFunc)(
+    NfcTargetMonitor* monitor,
+    const NfcTargetEvent* event,
+    void* user_data);
+
+NfcTargetMonitor*
+nfc_target_monitor_new(
+    void);
+
+NfcTargetMonitor*
+nfc_target_monitor_ref(
+    NfcTargetMonitor* monitor);
+
+void
+nfc_target_monitor_unref(
+    NfcTargetMonitor* monitor);
+
+/*
+ * Invokes the callback for each tag and peer currently present, with
+ * NFC_TARGET_TAG_ARRIVED or NFC_TARGET_PEER_ARRIVED event and zero time.
+ */
+void
+nfc_target_monitor_foreach(
+    NfcTargetMonitor* monitor,
+    NfcTargetMonitorEventFunc callback,
+    void* user_data);
+
+/*
+ * Queries the UID of the tag which is currently present. The result is
+ * delivered to tag-identified handlers. Returns FALSE if there's no such
+ * tag.
+ */
+gboolean
+nfc_target_monitor_identify_tag(
+    NfcTargetMonitor* monitor,
+    const char* path);
+
+gulong
+nfc_target_monitor_add_property_handler(
+    NfcTargetMonitor* monitor,
+    NFC_TARGET_MONITOR_PROPERTY property,
+    NfcTargetMonitorPropertyFunc callback,
+    void* user_data);
+
+gulong
+nfc_target_monitor_add_event_handler(
+    NfcTargetMonitor* monitor,
+    NfcTargetMonitorEventFunc callback,
+    void* user_data);
+
+gulong
+nfc_target_monitor_add_tag_identified_handler(
+    NfcTargetMonitor* monitor,
+    NfcTargetMonitorEventFunc callback,
+    void* user_data);
+
+void
+nfc_target_monitor_remove_handler(
+    NfcTargetMonitor* monitor,
+    gulong id);
+
+void
+nfc_target_monitor_remove_handlers(
+    NfcTargetMonitor* monitor,
+    gulong* ids,
+    guint count);
+
+#define nfc_target_monitor_remove_all_handlers(monitor, ids) \
+    nfc_target_monitor_remove_handlers(monitor, ids, G_N_ELEMENTS(ids))
+
+G_END_DECLS
+
+#endif /* NFCDC_TARGET_MONITOR_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
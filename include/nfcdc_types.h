@@ -49,15 +49,21 @@ G_BEGIN_DECLS
 #define NFCDC_LOG_MODULE nfcdc_log
 
 typedef struct nfc_adapter_client NfcAdapterClient;
+typedef struct nfc_adapter_pool NfcAdapterPool; /* Since 1.3.0 */
 typedef struct nfc_daemon_client NfcDaemonClient;
 typedef struct nfc_default_adapter NfcDefaultAdapter;
+typedef struct nfc_host_request NfcHostRequest; /* Since 1.3.0 */
+typedef struct nfc_host_service NfcHostService; /* Since 1.3.0 */
 typedef struct nfc_isodep_apdu NfcIsoDepApdu;
 typedef struct nfc_isodep_client NfcIsoDepClient;
 typedef struct nfc_mode_request NfcModeRequest; /* Since 1.0.6 */
 typedef struct nfc_service_connection NfcServiceConnection;  /* Since 1.0.6 */
 typedef struct nfc_peer_client NfcPeerClient; /* Since 1.0.6 */
 typedef struct nfc_peer_service NfcPeerService; /* Since 1.0.6 */
+typedef struct nfc_peer_stream NfcPeerStream; /* Since 1.3.0 */
 typedef struct nfc_tag_client NfcTagClient;
+typedef struct nfc_tag_client_lock NfcTagClientLock;
+typedef struct nfc_target_monitor NfcTargetMonitor; /* Since 1.3.0 */
 typedef struct nfc_tech_request NfcTechRequest; /* Since 1.1.0 */
 
 typedef enum nfc_daemon_mode {
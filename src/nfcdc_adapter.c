@@ -42,6 +42,10 @@
 #include "nfcdc_daemon_p.h"
 #include "nfcdc_dbus.h"
 #include "nfcdc_log.h"
+#include "nfcdc_resync_p.h"
+#include "nfcdc_retry_p.h"
+#include "nfcdc_stats_p.h"
+#include "nfcdc_trace_p.h"
 
 #include <gutil_macros.h>
 #include <gutil_misc.h>
@@ -82,6 +86,10 @@ typedef struct nfc_adapter_client_object {
     OrgSailfishosNfcAdapter* proxy;
     gulong proxy_signal_id[PROXY_SIGNAL_COUNT];
     gboolean proxy_initializing;
+    gint64 get_all_start;
+    GSList* param_reqs;
+    NfcResync* resync;
+    NfcClientRetry retry;
 } NfcAdapterClientObject;
 
 #define PARENT_CLASS nfc_adapter_client_object_parent_class
@@ -141,6 +149,15 @@ nfc_adapter_client_object_cast(
         NULL;
 }
 
+static
+void
+nfc_adapter_client_init_done(
+    NfcAdapterClientObject* self)
+{
+    self->proxy_initializing = FALSE;
+    nfc_resync_done(&self->resync);
+}
+
 static
 void
 nfc_adapter_client_update_tags(
@@ -231,6 +248,20 @@ nfc_adapter_client_update_hosts(
     g_strfreev(take_hosts);
 }
 
+static
+void
+nfc_adapter_client_set_retrying(
+    NfcAdapterClientObject* self,
+    gboolean retrying)
+{
+    NfcAdapterClient* adapter = &self->pub;
+
+    if (adapter->retrying != retrying) {
+        adapter->retrying = retrying;
+        nfc_adapter_client_queue_signal(self, RETRYING);
+    }
+}
+
 static
 void
 nfc_adapter_client_update_valid_and_present(
@@ -256,6 +287,11 @@ nfc_adapter_client_update_valid_and_present(
         adapter->present = present;
         nfc_adapter_client_queue_signal(self, PRESENT);
     }
+    if (self->proxy && !self->proxy_initializing) {
+        /* Successfully initialized */
+        nfc_client_retry_reset(&self->retry);
+        nfc_adapter_client_set_retrying(self, FALSE);
+    }
 }
 
 static
@@ -401,8 +437,19 @@ nfc_adapter_client_drop_proxy(
         adapter->present = FALSE;
         nfc_adapter_client_queue_signal(self, PRESENT);
     }
-    nfc_adapter_client_init_finished(self, FALSE, FALSE, NFC_MODE_NONE,
-        NFC_MODE_NONE, FALSE, NULL, NULL, NULL, NFC_TECH_NONE, NULL);
+    if (self->daemon->present) {
+        nfc_adapter_client_init_finished(self, FALSE, FALSE, NFC_MODE_NONE,
+            NFC_MODE_NONE, FALSE, NULL, NULL, NULL, NFC_TECH_NONE, NULL);
+    } else {
+        /*
+         * The daemon is gone, most likely restarting. Keep the adapter
+         * settings so that after resync only the actual changes get
+         * signaled. Targets don't survive the restart though.
+         */
+        nfc_adapter_client_init_finished(self, adapter->enabled,
+            adapter->powered, adapter->supported_modes, adapter->mode,
+            FALSE, NULL, NULL, NULL, adapter->supported_techs, NULL);
+    }
 }
 
 static
@@ -417,11 +464,35 @@ nfc_adapter_client_update(
             nfc_adapter_client_reinit(self);
         }
     } else if (!self->proxy_initializing) {
+        nfc_client_retry_reset(&self->retry);
+        nfc_adapter_client_set_retrying(self, FALSE);
         nfc_adapter_client_drop_proxy(self);
     }
     nfc_adapter_client_update_valid_and_present(self);
 }
 
+static
+void
+nfc_adapter_client_retry(
+    GObject* object)
+{
+    NfcAdapterClientObject* self = THIS(object);
+
+    nfc_adapter_client_update(self);
+    nfc_adapter_client_emit_queued_signals(self);
+}
+
+static
+void
+nfc_adapter_client_init_failed(
+    NfcAdapterClientObject* self)
+{
+    nfc_adapter_client_drop_proxy(self);
+    nfc_adapter_client_set_retrying(self,
+        nfc_client_retry_schedule(&self->retry, G_OBJECT(self),
+            nfc_adapter_client_retry));
+}
+
 static
 void
 nfc_adapter_client_daemon_changed(
@@ -574,6 +645,7 @@ nfc_adapter_client_get_all4_done(
 {
     NfcAdapterClientObject* self = THIS(user_data);
     GError* error = NULL;
+    gboolean ok;
     gint version;
     guint supported_modes, mode, supported_techs;
     gboolean enabled, powered, target_present;
@@ -583,10 +655,15 @@ nfc_adapter_client_get_all4_done(
     GVariant* params;
 
     GASSERT(self->proxy_initializing);
-    self->proxy_initializing = FALSE;
-    if (org_sailfishos_nfc_adapter_call_get_all4_finish(self->proxy, &version,
+    nfc_adapter_client_init_done(self);
+    ok = org_sailfishos_nfc_adapter_call_get_all4_finish(self->proxy, &version,
         &enabled, &powered, &supported_modes, &mode, &target_present, &tags,
-        &peers, &hosts, &supported_techs, &params, result, &error)) {
+        &peers, &hosts, &supported_techs, &params, result, &error);
+    nfc_client_stats_finish(self->pub.path, NFC_CLIENT_OP_ADAPTER_GET_ALL4,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, self->pub.path,
+        NFC_CLIENT_OP_ADAPTER_GET_ALL4, ok);
+    if (ok) {
         GASSERT(self->pub.version == version);
         GDEBUG("%s: Modes = 0x%02x", self->name, supported_modes);
         GDEBUG("%s: Techs = 0x%02x", self->name, supported_techs);
@@ -598,8 +675,7 @@ nfc_adapter_client_get_all4_done(
     } else {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
-        /* Need to retry? */
-        nfc_adapter_client_drop_proxy(self);
+        nfc_adapter_client_init_failed(self);
     }
     nfc_adapter_client_update_valid_and_present(self);
     nfc_adapter_client_emit_queued_signals(self);
@@ -615,6 +691,7 @@ nfc_adapter_client_get_all3_done(
 {
     NfcAdapterClientObject* self = THIS(user_data);
     GError* error = NULL;
+    gboolean ok;
     gint version;
     guint supported_modes, mode, supported_techs;
     gboolean enabled, powered, target_present;
@@ -623,10 +700,15 @@ nfc_adapter_client_get_all3_done(
     gchar** hosts;
 
     GASSERT(self->proxy_initializing);
-    self->proxy_initializing = FALSE;
-    if (org_sailfishos_nfc_adapter_call_get_all3_finish(self->proxy, &version,
+    nfc_adapter_client_init_done(self);
+    ok = org_sailfishos_nfc_adapter_call_get_all3_finish(self->proxy, &version,
         &enabled, &powered, &supported_modes, &mode, &target_present, &tags,
-        &peers, &hosts, &supported_techs, result, &error)) {
+        &peers, &hosts, &supported_techs, result, &error);
+    nfc_client_stats_finish(self->pub.path, NFC_CLIENT_OP_ADAPTER_GET_ALL3,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, self->pub.path,
+        NFC_CLIENT_OP_ADAPTER_GET_ALL3, ok);
+    if (ok) {
         GASSERT(self->pub.version == version);
         GDEBUG("%s: Modes = 0x%02x", self->name, supported_modes);
         GDEBUG("%s: Techs = 0x%02x", self->name, supported_techs);
@@ -637,8 +719,7 @@ nfc_adapter_client_get_all3_done(
     } else {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
-        /* Need to retry? */
-        nfc_adapter_client_drop_proxy(self);
+        nfc_adapter_client_init_failed(self);
     }
     nfc_adapter_client_update_valid_and_present(self);
     nfc_adapter_client_emit_queued_signals(self);
@@ -654,6 +735,7 @@ nfc_adapter_client_get_all2_done(
 {
     NfcAdapterClientObject* self = THIS(user_data);
     GError* error = NULL;
+    gboolean ok;
     gint version;
     guint supported_modes, mode;
     gboolean enabled, powered, target_present;
@@ -661,10 +743,15 @@ nfc_adapter_client_get_all2_done(
     gchar** peers;
 
     GASSERT(self->proxy_initializing);
-    self->proxy_initializing = FALSE;
-    if (org_sailfishos_nfc_adapter_call_get_all2_finish(self->proxy, &version,
+    nfc_adapter_client_init_done(self);
+    ok = org_sailfishos_nfc_adapter_call_get_all2_finish(self->proxy, &version,
         &enabled, &powered, &supported_modes, &mode, &target_present, &tags,
-        &peers, result, &error)) {
+        &peers, result, &error);
+    nfc_client_stats_finish(self->pub.path, NFC_CLIENT_OP_ADAPTER_GET_ALL2,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, self->pub.path,
+        NFC_CLIENT_OP_ADAPTER_GET_ALL2, ok);
+    if (ok) {
         GASSERT(self->pub.version == version);
         GDEBUG("%s: Modes = 0x%02x", self->name, supported_modes);
         /* Passing ownership of tags and peers to self */
@@ -674,8 +761,7 @@ nfc_adapter_client_get_all2_done(
     } else {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
-        /* Need to retry? */
-        nfc_adapter_client_drop_proxy(self);
+        nfc_adapter_client_init_failed(self);
     }
     nfc_adapter_client_update_valid_and_present(self);
     nfc_adapter_client_emit_queued_signals(self);
@@ -691,16 +777,22 @@ nfc_adapter_client_get_all_done(
 {
     NfcAdapterClientObject* self = THIS(user_data);
     GError* error = NULL;
+    gboolean ok;
     gint version;
     guint supported_modes, mode;
     gboolean enabled, powered, target_present;
     gchar** tags;
 
     GASSERT(self->proxy_initializing);
-    self->proxy_initializing = FALSE;
-    if (org_sailfishos_nfc_adapter_call_get_all_finish(self->proxy, &version,
+    nfc_adapter_client_init_done(self);
+    ok = org_sailfishos_nfc_adapter_call_get_all_finish(self->proxy, &version,
         &enabled, &powered, &supported_modes, &mode, &target_present, &tags,
-        result, &error)) {
+        result, &error);
+    nfc_client_stats_finish(self->pub.path, NFC_CLIENT_OP_ADAPTER_GET_ALL,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, self->pub.path,
+        NFC_CLIENT_OP_ADAPTER_GET_ALL, ok);
+    if (ok) {
         GASSERT(self->pub.version == version);
         /* Passing ownership of tags to self */
         nfc_adapter_client_init_finished(self, enabled, powered,
@@ -709,8 +801,7 @@ nfc_adapter_client_get_all_done(
     } else {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
-        /* Need to retry? */
-        nfc_adapter_client_drop_proxy(self);
+        nfc_adapter_client_init_failed(self);
     }
     nfc_adapter_client_update_valid_and_present(self);
     nfc_adapter_client_emit_queued_signals(self);
@@ -733,23 +824,35 @@ nfc_adapter_client_get_interface_version_done(
         GDEBUG("org.sailfishos.nfc.Adapter v%d", adapter->version);
         GASSERT(self->proxy_initializing);
         if (adapter->version >= 4) {
+            self->get_all_start = nfc_client_stats_start();
+            NFCDC_TRACE2(init__start, self->pub.path,
+                NFC_CLIENT_OP_ADAPTER_GET_ALL4);
             org_sailfishos_nfc_adapter_call_get_all4(self->proxy, NULL,
                 nfc_adapter_client_get_all4_done, g_object_ref(self));
         } else if (adapter->version >= 3) {
+            self->get_all_start = nfc_client_stats_start();
+            NFCDC_TRACE2(init__start, self->pub.path,
+                NFC_CLIENT_OP_ADAPTER_GET_ALL3);
             org_sailfishos_nfc_adapter_call_get_all3(self->proxy, NULL,
                 nfc_adapter_client_get_all3_done, g_object_ref(self));
         } else if (adapter->version >= 2) {
+            self->get_all_start = nfc_client_stats_start();
+            NFCDC_TRACE2(init__start, self->pub.path,
+                NFC_CLIENT_OP_ADAPTER_GET_ALL2);
             org_sailfishos_nfc_adapter_call_get_all2(self->proxy, NULL,
                 nfc_adapter_client_get_all2_done, g_object_ref(self));
         } else {
+            self->get_all_start = nfc_client_stats_start();
+            NFCDC_TRACE2(init__start, self->pub.path,
+                NFC_CLIENT_OP_ADAPTER_GET_ALL);
             org_sailfishos_nfc_adapter_call_get_all(self->proxy, NULL,
                 nfc_adapter_client_get_all_done, g_object_ref(self));
         }
     } else {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
-        /* Need to retry? */
-        nfc_adapter_client_drop_proxy(self);
+        nfc_adapter_client_init_done(self);
+        nfc_adapter_client_init_failed(self);
     }
     nfc_adapter_client_update_valid_and_present(self);
     nfc_adapter_client_emit_queued_signals(self);
@@ -800,7 +903,8 @@ nfc_adapter_client_init_2(
     } else {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
-        self->proxy_initializing = FALSE;
+        nfc_adapter_client_init_done(self);
+        nfc_adapter_client_init_failed(self);
         nfc_adapter_client_update_valid_and_present(self);
         nfc_adapter_client_emit_queued_signals(self);
     }
@@ -818,6 +922,14 @@ nfc_adapter_client_init_1(
 }
 
 
+static
+void
+nfc_adapter_client_resync(
+    GObject* object)
+{
+    nfc_adapter_client_init_1(THIS(object));
+}
+
 static
 void
 nfc_adapter_client_reinit(
@@ -825,7 +937,8 @@ nfc_adapter_client_reinit(
 {
     GASSERT(!self->proxy_initializing);
     self->proxy_initializing = TRUE;
-    nfc_adapter_client_init_1(self);
+    nfc_resync_submit(&self->resync, G_OBJECT(self),
+        nfc_adapter_client_resync);
 }
 
 /*==========================================================================*
@@ -849,6 +962,9 @@ nfc_adapter_param_req_unref(
     NfcAdapterParamReq* req)
 {
     if (G_LIKELY(req) && g_atomic_int_dec_and_test(&req->ref_count)) {
+        req->client->param_reqs = g_slist_remove(req->client->param_reqs,
+            req);
+        nfc_adapter_client_remove_handler(&req->client->pub, req->valid_id);
         if (req->id && req->client->proxy) {
             GDEBUG("%s: Releasing param req %u", req->client->name, req->id);
             org_sailfishos_nfc_adapter_call_release_params(req->client->proxy,
@@ -927,12 +1043,26 @@ nfc_adapter_param_req_alloc(
     GVariant* params)
 {
     NfcAdapterClientObject* client = nfc_adapter_client_object_cast(adapter);
-    NfcAdapterParamReq* req = g_slice_new0(NfcAdapterParamReq);
+    NfcAdapterParamReq* req;
+    GSList* l;
+
+    /* Identical requests share the same daemon request */
+    g_variant_ref_sink(params);
+    for (l = client->param_reqs; l; l = l->next) {
+        req = l->data;
+        if (req->reset == reset && g_variant_equal(req->params, params)) {
+            GDEBUG("%s: Sharing param req %u", client->name, req->id);
+            g_variant_unref(params);
+            return nfc_adapter_param_req_ref(req);
+        }
+    }
 
+    req = g_slice_new0(NfcAdapterParamReq);
     g_atomic_int_set(&req->ref_count, 1);
     g_object_ref(req->client = client);
     req->reset = reset;
-    req->params = g_variant_ref_sink(params);
+    req->params = params;
+    client->param_reqs = g_slist_prepend(client->param_reqs, req);
     req->valid_id = nfc_adapter_client_add_property_handler(adapter,
         NFC_ADAPTER_PROPERTY_VALID, nfc_adapter_param_req_update_valid, req);
     if (adapter->valid) {
@@ -978,6 +1108,14 @@ nfc_adapter_client_connection(
     return G_LIKELY(self) ? self->connection : NULL;
 }
 
+guint
+nfc_adapter_client_count(
+    void)
+{
+    return nfc_adapter_client_table ?
+        g_hash_table_size(nfc_adapter_client_table) : 0;
+}
+
 /*==========================================================================*
  * API
  *==========================================================================*/
@@ -1145,6 +1283,7 @@ nfc_adapter_client_object_finalize(
     NfcAdapterClient* adapter = &self->pub;
 
     GVERBOSE_("%s", adapter->path);
+    nfc_client_retry_reset(&self->retry);
     nfc_adapter_client_drop_proxy(self);
     nfc_daemon_client_remove_all_handlers(self->daemon, self->daemon_event_id);
     nfc_daemon_client_unref(self->daemon);
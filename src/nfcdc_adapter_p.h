@@ -47,6 +47,12 @@ GDBusConnection*
 nfc_adapter_client_connection(
     NfcAdapterClient* adapter);
 
+/* Size of the object table, for nfc_client_stats_live_objects() */
+G_GNUC_INTERNAL
+guint
+nfc_adapter_client_count(
+    void);
+
 #endif /* NFCDC_ADAPTER_PRIVATE_H */
 
 /*
@@ -0,0 +1,854 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcdc_adapter_pool.h"
+#include "nfcdc_base.h"
+#include "nfcdc_daemon.h"
+#include "nfcdc_log.h"
+
+#include <gutil_macros.h>
+#include <gutil_misc.h>
+#include <gutil_strv.h>
+
+enum nfc_adapter_pool_daemon_signals {
+    DAEMON_VALID_CHANGED,
+    DAEMON_ADAPTERS_CHANGED,
+    DAEMON_SIGNAL_COUNT
+};
+
+typedef struct nfc_adapter_pool_slot {
+    NfcAdapterClient* adapter;
+    gulong adapter_event_id;
+    GStrV* tags;
+    GStrV* peers;
+    NfcAdapterPoolJob* job;
+    gint64 since;
+    gint64 job_start;
+    guint64 busy_time;
+    guint jobs;
+    guint tags_seen;
+} NfcAdapterPoolSlot;
+
+typedef struct nfc_adapter_pool_pending_event {
+    NFC_ADAPTER_POOL_EVENT type;
+    NfcAdapterClient* adapter;
+    char* path;
+} NfcAdapterPoolPendingEvent;
+
+typedef NfcClientBaseClass NfcAdapterPoolObjectClass;
+typedef struct nfc_adapter_pool_object {
+    NfcClientBase base;
+    NfcAdapterPool pub;
+    NfcDaemonClient* daemon;
+    gulong daemon_event_id[DAEMON_SIGNAL_COUNT];
+    GPtrArray* slots;
+    GSList* detached; /* Running jobs whose adapter has left the pool */
+    GQueue jobs;
+    GQueue events;
+    GStrV* adapters;
+    GStrV* tags;
+    GStrV* peers;
+    guint dispatch_id;
+    gboolean dispatching;
+} NfcAdapterPoolObject;
+
+struct nfc_adapter_pool_job {
+    NfcAdapterPoolObject* pool;
+    NfcAdapterClient* adapter;
+    NfcAdapterPoolJobFunc start;
+    GDestroyNotify destroy;
+    void* user_data;
+};
+
+typedef struct nfc_adapter_pool_closure {
+    GCClosure cclosure;
+    NfcAdapterPoolTargetFunc callback;
+    void* user_data;
+} NfcAdapterPoolClosure;
+
+#define nfc_adapter_pool_closure_new() ((NfcAdapterPoolClosure *) \
+    g_closure_new_simple(sizeof(NfcAdapterPoolClosure), NULL))
+
+#define PARENT_CLASS nfc_adapter_pool_object_parent_class
+#define THIS_TYPE nfc_adapter_pool_object_get_type()
+#define THIS(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, THIS_TYPE, \
+    NfcAdapterPoolObject)
+
+GType THIS_TYPE G_GNUC_INTERNAL;
+G_DEFINE_TYPE(NfcAdapterPoolObject, nfc_adapter_pool_object, \
+    NFC_CLIENT_TYPE_BASE)
+
+NFC_CLIENT_BASE_ASSERT_VALID(NFC_ADAPTER_POOL_PROPERTY_VALID);
+NFC_CLIENT_BASE_ASSERT_COUNT(NFC_ADAPTER_POOL_PROPERTY_COUNT);
+
+#define SIGNAL_BIT_(x) \
+    NFC_CLIENT_BASE_SIGNAL_BIT(NFC_ADAPTER_POOL_PROPERTY_##x)
+
+#define nfc_adapter_pool_emit_queued_signals(self) \
+    nfc_client_base_emit_queued_signals(&(self)->base)
+#define nfc_adapter_pool_queue_signal(self,NAME) \
+    ((self)->base.queued_signals |= SIGNAL_BIT_(NAME))
+
+#define SIGNAL_TAG_ARRIVED_NAME     "nfcdc-adapter-pool-tag-arrived"
+#define SIGNAL_TAG_LEFT_NAME        "nfcdc-adapter-pool-tag-left"
+#define SIGNAL_PEER_ARRIVED_NAME    "nfcdc-adapter-pool-peer-arrived"
+#define SIGNAL_PEER_LEFT_NAME       "nfcdc-adapter-pool-peer-left"
+
+static const char* nfc_adapter_pool_signal_names[] = {
+    SIGNAL_TAG_ARRIVED_NAME,
+    SIGNAL_TAG_LEFT_NAME,
+    SIGNAL_PEER_ARRIVED_NAME,
+    SIGNAL_PEER_LEFT_NAME
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(nfc_adapter_pool_signal_names) ==
+    NFC_ADAPTER_POOL_EVENT_COUNT);
+
+static guint nfc_adapter_pool_signals[NFC_ADAPTER_POOL_EVENT_COUNT];
+static char* nfc_adapter_pool_empty_strv = NULL;
+static NfcAdapterPoolObject* nfc_adapter_pool_instance = NULL;
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static inline
+NfcAdapterPoolObject*
+nfc_adapter_pool_object_cast(
+    NfcAdapterPool* pub)
+{
+    return G_LIKELY(pub) ?
+        THIS(G_CAST(pub, NfcAdapterPoolObject, pub)) :
+        NULL;
+}
+
+static
+void
+nfc_adapter_pool_target_event(
+    NfcAdapterPoolObject* self,
+    NfcAdapterClient* adapter,
+    const char* path,
+    NfcAdapterPoolClosure* closure)
+{
+    closure->callback(&self->pub, adapter, path, closure->user_data);
+}
+
+static
+void
+nfc_adapter_pool_queue_event(
+    NfcAdapterPoolObject* self,
+    NFC_ADAPTER_POOL_EVENT type,
+    NfcAdapterClient* adapter,
+    const char* path)
+{
+    NfcAdapterPoolPendingEvent* event =
+        g_slice_new(NfcAdapterPoolPendingEvent);
+
+    event->type = type;
+    event->adapter = nfc_adapter_client_ref(adapter);
+    event->path = g_strdup(path);
+    g_queue_push_tail(&self->events, event);
+}
+
+static
+void
+nfc_adapter_pool_pending_event_free(
+    NfcAdapterPoolPendingEvent* event)
+{
+    nfc_adapter_client_unref(event->adapter);
+    g_free(event->path);
+    gutil_slice_free(event);
+}
+
+static
+void
+nfc_adapter_pool_diff(
+    NfcAdapterPoolObject* self,
+    NfcAdapterClient* adapter,
+    GStrV** known,
+    const GStrV* present,
+    NFC_ADAPTER_POOL_EVENT arrived,
+    NFC_ADAPTER_POOL_EVENT left)
+{
+    const GStrV* ptr;
+
+    for (ptr = *known; ptr && *ptr; ptr++) {
+        if (!gutil_strv_contains(present, *ptr)) {
+            nfc_adapter_pool_queue_event(self, left, adapter, *ptr);
+        }
+    }
+    for (ptr = present; ptr && *ptr; ptr++) {
+        if (!gutil_strv_contains(*known, *ptr)) {
+            nfc_adapter_pool_queue_event(self, arrived, adapter, *ptr);
+        }
+    }
+    g_strfreev(*known);
+    *known = (present && present[0]) ? g_strdupv((char**)present) : NULL;
+}
+
+static
+void
+nfc_adapter_pool_slot_sync(
+    NfcAdapterPoolObject* self,
+    NfcAdapterPoolSlot* slot)
+{
+    NfcAdapterClient* adapter = slot->adapter;
+    const gboolean present = adapter->valid && adapter->present;
+    const guint n = self->events.length;
+
+    nfc_adapter_pool_diff(self, adapter, &slot->tags,
+        present ? adapter->tags : NULL,
+        NFC_ADAPTER_POOL_TAG_ARRIVED, NFC_ADAPTER_POOL_TAG_LEFT);
+    nfc_adapter_pool_diff(self, adapter, &slot->peers,
+        present ? adapter->peers : NULL,
+        NFC_ADAPTER_POOL_PEER_ARRIVED, NFC_ADAPTER_POOL_PEER_LEFT);
+    if (self->events.length > n) {
+        GList* l;
+
+        for (l = g_queue_peek_nth_link(&self->events, n); l; l = l->next) {
+            const NfcAdapterPoolPendingEvent* event = l->data;
+
+            if (event->type == NFC_ADAPTER_POOL_TAG_ARRIVED) {
+                slot->tags_seen++;
+            }
+        }
+    }
+}
+
+static
+void
+nfc_adapter_pool_slot_free(
+    NfcAdapterPoolObject* self,
+    NfcAdapterPoolSlot* slot)
+{
+    NfcAdapterClient* adapter = slot->adapter;
+
+    /* Whatever was present on this adapter is gone */
+    nfc_adapter_pool_diff(self, adapter, &slot->tags, NULL,
+        NFC_ADAPTER_POOL_TAG_ARRIVED, NFC_ADAPTER_POOL_TAG_LEFT);
+    nfc_adapter_pool_diff(self, adapter, &slot->peers, NULL,
+        NFC_ADAPTER_POOL_PEER_ARRIVED, NFC_ADAPTER_POOL_PEER_LEFT);
+    nfc_adapter_client_remove_handlers(adapter, &slot->adapter_event_id, 1);
+    nfc_adapter_client_unref(adapter);
+    gutil_slice_free(slot);
+}
+
+static
+NfcAdapterPoolSlot*
+nfc_adapter_pool_find_slot(
+    NfcAdapterPoolObject* self,
+    NfcAdapterClient* adapter)
+{
+    guint i;
+
+    for (i = 0; i < self->slots->len; i++) {
+        NfcAdapterPoolSlot* slot = self->slots->pdata[i];
+
+        if (slot->adapter == adapter) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static
+gboolean
+nfc_adapter_pool_slot_idle(
+    NfcAdapterPoolSlot* slot)
+{
+    NfcAdapterClient* adapter = slot->adapter;
+
+    return !slot->job && adapter->valid && adapter->present &&
+        adapter->enabled && adapter->powered;
+}
+
+static
+gboolean
+nfc_adapter_pool_update_list(
+    GStrV** list,
+    const GStrV** pub_list,
+    GStrV* value)
+{
+    if (!gutil_strv_equal(*pub_list, value)) {
+        g_strfreev(*list);
+        if (value) {
+            *pub_list = *list = value;
+        } else {
+            *list = NULL;
+            *pub_list = &nfc_adapter_pool_empty_strv;
+        }
+        return TRUE;
+    } else {
+        g_strfreev(value);
+        return FALSE;
+    }
+}
+
+static
+void
+nfc_adapter_pool_update(
+    NfcAdapterPoolObject* self)
+{
+    NfcAdapterPool* pub = &self->pub;
+    gboolean valid = self->daemon->valid;
+    GStrV* adapters = NULL;
+    GStrV* tags = NULL;
+    GStrV* peers = NULL;
+    guint i;
+
+    for (i = 0; i < self->slots->len; i++) {
+        NfcAdapterPoolSlot* slot = self->slots->pdata[i];
+        NfcAdapterClient* adapter = slot->adapter;
+        const GStrV* ptr;
+
+        if (!adapter->valid) {
+            valid = FALSE;
+        } else if (adapter->present) {
+            adapters = gutil_strv_add(adapters, adapter->path);
+        }
+        for (ptr = slot->tags; ptr && *ptr; ptr++) {
+            tags = gutil_strv_add(tags, *ptr);
+        }
+        for (ptr = slot->peers; ptr && *ptr; ptr++) {
+            peers = gutil_strv_add(peers, *ptr);
+        }
+    }
+    if (nfc_adapter_pool_update_list(&self->adapters, &pub->adapters,
+        adapters)) {
+        nfc_adapter_pool_queue_signal(self, ADAPTERS);
+    }
+    if (nfc_adapter_pool_update_list(&self->tags, &pub->tags, tags)) {
+        nfc_adapter_pool_queue_signal(self, TAGS);
+    }
+    if (nfc_adapter_pool_update_list(&self->peers, &pub->peers, peers)) {
+        nfc_adapter_pool_queue_signal(self, PEERS);
+    }
+    if (pub->valid != valid) {
+        pub->valid = valid;
+        nfc_adapter_pool_queue_signal(self, VALID);
+    }
+}
+
+static
+void
+nfc_adapter_pool_flush(
+    NfcAdapterPoolObject* self)
+{
+    NfcAdapterPoolPendingEvent* event;
+
+    /* Handlers could drop their references to us */
+    g_object_ref(self);
+    while ((event = g_queue_pop_head(&self->events)) != NULL) {
+        g_signal_emit(self, nfc_adapter_pool_signals[event->type], 0,
+            event->adapter, event->path);
+        nfc_adapter_pool_pending_event_free(event);
+    }
+    nfc_adapter_pool_emit_queued_signals(self);
+    g_object_unref(self);
+}
+
+static
+NfcAdapterPoolSlot*
+nfc_adapter_pool_pick_slot(
+    NfcAdapterPoolObject* self)
+{
+    NfcAdapterPoolSlot* best = NULL;
+    guint i;
+
+    /* The least busy idle adapter wins */
+    for (i = 0; i < self->slots->len; i++) {
+        NfcAdapterPoolSlot* slot = self->slots->pdata[i];
+
+        if (nfc_adapter_pool_slot_idle(slot) &&
+            (!best || slot->busy_time < best->busy_time)) {
+            best = slot;
+        }
+    }
+    return best;
+}
+
+static
+void
+nfc_adapter_pool_dispatch(
+    NfcAdapterPoolObject* self)
+{
+    /* Jobs may complete (and re-enter) right from their start callbacks */
+    if (!self->dispatching) {
+        NfcAdapterPool* pub = &self->pub;
+        NfcAdapterPoolSlot* slot;
+
+        g_object_ref(self);
+        self->dispatching = TRUE;
+        while (self->jobs.length &&
+            (slot = nfc_adapter_pool_pick_slot(self)) != NULL) {
+            NfcAdapterPoolJob* job = g_queue_pop_head(&self->jobs);
+
+            GDEBUG("Starting job on %s", slot->adapter->path);
+            slot->job = job;
+            slot->job_start = g_get_monotonic_time();
+            job->adapter = nfc_adapter_client_ref(slot->adapter);
+            pub->queued--;
+            pub->busy++;
+            nfc_adapter_pool_queue_signal(self, QUEUED);
+            nfc_adapter_pool_queue_signal(self, BUSY);
+            job->start(pub, job, job->adapter, job->user_data);
+        }
+        self->dispatching = FALSE;
+        nfc_adapter_pool_emit_queued_signals(self);
+        g_object_unref(self);
+    }
+}
+
+static
+gboolean
+nfc_adapter_pool_dispatch_cb(
+    gpointer user_data)
+{
+    NfcAdapterPoolObject* self = THIS(user_data);
+
+    self->dispatch_id = 0;
+    nfc_adapter_pool_dispatch(self);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+nfc_adapter_pool_adapter_changed(
+    NfcAdapterClient* adapter,
+    NFC_ADAPTER_PROPERTY property,
+    void* user_data)
+{
+    NfcAdapterPoolObject* self = THIS(user_data);
+    NfcAdapterPoolSlot* slot = nfc_adapter_pool_find_slot(self, adapter);
+
+    if (slot) {
+        nfc_adapter_pool_slot_sync(self, slot);
+        nfc_adapter_pool_update(self);
+        nfc_adapter_pool_flush(self);
+        nfc_adapter_pool_dispatch(self);
+    }
+}
+
+static
+void
+nfc_adapter_pool_attach_job(
+    NfcAdapterPoolObject* self,
+    NfcAdapterPoolSlot* slot)
+{
+    GSList* l;
+
+    /* The adapter remains busy until the job started on it is done */
+    for (l = self->detached; l; l = l->next) {
+        NfcAdapterPoolJob* job = l->data;
+
+        if (!strcmp(job->adapter->path, slot->adapter->path)) {
+            GDEBUG("Job on %s is still running", slot->adapter->path);
+            self->detached = g_slist_delete_link(self->detached, l);
+            slot->job = job;
+            slot->job_start = g_get_monotonic_time();
+            break;
+        }
+    }
+}
+
+static
+void
+nfc_adapter_pool_check_adapters(
+    NfcAdapterPoolObject* self)
+{
+    const GStrV* paths = self->daemon->adapters;
+    GPtrArray* slots = g_ptr_array_new();
+    GPtrArray* old = self->slots;
+    const GStrV* ptr;
+    guint i;
+
+    for (ptr = paths; ptr && *ptr; ptr++) {
+        const char* path = *ptr;
+        NfcAdapterPoolSlot* slot = NULL;
+
+        for (i = 0; i < old->len && !slot; i++) {
+            NfcAdapterPoolSlot* s = old->pdata[i];
+
+            if (!strcmp(s->adapter->path, path)) {
+                g_ptr_array_remove_index(old, i);
+                slot = s;
+            }
+        }
+        if (!slot) {
+            GDEBUG("Adapter %s joined the pool", path + 1);
+            slot = g_slice_new0(NfcAdapterPoolSlot);
+            slot->since = g_get_monotonic_time();
+            slot->adapter = nfc_adapter_client_new(path);
+            slot->adapter_event_id =
+                nfc_adapter_client_add_property_handler(slot->adapter,
+                    NFC_ADAPTER_PROPERTY_ANY,
+                    nfc_adapter_pool_adapter_changed, self);
+            nfc_adapter_pool_slot_sync(self, slot);
+            nfc_adapter_pool_attach_job(self, slot);
+        }
+        g_ptr_array_add(slots, slot);
+    }
+
+    /* Whatever is left in the old array is gone */
+    for (i = 0; i < old->len; i++) {
+        NfcAdapterPoolSlot* slot = old->pdata[i];
+
+        GDEBUG("Adapter %s left the pool", slot->adapter->path + 1);
+        if (slot->job) {
+            /* It may come back before the job is done */
+            self->detached = g_slist_prepend(self->detached, slot->job);
+        }
+        nfc_adapter_pool_slot_free(self, slot);
+    }
+    g_ptr_array_free(old, TRUE);
+    self->slots = slots;
+    nfc_adapter_pool_update(self);
+}
+
+static
+void
+nfc_adapter_pool_daemon_valid_changed(
+    NfcDaemonClient* daemon,
+    NFC_DAEMON_PROPERTY property,
+    void* user_data)
+{
+    NfcAdapterPoolObject* self = THIS(user_data);
+
+    nfc_adapter_pool_update(self);
+    nfc_adapter_pool_flush(self);
+}
+
+static
+void
+nfc_adapter_pool_daemon_adapters_changed(
+    NfcDaemonClient* daemon,
+    NFC_DAEMON_PROPERTY property,
+    void* user_data)
+{
+    NfcAdapterPoolObject* self = THIS(user_data);
+
+    nfc_adapter_pool_check_adapters(self);
+    nfc_adapter_pool_flush(self);
+    nfc_adapter_pool_dispatch(self);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+NfcAdapterPool*
+nfc_adapter_pool_new()
+{
+    if (nfc_adapter_pool_instance) {
+        g_object_ref(nfc_adapter_pool_instance);
+    } else {
+        nfc_adapter_pool_instance = g_object_new(THIS_TYPE, NULL);
+    }
+    return &nfc_adapter_pool_instance->pub;
+}
+
+NfcAdapterPool*
+nfc_adapter_pool_ref(
+    NfcAdapterPool* pool)
+{
+    gutil_object_ref(nfc_adapter_pool_object_cast(pool));
+    return pool;
+}
+
+void
+nfc_adapter_pool_unref(
+    NfcAdapterPool* pool)
+{
+    gutil_object_unref(nfc_adapter_pool_object_cast(pool));
+}
+
+gboolean
+nfc_adapter_pool_get_stats(
+    NfcAdapterPool* pool,
+    const char* adapter_path,
+    NfcAdapterPoolStats* stats)
+{
+    NfcAdapterPoolObject* self = nfc_adapter_pool_object_cast(pool);
+
+    if (G_LIKELY(self) && G_LIKELY(adapter_path) && G_LIKELY(stats)) {
+        guint i;
+
+        for (i = 0; i < self->slots->len; i++) {
+            const NfcAdapterPoolSlot* slot = self->slots->pdata[i];
+
+            if (!strcmp(slot->adapter->path, adapter_path)) {
+                const gint64 now = g_get_monotonic_time();
+
+                memset(stats, 0, sizeof(*stats));
+                stats->tracked_time = now - slot->since;
+                stats->busy_time = slot->busy_time;
+                stats->jobs = slot->jobs;
+                stats->tags = slot->tags_seen;
+                if (slot->job) {
+                    stats->busy_time += now - slot->job_start;
+                    stats->busy = TRUE;
+                }
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+gulong
+nfc_adapter_pool_add_property_handler(
+    NfcAdapterPool* pool,
+    NFC_ADAPTER_POOL_PROPERTY property,
+    NfcAdapterPoolPropertyFunc callback,
+    void* user_data)
+{
+    NfcAdapterPoolObject* self = nfc_adapter_pool_object_cast(pool);
+
+    return G_LIKELY(self) ? nfc_client_base_add_property_handler(&self->base,
+        property, (NfcClientBasePropertyFunc) callback, user_data) : 0;
+}
+
+gulong
+nfc_adapter_pool_add_target_handler(
+    NfcAdapterPool* pool,
+    NFC_ADAPTER_POOL_EVENT event,
+    NfcAdapterPoolTargetFunc callback,
+    void* user_data)
+{
+    NfcAdapterPoolObject* self = nfc_adapter_pool_object_cast(pool);
+
+    if (G_LIKELY(self) && G_LIKELY(callback) &&
+        G_LIKELY(event < NFC_ADAPTER_POOL_EVENT_COUNT)) {
+        /* Same trick as in nfc_client_base_add_property_handler() */
+        NfcAdapterPoolClosure* closure = nfc_adapter_pool_closure_new();
+        GCClosure* cc = &closure->cclosure;
+
+        cc->closure.data = closure;
+        cc->callback = G_CALLBACK(nfc_adapter_pool_target_event);
+        closure->callback = callback;
+        closure->user_data = user_data;
+
+        return g_signal_connect_closure_by_id(self,
+            nfc_adapter_pool_signals[event], 0, &cc->closure, FALSE);
+    }
+    return 0;
+}
+
+void
+nfc_adapter_pool_remove_handler(
+    NfcAdapterPool* pool,
+    gulong id)
+{
+    if (G_LIKELY(id)) {
+        NfcAdapterPoolObject* self = nfc_adapter_pool_object_cast(pool);
+
+        if (G_LIKELY(self)) {
+            g_signal_handler_disconnect(self, id);
+        }
+    }
+}
+
+void
+nfc_adapter_pool_remove_handlers(
+    NfcAdapterPool* pool,
+    gulong* ids,
+    guint n)
+{
+    gutil_disconnect_handlers(nfc_adapter_pool_object_cast(pool), ids, n);
+}
+
+NfcAdapterPoolJob*
+nfc_adapter_pool_job_submit(
+    NfcAdapterPool* pool,
+    NfcAdapterPoolJobFunc start,
+    void* user_data,
+    GDestroyNotify destroy)
+{
+    NfcAdapterPoolObject* self = nfc_adapter_pool_object_cast(pool);
+
+    if (G_LIKELY(self) && G_LIKELY(start)) {
+        NfcAdapterPoolJob* job = g_slice_new0(NfcAdapterPoolJob);
+
+        g_object_ref(job->pool = self);
+        job->start = start;
+        job->destroy = destroy;
+        job->user_data = user_data;
+        g_queue_push_tail(&self->jobs, job);
+        pool->queued++;
+        nfc_adapter_pool_queue_signal(self, QUEUED);
+        if (!self->dispatch_id) {
+            self->dispatch_id = g_idle_add(nfc_adapter_pool_dispatch_cb,
+                self);
+        }
+        nfc_adapter_pool_emit_queued_signals(self);
+        return job;
+    }
+    return NULL;
+}
+
+void
+nfc_adapter_pool_job_done(
+    NfcAdapterPoolJob* job)
+{
+    if (G_LIKELY(job)) {
+        NfcAdapterPoolObject* self = job->pool;
+        NfcAdapterPool* pub = &self->pub;
+
+        if (job->adapter) {
+            NfcAdapterPoolSlot* slot = nfc_adapter_pool_find_slot(self,
+                job->adapter);
+
+            /* The adapter may have left the pool by now */
+            if (slot && slot->job == job) {
+                slot->busy_time += g_get_monotonic_time() - slot->job_start;
+                slot->jobs++;
+                slot->job = NULL;
+            } else {
+                self->detached = g_slist_remove(self->detached, job);
+            }
+            GDEBUG("Job on %s is done", job->adapter->path);
+            nfc_adapter_client_unref(job->adapter);
+            pub->busy--;
+            nfc_adapter_pool_queue_signal(self, BUSY);
+        } else {
+            g_queue_remove(&self->jobs, job);
+            pub->queued--;
+            nfc_adapter_pool_queue_signal(self, QUEUED);
+        }
+        if (job->destroy) {
+            job->destroy(job->user_data);
+        }
+        gutil_slice_free(job);
+
+        /* The adapter may be picked up by the next job */
+        nfc_adapter_pool_dispatch(self);
+        g_object_unref(self);
+    }
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+nfc_adapter_pool_object_init(
+    NfcAdapterPoolObject* self)
+{
+    NfcAdapterPool* pub = &self->pub;
+
+    GVERBOSE_("");
+    pub->adapters = &nfc_adapter_pool_empty_strv;
+    pub->tags = &nfc_adapter_pool_empty_strv;
+    pub->peers = &nfc_adapter_pool_empty_strv;
+    g_queue_init(&self->jobs);
+    g_queue_init(&self->events);
+    self->slots = g_ptr_array_new();
+    self->daemon = nfc_daemon_client_new();
+    self->daemon_event_id[DAEMON_VALID_CHANGED] =
+        nfc_daemon_client_add_property_handler(self->daemon,
+            NFC_DAEMON_PROPERTY_VALID,
+            nfc_adapter_pool_daemon_valid_changed, self);
+    self->daemon_event_id[DAEMON_ADAPTERS_CHANGED] =
+        nfc_daemon_client_add_property_handler(self->daemon,
+            NFC_DAEMON_PROPERTY_ADAPTERS,
+            nfc_adapter_pool_daemon_adapters_changed, self);
+    nfc_adapter_pool_check_adapters(self);
+
+    /* Nobody is listening yet */
+    g_queue_foreach(&self->events, (GFunc)
+        nfc_adapter_pool_pending_event_free, NULL);
+    g_queue_clear(&self->events);
+    self->base.queued_signals = 0;
+}
+
+static
+void
+nfc_adapter_pool_object_finalize(
+    GObject* object)
+{
+    NfcAdapterPoolObject* self = THIS(object);
+    guint i;
+
+    GVERBOSE_("");
+    GASSERT(nfc_adapter_pool_instance == self);
+    GASSERT(!self->jobs.length);
+    GASSERT(!self->detached); /* Running jobs hold a reference */
+    nfc_adapter_pool_instance = NULL;
+    if (self->dispatch_id) {
+        g_source_remove(self->dispatch_id);
+    }
+    nfc_daemon_client_remove_all_handlers(self->daemon, self->daemon_event_id);
+    nfc_daemon_client_unref(self->daemon);
+    for (i = 0; i < self->slots->len; i++) {
+        nfc_adapter_pool_slot_free(self, self->slots->pdata[i]);
+    }
+    g_ptr_array_free(self->slots, TRUE);
+    g_queue_foreach(&self->events, (GFunc)
+        nfc_adapter_pool_pending_event_free, NULL);
+    g_queue_clear(&self->events);
+    g_strfreev(self->adapters);
+    g_strfreev(self->tags);
+    g_strfreev(self->peers);
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+nfc_adapter_pool_object_class_init(
+    NfcAdapterPoolObjectClass* klass)
+{
+    GType type = G_OBJECT_CLASS_TYPE(klass);
+    int i;
+
+    G_OBJECT_CLASS(klass)->finalize = nfc_adapter_pool_object_finalize;
+    klass->public_offset = G_STRUCT_OFFSET(NfcAdapterPoolObject, pub);
+    klass->valid_offset = G_STRUCT_OFFSET(NfcAdapterPoolObject, pub.valid);
+    for (i = 0; i < NFC_ADAPTER_POOL_EVENT_COUNT; i++) {
+        nfc_adapter_pool_signals[i] =
+            g_signal_new(nfc_adapter_pool_signal_names[i], type,
+                G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE,
+                2, G_TYPE_POINTER, G_TYPE_STRING);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcdc_aid_trie_p.h"
+
+#include <gutil_macros.h>
+
+typedef struct nfc_aid_trie_node NfcAidTrieNode;
+
+struct nfc_aid_trie_node {
+    NfcAidTrieNode** children;  /* Sorted by byte */
+    guint nchildren;
+    guint8 byte;
+    gpointer exact;
+    gpointer prefix;
+};
+
+struct nfc_aid_trie {
+    NfcAidTrieNode root;
+};
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+nfc_aid_trie_node_clear(
+    NfcAidTrieNode* node)
+{
+    guint i;
+
+    for (i = 0; i < node->nchildren; i++) {
+        NfcAidTrieNode* child = node->children[i];
+
+        nfc_aid_trie_node_clear(child);
+        gutil_slice_free(child);
+    }
+    g_free(node->children);
+    node->children = NULL;
+    node->nchildren = 0;
+}
+
+/* Returns the index of the child or where it would be inserted */
+static
+guint
+nfc_aid_trie_node_find(
+    const NfcAidTrieNode* node,
+    guint8 byte,
+    gboolean* found)
+{
+    guint lo = 0, hi = node->nchildren;
+
+    while (lo < hi) {
+        const guint mid = (lo + hi) / 2;
+        const guint8 b = node->children[mid]->byte;
+
+        if (b == byte) {
+            *found = TRUE;
+            return mid;
+        } else if (b < byte) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *found = FALSE;
+    return lo;
+}
+
+static
+NfcAidTrieNode*
+nfc_aid_trie_node_child(
+    const NfcAidTrieNode* node,
+    guint8 byte)
+{
+    gboolean found;
+    const guint i = nfc_aid_trie_node_find(node, byte, &found);
+
+    return found ? node->children[i] : NULL;
+}
+
+static
+NfcAidTrieNode*
+nfc_aid_trie_node_add_child(
+    NfcAidTrieNode* node,
+    guint8 byte)
+{
+    gboolean found;
+    const guint i = nfc_aid_trie_node_find(node, byte, &found);
+
+    if (!found) {
+        NfcAidTrieNode* child = g_slice_new0(NfcAidTrieNode);
+
+        child->byte = byte;
+        node->children = g_renew(NfcAidTrieNode*, node->children,
+            node->nchildren + 1);
+        memmove(node->children + i + 1, node->children + i,
+            sizeof(NfcAidTrieNode*) * (node->nchildren - i));
+        node->children[i] = child;
+        node->nchildren++;
+    }
+    return node->children[i];
+}
+
+static
+gboolean
+nfc_aid_trie_node_remove(
+    NfcAidTrieNode* node,
+    const guint8* aid,
+    gsize len,
+    gboolean prefix)
+{
+    gboolean removed = FALSE;
+
+    if (!len) {
+        gpointer* slot = prefix ? &node->prefix : &node->exact;
+
+        if (*slot) {
+            *slot = NULL;
+            removed = TRUE;
+        }
+    } else {
+        gboolean found;
+        const guint i = nfc_aid_trie_node_find(node, aid[0], &found);
+
+        if (found) {
+            NfcAidTrieNode* child = node->children[i];
+
+            removed = nfc_aid_trie_node_remove(child, aid + 1, len - 1,
+                prefix);
+            if (removed && !child->nchildren && !child->exact &&
+                !child->prefix) {
+                /* Prune the empty branch */
+                gutil_slice_free(child);
+                node->nchildren--;
+                memmove(node->children + i, node->children + i + 1,
+                    sizeof(NfcAidTrieNode*) * (node->nchildren - i));
+                if (!node->nchildren) {
+                    g_free(node->children);
+                    node->children = NULL;
+                }
+            }
+        }
+    }
+    return removed;
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+NfcAidTrie*
+nfc_aid_trie_new(
+    void)
+{
+    return g_slice_new0(NfcAidTrie);
+}
+
+void
+nfc_aid_trie_free(
+    NfcAidTrie* trie)
+{
+    if (trie) {
+        nfc_aid_trie_node_clear(&trie->root);
+        gutil_slice_free(trie);
+    }
+}
+
+gboolean
+nfc_aid_trie_insert(
+    NfcAidTrie* trie,
+    const GUtilData* aid,
+    gboolean prefix,
+    gpointer value)
+{
+    if (trie && aid && aid->size && value) {
+        NfcAidTrieNode* node = &trie->root;
+        gpointer* slot;
+        gsize i;
+
+        for (i = 0; i < aid->size; i++) {
+            node = nfc_aid_trie_node_add_child(node, aid->bytes[i]);
+        }
+        slot = prefix ? &node->prefix : &node->exact;
+        if (!*slot) {
+            *slot = value;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+gboolean
+nfc_aid_trie_remove(
+    NfcAidTrie* trie,
+    const GUtilData* aid,
+    gboolean prefix)
+{
+    return trie && aid && aid->size && nfc_aid_trie_node_remove(&trie->root,
+        aid->bytes, aid->size, prefix);
+}
+
+gpointer
+nfc_aid_trie_lookup(
+    const NfcAidTrie* trie,
+    const GUtilData* aid)
+{
+    gpointer match = NULL;
+
+    if (trie && aid && aid->size) {
+        const NfcAidTrieNode* node = &trie->root;
+        gsize i;
+
+        for (i = 0; i < aid->size && node; i++) {
+            node = nfc_aid_trie_node_child(node, aid->bytes[i]);
+            if (node && node->prefix) {
+                /* Remember the longest prefix match so far */
+                match = node->prefix;
+            }
+        }
+        if (node && node->exact) {
+            match = node->exact;
+        }
+    }
+    return match;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_AID_TRIE_PRIVATE_H
+#define NFCDC_AID_TRIE_PRIVATE_H
+
+#include "nfcdc_types.h"
+
+/*
+ * Byte trie mapping AIDs to arbitrary pointers. Each AID can have an
+ * exact match value and a prefix match value attached to it. Lookup
+ * doesn't allocate any memory, and prefers the exact match over the
+ * longest prefix match.
+ */
+
+typedef struct nfc_aid_trie NfcAidTrie;
+
+NfcAidTrie*
+nfc_aid_trie_new(
+    void)
+    G_GNUC_INTERNAL;
+
+void
+nfc_aid_trie_free(
+    NfcAidTrie* trie)
+    G_GNUC_INTERNAL;
+
+gboolean
+nfc_aid_trie_insert(
+    NfcAidTrie* trie,
+    const GUtilData* aid,
+    gboolean prefix,
+    gpointer value)
+    G_GNUC_INTERNAL;
+
+gboolean
+nfc_aid_trie_remove(
+    NfcAidTrie* trie,
+    const GUtilData* aid,
+    gboolean prefix)
+    G_GNUC_INTERNAL;
+
+gpointer
+nfc_aid_trie_lookup(
+    const NfcAidTrie* trie,
+    const GUtilData* aid)
+    G_GNUC_INTERNAL;
+
+#endif /* NFCDC_AID_TRIE_PRIVATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
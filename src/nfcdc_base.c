@@ -37,6 +37,7 @@
 
 #include "nfcdc_base.h"
 #include "nfcdc_log.h"
+#include "nfcdc_trace_p.h"
 
 G_DEFINE_ABSTRACT_TYPE(NfcClientBase, nfc_client_base, G_TYPE_OBJECT)
 #define NFC_CLIENT_BASE_GET_CLASS(obj) G_TYPE_INSTANCE_GET_CLASS((obj), \
@@ -135,6 +136,7 @@ nfc_client_base_emit_queued_signals(
 
     /* Handlers could drop their references to us */
     g_object_ref(self);
+    NFCDC_TRACE2(signals__emit, self, self->queued_signals);
 
     /* VALID is the last signal to be emitted if the object BECOMES valid */
     if (self->queued_signals & SIGNAL_BIT_(VALID)) {
@@ -166,6 +168,7 @@ nfc_client_base_emit_queued_signals(
     }
 
     /* And release the temporary reference */
+    NFCDC_TRACE1(signals__done, self);
     g_object_unref(self);
 }
 
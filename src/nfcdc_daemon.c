@@ -42,6 +42,8 @@
 #include "nfcdc_daemon_p.h"
 #include "nfcdc_log.h"
 #include "nfcdc_peer_service_p.h"
+#include "nfcdc_stats_p.h"
+#include "nfcdc_trace_p.h"
 
 #include <gutil_macros.h>
 #include <gutil_misc.h>
@@ -65,6 +67,14 @@ enum nfc_daemon_client_proxy_signals {
     CHANGE_SIGNAL_COUNT
 };
 
+enum nfc_daemon_client_request_groups {
+    REQUEST_GROUP_MODE,
+    REQUEST_GROUP_TECHS,
+    REQUEST_GROUP_COUNT
+};
+
+typedef struct nfc_request_group NfcRequestGroup;
+
 typedef NfcClientBaseClass NfcDaemonClientObjectClass;
 typedef struct nfc_daemon_client_object {
     NfcClientBase base;
@@ -76,6 +86,7 @@ typedef struct nfc_daemon_client_object {
     /* Daemon interface */
     OrgSailfishosNfcDaemon* proxy;
     gulong change_signal_id[CHANGE_SIGNAL_COUNT];
+    gint64 get_all_start;
     gboolean daemon_watch_initializing;
     gboolean daemon_present;
     guint daemon_watch_id;
@@ -88,6 +99,9 @@ typedef struct nfc_daemon_client_object {
     gboolean settings_present;
     guint settings_watch_id;
     GError* settings_error;
+
+    /* Mode and tech requests made by this process */
+    NfcRequestGroup* request_group[REQUEST_GROUP_COUNT];
 } NfcDaemonClientObject;
 
 typedef
@@ -110,6 +124,8 @@ typedef struct nfc_daemon_client_call_data {
 typedef struct nfc_request_type {
     const char* Name;
     const char* name;
+    NFC_CLIENT_OP request_op;
+    NFC_CLIENT_OP release_op;
     void (*call_request)(
         OrgSailfishosNfcDaemon* proxy,
         guint on,
@@ -143,17 +159,34 @@ typedef struct nfc_request_impl {
     gboolean pending;
     gboolean cancelled;
     guint id;
+    gint64 start;
     const NfcRequestType* type;
 } NfcRequestImpl;
 
+/*
+ * Requests made by this process are combined into a single daemon
+ * request, which only gets replaced when the combined value changes.
+ * Each bit is enabled (disabled) as long as at least one request wants
+ * it to be enabled (disabled), which is exactly how nfcd combines the
+ * requests coming from different clients.
+ */
+#define NFC_REQUEST_GROUP_BITS (32)
+
+struct nfc_request_group {
+    const NfcRequestType* type;
+    NfcRequestImpl* impl;
+    guint on[NFC_REQUEST_GROUP_BITS];
+    guint off[NFC_REQUEST_GROUP_BITS];
+};
+
 typedef struct nfc_mode_request_priv {
     NfcModeRequest pub;
-    NfcRequestImpl* impl;
+    NfcDaemonClientObject* daemon;
 } NfcModeRequestPriv;
 
 typedef struct nfc_tech_request_priv {
     NfcTechRequest pub;
-    NfcRequestImpl* impl;
+    NfcDaemonClientObject* daemon;
 } NfcTechRequestPriv;
 
 #define PARENT_CLASS nfc_daemon_client_object_parent_class
@@ -180,6 +213,28 @@ NFC_CLIENT_BASE_ASSERT_COUNT(NFC_DAEMON_PROPERTY_COUNT);
 static char* nfc_daemon_client_empty_strv = NULL;
 static NfcDaemonClientObject* nfc_daemon_client_instance = NULL;
 
+static const NfcRequestType nfc_mode_request_type = {
+    "Mode",
+    "mode",
+    NFC_CLIENT_OP_REQUEST_MODE,
+    NFC_CLIENT_OP_RELEASE_MODE,
+    org_sailfishos_nfc_daemon_call_request_mode,
+    org_sailfishos_nfc_daemon_call_request_mode_finish,
+    org_sailfishos_nfc_daemon_call_release_mode,
+    org_sailfishos_nfc_daemon_call_release_mode_finish
+};
+
+static const NfcRequestType nfc_tech_request_type = {
+    "Tech",
+    "tech",
+    NFC_CLIENT_OP_REQUEST_TECHS,
+    NFC_CLIENT_OP_RELEASE_TECHS,
+    org_sailfishos_nfc_daemon_call_request_techs,
+    org_sailfishos_nfc_daemon_call_request_techs_finish,
+    org_sailfishos_nfc_daemon_call_release_techs,
+    org_sailfishos_nfc_daemon_call_release_techs_finish
+};
+
 /*==========================================================================*
  * Implementation
  *==========================================================================*/
@@ -486,14 +541,19 @@ nfc_daemon_client_daemon_get_all4_done(
     NfcDaemonClientObject* self = THIS(user_data);
     OrgSailfishosNfcDaemon* daemon = ORG_SAILFISHOS_NFC_DAEMON(proxy);
     GError* error = NULL;
+    gboolean ok;
     gint iface_version = 0;
     char** adapters = NULL;
     gint version = 0;
     guint mode = 0, techs = 0;
 
     GASSERT(!self->proxy);
-    if (org_sailfishos_nfc_daemon_call_get_all4_finish(daemon,
-        &iface_version, &adapters, &version, &mode, &techs, result, &error)) {
+    ok = org_sailfishos_nfc_daemon_call_get_all4_finish(daemon,
+        &iface_version, &adapters, &version, &mode, &techs, result, &error);
+    nfc_client_stats_finish("/", NFC_CLIENT_OP_DAEMON_GET_ALL4,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, "/", NFC_CLIENT_OP_DAEMON_GET_ALL4, ok);
+    if (ok) {
         GASSERT(iface_version >= 3);
         nfc_daemon_client_daemon_set_version(self, version);
         nfc_daemon_client_daemon_set_adapters(self, adapters);
@@ -522,14 +582,19 @@ nfc_daemon_client_daemon_get_all3_done(
     NfcDaemonClientObject* self = THIS(user_data);
     OrgSailfishosNfcDaemon* daemon = ORG_SAILFISHOS_NFC_DAEMON(proxy);
     GError* error = NULL;
+    gboolean ok;
     gint iface_version = 0;
     char** adapters = NULL;
     gint version = 0;
     guint mode = 0;
 
     GASSERT(!self->proxy);
-    if (org_sailfishos_nfc_daemon_call_get_all3_finish(daemon,
-        &iface_version, &adapters, &version, &mode, result, &error)) {
+    ok = org_sailfishos_nfc_daemon_call_get_all3_finish(daemon,
+        &iface_version, &adapters, &version, &mode, result, &error);
+    nfc_client_stats_finish("/", NFC_CLIENT_OP_DAEMON_GET_ALL3,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, "/", NFC_CLIENT_OP_DAEMON_GET_ALL3, ok);
+    if (ok) {
         GASSERT(iface_version >= 3);
         nfc_daemon_client_daemon_set_version(self, version);
         nfc_daemon_client_daemon_set_adapters(self, adapters);
@@ -557,13 +622,18 @@ nfc_daemon_client_daemon_get_all2_done(
     NfcDaemonClientObject* self = THIS(user_data);
     OrgSailfishosNfcDaemon* daemon = ORG_SAILFISHOS_NFC_DAEMON(proxy);
     GError* error = NULL;
+    gboolean ok;
     gint iface_version = 0;
     char** adapters = NULL;
     gint version = 0;
 
     GASSERT(!self->proxy);
-    if (org_sailfishos_nfc_daemon_call_get_all2_finish(daemon,
-        &iface_version, &adapters, &version, result, &error)) {
+    ok = org_sailfishos_nfc_daemon_call_get_all2_finish(daemon,
+        &iface_version, &adapters, &version, result, &error);
+    nfc_client_stats_finish("/", NFC_CLIENT_OP_DAEMON_GET_ALL2,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, "/", NFC_CLIENT_OP_DAEMON_GET_ALL2, ok);
+    if (ok) {
         GASSERT(iface_version == 2);
         nfc_daemon_client_daemon_set_version(self, version);
         nfc_daemon_client_daemon_set_adapters(self, adapters);
@@ -590,23 +660,34 @@ nfc_daemon_client_daemon_get_all_done(
     NfcDaemonClientObject* self = THIS(user_data);
     OrgSailfishosNfcDaemon* daemon = ORG_SAILFISHOS_NFC_DAEMON(proxy);
     GError* error = NULL;
+    gboolean ok;
     gint iface_version = 0;
     char** adapters = NULL;
 
     GASSERT(!self->proxy);
-    if (org_sailfishos_nfc_daemon_call_get_all_finish(daemon,
-        &iface_version, &adapters, result, &error)) {
+    ok = org_sailfishos_nfc_daemon_call_get_all_finish(daemon,
+        &iface_version, &adapters, result, &error);
+    nfc_client_stats_finish("/", NFC_CLIENT_OP_DAEMON_GET_ALL,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, "/", NFC_CLIENT_OP_DAEMON_GET_ALL, ok);
+    if (ok) {
         NfcDaemonClient* pub = &self->pub;
 
         GDEBUG("NFC daemon interface version %d", iface_version);
         nfc_daemon_client_daemon_set_adapters(self, adapters);
         if (iface_version >= 4) {
+            self->get_all_start = nfc_client_stats_start();
+            NFCDC_TRACE2(init__start, "/", NFC_CLIENT_OP_DAEMON_GET_ALL4);
             org_sailfishos_nfc_daemon_call_get_all4(daemon, NULL,
                 nfc_daemon_client_daemon_get_all4_done, g_object_ref(self));
         } else if (iface_version == 3) {
+            self->get_all_start = nfc_client_stats_start();
+            NFCDC_TRACE2(init__start, "/", NFC_CLIENT_OP_DAEMON_GET_ALL3);
             org_sailfishos_nfc_daemon_call_get_all3(daemon, NULL,
                 nfc_daemon_client_daemon_get_all3_done, g_object_ref(self));
         } else if (iface_version == 2) {
+            self->get_all_start = nfc_client_stats_start();
+            NFCDC_TRACE2(init__start, "/", NFC_CLIENT_OP_DAEMON_GET_ALL2);
             org_sailfishos_nfc_daemon_call_get_all2(daemon, NULL,
                 nfc_daemon_client_daemon_get_all2_done, g_object_ref(self));
         } else {
@@ -651,6 +732,8 @@ nfc_daemon_client_new_daemon(
         self->change_signal_id[CHANGE_TECHS_CHANGED] =
             g_signal_connect(daemon, "techs-changed",
                 G_CALLBACK(nfc_daemon_client_daemon_techs_changed), self);
+        self->get_all_start = nfc_client_stats_start();
+        NFCDC_TRACE2(init__start, "/", NFC_CLIENT_OP_DAEMON_GET_ALL);
         org_sailfishos_nfc_daemon_call_get_all(daemon, NULL,
             nfc_daemon_client_daemon_get_all_done, g_object_ref(self));
     } else {
@@ -938,10 +1021,12 @@ nfc_request_impl_release_done(
     impl->pending = FALSE;
 
     if (type->finish_release(daemon, result, &error)) {
+        nfc_client_stats_finish("/", type->release_op, impl->start, NULL);
         GDEBUG("Dropped %s request %u", type->name, impl->id);
     } else {
         GERR("Failed to release %s request %u: %s", type->name, impl->id,
             GERRMSG(error));
+        nfc_client_stats_finish("/", type->release_op, impl->start, error);
         g_error_free(error);
     }
 
@@ -965,9 +1050,11 @@ nfc_request_impl_request_done(
     impl->pending = FALSE;
 
     if (type->finish_request(daemon, &id, result, &error)) {
+        nfc_client_stats_finish("/", type->request_op, impl->start, NULL);
         if (impl->cancelled) {
             GDEBUG("%s request id %u (cancelled)", type->Name, id);
             impl->pending = TRUE;
+            impl->start = nfc_client_stats_start();
             type->call_release(daemon, id, NULL,
                 nfc_request_impl_release_done, nfc_request_impl_ref(impl));
         } else {
@@ -976,6 +1063,7 @@ nfc_request_impl_request_done(
         }
     } else {
         GERR("Failed to request %s: %s", GERRMSG(error), type->name);
+        nfc_client_stats_finish("/", type->request_op, impl->start, error);
         g_error_free(error);
     }
 
@@ -997,6 +1085,7 @@ nfc_request_impl_present_changed(
             const NfcRequestType* type = impl->type;
 
             impl->pending = TRUE;
+            impl->start = nfc_client_stats_start();
             type->call_request(self->proxy, impl->on, impl->off, NULL,
                 nfc_request_impl_request_done, nfc_request_impl_ref(impl));
         }
@@ -1026,6 +1115,7 @@ nfc_request_impl_new(
         impl);
     if (client->present) {
         impl->pending = TRUE;
+        impl->start = nfc_client_stats_start();
         type->call_request(self->proxy, impl->on, impl->off, NULL,
             nfc_request_impl_request_done, nfc_request_impl_ref(impl));
     }
@@ -1047,6 +1137,7 @@ nfc_request_impl_drop(
 
         GDEBUG("Releasing %s request %u", type->name, impl->id);
         impl->pending = TRUE;
+        impl->start = nfc_client_stats_start();
         type->call_release(self->proxy, impl->id, NULL,
             nfc_request_impl_release_done, nfc_request_impl_ref(impl));
     }
@@ -1054,6 +1145,92 @@ nfc_request_impl_drop(
     nfc_request_impl_unref(impl);
 }
 
+/*==========================================================================*
+ * NfcRequestGroup
+ *==========================================================================*/
+
+static
+NfcRequestGroup*
+nfc_request_group_new(
+    const NfcRequestType* type)
+{
+    NfcRequestGroup* group = g_slice_new0(NfcRequestGroup);
+
+    group->type = type;
+    return group;
+}
+
+static
+void
+nfc_request_group_free(
+    NfcRequestGroup* group)
+{
+    /* Requests hold a reference to the daemon client */
+    GASSERT(!group->impl);
+    gutil_slice_free(group);
+}
+
+static
+guint
+nfc_request_group_bits(
+    const guint* count)
+{
+    guint i, bits = 0;
+
+    for (i = 0; i < NFC_REQUEST_GROUP_BITS; i++) {
+        if (count[i]) {
+            bits |= (1u << i);
+        }
+    }
+    return bits;
+}
+
+static
+void
+nfc_request_group_count(
+    guint* count,
+    guint bits,
+    int delta)
+{
+    guint i;
+
+    for (i = 0; bits; i++, bits >>= 1) {
+        if (bits & 1) {
+            GASSERT(delta > 0 || count[i]);
+            count[i] += delta;
+        }
+    }
+}
+
+static
+void
+nfc_request_group_update(
+    NfcDaemonClientObject* self,
+    NfcRequestGroup* group,
+    guint on,
+    guint off,
+    int delta)
+{
+    NfcRequestImpl* impl = group->impl;
+
+    nfc_request_group_count(group->on, on, delta);
+    nfc_request_group_count(group->off, off, delta);
+    on = nfc_request_group_bits(group->on);
+    off = nfc_request_group_bits(group->off);
+    if (impl ? (impl->on != on || impl->off != off) : (on || off)) {
+        GDEBUG("Combined %s request 0x%02x/0x%02x", group->type->name,
+            on, off);
+
+        /* Submit the new combination before releasing the old one */
+        group->impl = (on || off) ?
+            nfc_request_impl_new(self, group->type, on, off) :
+            NULL;
+        if (impl) {
+            nfc_request_impl_drop(impl);
+        }
+    }
+}
+
 /*==========================================================================*
  * Internal API
  *==========================================================================*/
@@ -1265,22 +1442,14 @@ nfc_mode_request_new(
     NfcDaemonClientObject* self = nfc_daemon_client_object_cast(daemon);
 
     if (G_LIKELY(self)) {
-        static const NfcRequestType mode_request_type = {
-            "Mode",
-            "mode",
-            org_sailfishos_nfc_daemon_call_request_mode,
-            org_sailfishos_nfc_daemon_call_request_mode_finish,
-            org_sailfishos_nfc_daemon_call_release_mode,
-            org_sailfishos_nfc_daemon_call_release_mode_finish
-        };
-
         NfcModeRequestPriv* priv = g_slice_new(NfcModeRequestPriv);
         NfcModeRequest* req = &priv->pub;
 
         req->enable = enable;
         req->disable = disable;
-        priv->impl = nfc_request_impl_new(self, &mode_request_type,
-            enable, disable);
+        g_object_ref(priv->daemon = self);
+        nfc_request_group_update(self, self->request_group
+            [REQUEST_GROUP_MODE], enable, disable, 1);
         return req;
     }
     return NULL;
@@ -1292,8 +1461,11 @@ nfc_mode_request_free(
 {
     if (req) {
         NfcModeRequestPriv* priv = G_CAST(req, NfcModeRequestPriv, pub);
+        NfcDaemonClientObject* self = priv->daemon;
 
-        nfc_request_impl_drop(priv->impl);
+        nfc_request_group_update(self, self->request_group
+            [REQUEST_GROUP_MODE], req->enable, req->disable, -1);
+        g_object_unref(self);
         gutil_slice_free(priv);
     }
 }
@@ -1307,22 +1479,14 @@ nfc_tech_request_new(
     NfcDaemonClientObject* self = nfc_daemon_client_object_cast(daemon);
 
     if (G_LIKELY(self)) {
-        static const NfcRequestType tech_request_type = {
-            "Tech",
-            "tech",
-            org_sailfishos_nfc_daemon_call_request_techs,
-            org_sailfishos_nfc_daemon_call_request_techs_finish,
-            org_sailfishos_nfc_daemon_call_release_techs,
-            org_sailfishos_nfc_daemon_call_release_techs_finish
-        };
-
         NfcTechRequestPriv* priv = g_slice_new(NfcTechRequestPriv);
         NfcTechRequest* req = &priv->pub;
 
         req->allow = allow;
         req->disallow = disallow;
-        priv->impl = nfc_request_impl_new(self, &tech_request_type,
-            allow, disallow);
+        g_object_ref(priv->daemon = self);
+        nfc_request_group_update(self, self->request_group
+            [REQUEST_GROUP_TECHS], allow, disallow, 1);
         return req;
     }
     return NULL;
@@ -1334,8 +1498,11 @@ nfc_tech_request_free(
 {
     if (req) {
         NfcTechRequestPriv* priv = G_CAST(req, NfcTechRequestPriv, pub);
+        NfcDaemonClientObject* self = priv->daemon;
 
-        nfc_request_impl_drop(priv->impl);
+        nfc_request_group_update(self, self->request_group
+            [REQUEST_GROUP_TECHS], req->allow, req->disallow, -1);
+        g_object_unref(self);
         gutil_slice_free(priv);
     }
 }
@@ -1353,6 +1520,10 @@ nfc_daemon_client_object_init(
 
     GVERBOSE_("");
     pub->adapters = &nfc_daemon_client_empty_strv;
+    self->request_group[REQUEST_GROUP_MODE] =
+        nfc_request_group_new(&nfc_mode_request_type);
+    self->request_group[REQUEST_GROUP_TECHS] =
+        nfc_request_group_new(&nfc_tech_request_type);
 }
 
 static
@@ -1361,6 +1532,7 @@ nfc_daemon_client_object_finalize(
     GObject* object)
 {
     NfcDaemonClientObject* self = THIS(object);
+    int i;
 
     GVERBOSE_("");
     GASSERT(nfc_daemon_client_instance == self);
@@ -1371,6 +1543,9 @@ nfc_daemon_client_object_finalize(
     nfc_daemon_client_drop_settings_proxy(self);
     gutil_object_unref(self->connection);
     g_strfreev(self->adapters);
+    for (i = 0; i < REQUEST_GROUP_COUNT; i++) {
+        nfc_request_group_free(self->request_group[i]);
+    }
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
@@ -0,0 +1,1139 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcdc_host_service.h"
+#include "nfcdc_aid_trie_p.h"
+#include "nfcdc_base.h"
+#include "nfcdc_daemon_p.h"
+#include "nfcdc_log.h"
+#include "nfcdc_util_p.h"
+
+#include "org.sailfishos.nfc.LocalHostService.h"
+
+#include <gutil_macros.h>
+#include <gutil_misc.h>
+
+enum nfc_host_service_daemon_events {
+    DAEMON_PRESENT_CHANGED,
+    DAEMON_SIGNAL_COUNT
+};
+
+enum nfc_host_service_calls {
+    CALL_START,
+    CALL_RESTART,
+    CALL_STOP,
+    CALL_PROCESS,
+    CALL_RESPONSE_STATUS,
+    CALL_COUNT
+};
+
+typedef struct nfc_host_app {
+    gint ref_count;
+    guint id;
+    NFC_HOST_APP_FLAGS flags;
+    GUtilData* aid;
+    NfcHostServiceProcessFunc process;
+    void* user_data;
+    GDestroyNotify destroy;
+} NfcHostApp;
+
+typedef struct nfc_host_static_entry {
+    guint32 header;
+    guint32 mask;
+    GUtilData* data;
+    GBytes* response;
+    guint sw;
+} NfcHostStaticEntry;
+
+typedef struct nfc_host_static_table {
+    NfcHostStaticEntry* entries;
+    guint count;
+} NfcHostStaticTable;
+
+/*
+ * Static responses are sent directly from the D-Bus filter which is
+ * invoked on the GDBus worker thread. The part of the state which is
+ * touched by the filter (apps, selection and static tables) is protected
+ * by the mutex. The filter holds a reference to this structure which
+ * may therefore outlive the service object.
+ */
+typedef struct nfc_host_service_object NfcHostServiceObject;
+typedef struct nfc_host_service_shared {
+    gint ref_count;
+    GMutex mutex;
+    NfcHostServiceObject* obj;
+} NfcHostServiceShared;
+
+typedef NfcClientBaseClass NfcHostServiceObjectClass;
+struct nfc_host_service_object {
+    NfcClientBase base;
+    NfcHostService pub;
+    NfcDaemonClient* daemon;
+    NfcHostServiceProcessFunc process;
+    void* process_data;
+    OrgSailfishosNfcLocalHostService* object;
+    gulong call_id[CALL_COUNT];
+    gulong daemon_event_id[DAEMON_SIGNAL_COUNT];
+    gboolean exported;
+    gboolean registering;
+    char* path;
+    char* name;
+    GHashTable* apps;
+    NfcAidTrie* aid_trie;
+    NfcHostApp* selected_app;
+    guint last_app_id;
+    NfcHostServiceShared* shared;
+    GHashTable* static_tables;
+    GDBusConnection* filter_connection;
+    guint filter_id;
+};
+
+typedef struct nfc_host_request_priv {
+    NfcHostRequest pub;
+    OrgSailfishosNfcLocalHostService* object;
+    GDBusMethodInvocation* call;
+    GVariant* data;
+    GVariant* params;   /* Keeps the host name alive */
+    gint refcount;
+} NfcHostRequestPriv;
+
+#define PARENT_CLASS nfc_host_service_object_parent_class
+#define THIS_TYPE nfc_host_service_object_get_type()
+#define THIS(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, THIS_TYPE, \
+    NfcHostServiceObject)
+
+GType THIS_TYPE G_GNUC_INTERNAL;
+G_DEFINE_TYPE(NfcHostServiceObject, nfc_host_service_object, \
+    NFC_CLIENT_TYPE_BASE)
+
+NFC_CLIENT_BASE_ASSERT_COUNT(NFC_HOST_SERVICE_PROPERTY_COUNT);
+
+#define nfc_host_service_emit_queued_signals(self) \
+    nfc_client_base_emit_queued_signals(&(self)->base)
+#define nfc_host_service_signal_property_change(self,NAME) \
+    nfc_client_base_signal_property_change(&(self)->base, \
+    NFC_HOST_SERVICE_PROPERTY_##NAME)
+#define nfc_host_service_queue_signal(self,NAME) \
+    ((self)->base.queued_signals |= \
+    NFC_CLIENT_BASE_SIGNAL_BIT(NFC_HOST_SERVICE_PROPERTY_##NAME))
+
+enum nfc_host_service_signal {
+    SIGNAL_START,
+    SIGNAL_RESTART,
+    SIGNAL_STOP,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_START_NAME             "nfcdc-host-service-start"
+#define SIGNAL_RESTART_NAME           "nfcdc-host-service-restart"
+#define SIGNAL_STOP_NAME              "nfcdc-host-service-stop"
+
+static guint nfc_host_service_signals[SIGNAL_COUNT];
+
+/* No precise diagnosis */
+#define NFC_HOST_SERVICE_SW_DEFAULT NFC_ISODEP_SW(0x6f, 0x00)
+
+#define NFC_HOST_INS_SELECT (0xa4)
+#define NFC_HOST_SELECT_BY_NAME (0x04)
+
+#define NFC_HOST_SERVICE_INTERFACE "org.sailfishos.nfc.LocalHostService"
+#define NFC_HOST_SERVICE_PROCESS "Process"
+
+#define nfc_host_service_lock(self) g_mutex_lock(&(self)->shared->mutex)
+#define nfc_host_service_unlock(self) g_mutex_unlock(&(self)->shared->mutex)
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static inline
+NfcHostServiceObject*
+nfc_host_service_object_cast(
+    NfcHostService* service)
+{
+    return service ? THIS(G_CAST(service, NfcHostServiceObject, pub)) : NULL;
+}
+
+static inline
+NfcHostRequestPriv*
+nfc_host_request_cast(
+    NfcHostRequest* request)
+{
+    return request ? G_CAST(request, NfcHostRequestPriv, pub) : NULL;
+}
+
+static
+NfcHostApp*
+nfc_host_app_ref(
+    NfcHostApp* app)
+{
+    g_atomic_int_inc(&app->ref_count);
+    return app;
+}
+
+static
+void
+nfc_host_app_unref(
+    gpointer data)
+{
+    NfcHostApp* app = data;
+
+    if (g_atomic_int_dec_and_test(&app->ref_count)) {
+        if (app->destroy) {
+            app->destroy(app->user_data);
+        }
+        g_free(app->aid);
+        gutil_slice_free(app);
+    }
+}
+
+static
+void
+nfc_host_service_remove_app_from_trie(
+    NfcHostServiceObject* self,
+    NfcHostApp* app)
+{
+    if (app->flags & NFC_HOST_APP_MATCH_EXACT) {
+        nfc_aid_trie_remove(self->aid_trie, app->aid, FALSE);
+    }
+    if (app->flags & NFC_HOST_APP_MATCH_PREFIX) {
+        nfc_aid_trie_remove(self->aid_trie, app->aid, TRUE);
+    }
+}
+
+static
+NfcHostServiceShared*
+nfc_host_service_shared_ref(
+    NfcHostServiceShared* shared)
+{
+    g_atomic_int_inc(&shared->ref_count);
+    return shared;
+}
+
+static
+void
+nfc_host_service_shared_unref(
+    gpointer data)
+{
+    NfcHostServiceShared* shared = data;
+
+    if (g_atomic_int_dec_and_test(&shared->ref_count)) {
+        GASSERT(!shared->obj);
+        g_mutex_clear(&shared->mutex);
+        gutil_slice_free(shared);
+    }
+}
+
+static
+void
+nfc_host_static_table_free(
+    gpointer data)
+{
+    NfcHostStaticTable* table = data;
+    guint i;
+
+    for (i = 0; i < table->count; i++) {
+        NfcHostStaticEntry* entry = table->entries + i;
+
+        g_free(entry->data);
+        g_bytes_unref(entry->response);
+    }
+    g_free(table->entries);
+    gutil_slice_free(table);
+}
+
+static
+const NfcHostStaticEntry*
+nfc_host_static_table_lookup(
+    const NfcHostStaticTable* table,
+    const NfcIsoDepApdu* apdu)
+{
+    if (table) {
+        const guint32 header = NFC_HOST_APDU_HEADER(apdu->cla, apdu->ins,
+            apdu->p1, apdu->p2);
+        guint i;
+
+        for (i = 0; i < table->count; i++) {
+            const NfcHostStaticEntry* entry = table->entries + i;
+
+            if ((header & entry->mask) == (entry->header & entry->mask) &&
+                (!entry->data || gutil_data_equal(entry->data, &apdu->data))) {
+                return entry;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Must be called under lock */
+static
+void
+nfc_host_service_deselect_app(
+    NfcHostServiceObject* self)
+{
+    if (self->selected_app) {
+        GDEBUG("App %u deselected", self->selected_app->id);
+        self->selected_app = NULL;
+    }
+}
+
+/* Must be called under lock */
+static
+NfcHostApp*
+nfc_host_service_route(
+    NfcHostServiceObject* self,
+    const NfcIsoDepApdu* apdu)
+{
+    /* Only SELECT by DF name (interindustry class) changes the route */
+    if (self->aid_trie && !(apdu->cla & 0x80) &&
+        apdu->ins == NFC_HOST_INS_SELECT &&
+        apdu->p1 == NFC_HOST_SELECT_BY_NAME) {
+        NfcHostApp* app = nfc_aid_trie_lookup(self->aid_trie, &apdu->data);
+
+        if (self->selected_app != app) {
+            if (app) {
+                GDEBUG("App %u selected", app->id);
+                self->selected_app = app;
+            } else {
+                nfc_host_service_deselect_app(self);
+            }
+        }
+    }
+    return self->selected_app;
+}
+
+static
+NfcHostRequestPriv*
+nfc_host_request_priv_new(
+    OrgSailfishosNfcLocalHostService* object,
+    GDBusMethodInvocation* call,
+    guchar cla,
+    guchar ins,
+    guchar p1,
+    guchar p2,
+    GVariant* data,
+    guint le)
+{
+    NfcHostRequestPriv* priv = g_slice_new0(NfcHostRequestPriv);
+    NfcHostRequest* req = &priv->pub;
+    NfcIsoDepApdu* apdu = &req->apdu;
+    gsize size = 0;
+
+    /*
+     * The host name is borrowed from the call parameters (the copy passed
+     * to the handler is freed when the handler returns). The parameters
+     * have to stay around even after the call has been completed.
+     */
+    priv->params = g_variant_ref(g_dbus_method_invocation_get_parameters
+        (call));
+    g_variant_get_child(priv->params, 0, "&o", &req->host);
+    apdu->cla = cla;
+    apdu->ins = ins;
+    apdu->p1 = p1;
+    apdu->p2 = p2;
+    apdu->data.bytes = g_variant_get_fixed_array(data, &size, 1);
+    apdu->data.size = size;
+    apdu->le = le;
+    g_atomic_int_set(&priv->refcount, 1);
+    g_variant_ref(priv->data = data);
+    g_object_ref(priv->object = object);
+    g_object_ref(priv->call = call);
+    return priv;
+}
+
+static
+void
+nfc_host_request_priv_complete(
+    NfcHostRequestPriv* priv,
+    GVariant* response,
+    guint sw)
+{
+    /*
+     * Zero response_id tells nfcd that we don't need ResponseStatus
+     * call, so that the response doesn't generate any extra traffic.
+     */
+    org_sailfishos_nfc_local_host_service_complete_process(priv->object,
+        priv->call, response, NFC_ISODEP_SW1(sw), NFC_ISODEP_SW2(sw), 0);
+    g_object_unref(priv->call);
+    priv->call = NULL;
+}
+
+static
+void
+nfc_host_request_priv_unref(
+    NfcHostRequestPriv* priv)
+{
+    if (g_atomic_int_dec_and_test(&priv->refcount)) {
+        if (priv->call) {
+            GDEBUG("No response to %02X%02X%02X%02X", priv->pub.apdu.cla,
+                priv->pub.apdu.ins, priv->pub.apdu.p1, priv->pub.apdu.p2);
+            nfc_host_request_priv_complete(priv,
+                g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, NULL, 0, 1),
+                NFC_HOST_SERVICE_SW_DEFAULT);
+        }
+        g_object_unref(priv->object);
+        g_variant_unref(priv->data);
+        g_variant_unref(priv->params);
+        gutil_slice_free(priv);
+    }
+}
+
+static
+void
+nfc_host_service_registered(
+    NfcDaemonClient* daemon,
+    const GError* error,
+    void* user_data)
+{
+    NfcHostServiceObject* self = THIS(user_data);
+    NfcHostService* service = &self->pub;
+
+    self->registering = FALSE;
+    if (error) {
+        GERR("Host service %s registration error: %s", service->path,
+            GERRMSG(error));
+    } else {
+        GDEBUG("Registered host service %s", service->path);
+        if (!service->registered) {
+            service->registered = TRUE;
+            nfc_host_service_signal_property_change(self, REGISTERED);
+        }
+    }
+}
+
+static
+void
+nfc_host_service_try_register(
+    NfcHostServiceObject* self)
+{
+    NfcHostService* service = &self->pub;
+
+    if (!service->registered && !self->registering && self->exported) {
+        NfcDaemonClient* daemon = self->daemon;
+
+        if (daemon->valid && daemon->present) {
+            self->registering =
+                nfc_daemon_client_register_local_host_service(daemon,
+                    self->path, self->name, NULL, nfc_host_service_registered,
+                    g_object_ref(self), g_object_unref);
+        }
+    }
+}
+
+static
+void
+nfc_host_service_daemon_presence_changed(
+    NfcDaemonClient* daemon,
+    NFC_DAEMON_PROPERTY property,
+    void* user_data)
+{
+    NfcHostServiceObject* self = THIS(user_data);
+    NfcHostService* service = &self->pub;
+
+    if (daemon->present) {
+        nfc_host_service_try_register(self);
+    } else if (service->registered) {
+        service->registered = FALSE;
+        nfc_host_service_queue_signal(self, REGISTERED);
+    }
+    nfc_host_service_emit_queued_signals(self);
+}
+
+static
+gboolean
+nfc_host_service_object_handle_start(
+    OrgSailfishosNfcLocalHostService* object,
+    GDBusMethodInvocation* call,
+    const char* host,
+    NfcHostServiceObject* self)
+{
+    GDEBUG("Host %s started", host);
+    nfc_host_service_lock(self);
+    nfc_host_service_deselect_app(self);
+    nfc_host_service_unlock(self);
+    g_signal_emit(self, nfc_host_service_signals[SIGNAL_START], 0, host);
+    org_sailfishos_nfc_local_host_service_complete_start(object, call);
+    return TRUE;
+}
+
+static
+gboolean
+nfc_host_service_object_handle_restart(
+    OrgSailfishosNfcLocalHostService* object,
+    GDBusMethodInvocation* call,
+    const char* host,
+    NfcHostServiceObject* self)
+{
+    GDEBUG("Host %s restarted", host);
+    nfc_host_service_lock(self);
+    nfc_host_service_deselect_app(self);
+    nfc_host_service_unlock(self);
+    g_signal_emit(self, nfc_host_service_signals[SIGNAL_RESTART], 0, host);
+    org_sailfishos_nfc_local_host_service_complete_restart(object, call);
+    return TRUE;
+}
+
+static
+gboolean
+nfc_host_service_object_handle_stop(
+    OrgSailfishosNfcLocalHostService* object,
+    GDBusMethodInvocation* call,
+    const char* host,
+    NfcHostServiceObject* self)
+{
+    GDEBUG("Host %s stopped", host);
+    nfc_host_service_lock(self);
+    nfc_host_service_deselect_app(self);
+    nfc_host_service_unlock(self);
+    g_signal_emit(self, nfc_host_service_signals[SIGNAL_STOP], 0, host);
+    org_sailfishos_nfc_local_host_service_complete_stop(object, call);
+    return TRUE;
+}
+
+static
+gboolean
+nfc_host_service_object_handle_process(
+    OrgSailfishosNfcLocalHostService* object,
+    GDBusMethodInvocation* call,
+    const char* host,
+    guchar cla,
+    guchar ins,
+    guchar p1,
+    guchar p2,
+    GVariant* data,
+    guint le,
+    NfcHostServiceObject* self)
+{
+    NfcHostRequestPriv* priv = nfc_host_request_priv_new(object, call,
+        cla, ins, p1, p2, data, le);
+    NfcHostRequest* req = &priv->pub;
+    NfcHostApp* app;
+
+    nfc_host_service_lock(self);
+    app = nfc_host_service_route(self, &req->apdu);
+    if (app) {
+        /* The app may get removed by its own callback */
+        nfc_host_app_ref(app);
+    }
+    nfc_host_service_unlock(self);
+
+    if (app) {
+        app->process(&self->pub, req, app->user_data);
+        nfc_host_app_unref(app);
+    } else {
+        self->process(&self->pub, req, self->process_data);
+    }
+    nfc_host_request_priv_unref(priv);
+    return TRUE;
+}
+
+static
+gboolean
+nfc_host_service_object_handle_response_status(
+    OrgSailfishosNfcLocalHostService* object,
+    GDBusMethodInvocation* call,
+    guint response_id,
+    gboolean ok,
+    NfcHostServiceObject* self)
+{
+    /* We never ask for it but let's be polite */
+    org_sailfishos_nfc_local_host_service_complete_response_status(object,
+        call);
+    return TRUE;
+}
+
+/* Must be called under lock */
+static
+GDBusMessage*
+nfc_host_service_static_reply(
+    NfcHostServiceObject* self,
+    GDBusMessage* message)
+{
+    GVariant* body = g_dbus_message_get_body(message);
+    GDBusMessage* reply = NULL;
+
+    if (self->static_tables && body &&
+        g_variant_is_of_type(body, G_VARIANT_TYPE("(oyyyyayu)"))) {
+        const NfcHostStaticEntry* entry;
+        NfcHostApp* app;
+        NfcIsoDepApdu apdu;
+        GVariant* data = NULL;
+        gsize size = 0;
+
+        g_variant_get(body, "(&oyyyy@ayu)", NULL, &apdu.cla, &apdu.ins,
+            &apdu.p1, &apdu.p2, &data, &apdu.le);
+        apdu.data.bytes = g_variant_get_fixed_array(data, &size, 1);
+        apdu.data.size = size;
+
+        /* Responses of the selected app take precedence */
+        app = nfc_host_service_route(self, &apdu);
+        entry = app ? nfc_host_static_table_lookup(g_hash_table_lookup
+            (self->static_tables, GUINT_TO_POINTER(app->id)), &apdu) : NULL;
+        if (!entry) {
+            entry = nfc_host_static_table_lookup(g_hash_table_lookup
+                (self->static_tables, NULL), &apdu);
+        }
+        if (entry) {
+            gsize n = 0;
+            gconstpointer bytes = g_bytes_get_data(entry->response, &n);
+
+            GDEBUG("Static response to %02X%02X%02X%02X", apdu.cla,
+                apdu.ins, apdu.p1, apdu.p2);
+            reply = g_dbus_message_new_method_reply(message);
+            g_dbus_message_set_body(reply, g_variant_new("(@ayyyu)",
+                g_variant_new_from_data(G_VARIANT_TYPE_BYTESTRING, bytes, n,
+                    TRUE, (GDestroyNotify) g_bytes_unref,
+                    g_bytes_ref(entry->response)),
+                NFC_ISODEP_SW1(entry->sw), NFC_ISODEP_SW2(entry->sw), 0));
+        }
+        g_variant_unref(data);
+    }
+    return reply;
+}
+
+/* Invoked on the GDBus worker thread */
+static
+GDBusMessage*
+nfc_host_service_filter(
+    GDBusConnection* connection,
+    GDBusMessage* message,
+    gboolean incoming,
+    gpointer user_data)
+{
+    if (incoming && g_dbus_message_get_message_type(message) ==
+        G_DBUS_MESSAGE_TYPE_METHOD_CALL &&
+        !g_strcmp0(g_dbus_message_get_member(message),
+            NFC_HOST_SERVICE_PROCESS) &&
+        !g_strcmp0(g_dbus_message_get_interface(message),
+            NFC_HOST_SERVICE_INTERFACE)) {
+        NfcHostServiceShared* shared = user_data;
+        GDBusMessage* reply = NULL;
+
+        g_mutex_lock(&shared->mutex);
+        if (shared->obj && !g_strcmp0(g_dbus_message_get_path(message),
+            shared->obj->path)) {
+            reply = nfc_host_service_static_reply(shared->obj, message);
+        }
+        g_mutex_unlock(&shared->mutex);
+
+        if (reply) {
+            g_dbus_connection_send_message(connection, reply,
+                G_DBUS_SEND_MESSAGE_FLAGS_NONE, NULL, NULL);
+            g_object_unref(reply);
+            /* The call has been handled, drop it */
+            g_object_unref(message);
+            return NULL;
+        }
+    }
+    return message;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+NfcHostService*
+nfc_host_service_new(
+    const char* path,
+    const char* name,
+    NfcHostServiceProcessFunc process,
+    void* user_data)
+{
+    NfcHostService* service = NULL;
+
+    if (path && g_variant_is_object_path(path) && process) {
+        NfcHostServiceObject* self = g_object_new(THIS_TYPE, NULL);
+        GError* error = NULL;
+
+        service = &self->pub;
+        service->path = self->path = g_strdup(path);
+        service->name = self->name = g_strdup(name ? name : "");
+        self->process = process;
+        self->process_data = user_data;
+        self->shared = g_slice_new0(NfcHostServiceShared);
+        self->shared->obj = self;
+        g_atomic_int_set(&self->shared->ref_count, 1);
+        g_mutex_init(&self->shared->mutex);
+
+        self->daemon = nfc_daemon_client_new();
+        self->daemon_event_id[DAEMON_PRESENT_CHANGED] =
+            nfc_daemon_client_add_property_handler(self->daemon,
+                NFC_DAEMON_PROPERTY_PRESENT,
+                nfc_host_service_daemon_presence_changed, self);
+
+        self->object = org_sailfishos_nfc_local_host_service_skeleton_new();
+        self->call_id[CALL_START] =
+            g_signal_connect(self->object, "handle-start",
+                G_CALLBACK(nfc_host_service_object_handle_start), self);
+        self->call_id[CALL_RESTART] =
+            g_signal_connect(self->object, "handle-restart",
+                G_CALLBACK(nfc_host_service_object_handle_restart), self);
+        self->call_id[CALL_STOP] =
+            g_signal_connect(self->object, "handle-stop",
+                G_CALLBACK(nfc_host_service_object_handle_stop), self);
+        self->call_id[CALL_PROCESS] =
+            g_signal_connect(self->object, "handle-process",
+                G_CALLBACK(nfc_host_service_object_handle_process), self);
+        self->call_id[CALL_RESPONSE_STATUS] =
+            g_signal_connect(self->object, "handle-response-status",
+                G_CALLBACK(nfc_host_service_object_handle_response_status),
+                self);
+
+        self->exported = g_dbus_interface_skeleton_export
+            (G_DBUS_INTERFACE_SKELETON(self->object),
+                nfc_daemon_client_connection(self->daemon), path, &error);
+
+        if (self->exported) {
+            GDEBUG("Exported %s", path);
+            nfc_host_service_try_register(self);
+        } else {
+            GERR("%s", GERRMSG(error));
+            g_error_free(error);
+        }
+    }
+    return service;
+}
+
+NfcHostService*
+nfc_host_service_ref(
+    NfcHostService* service)
+{
+    gutil_object_ref(nfc_host_service_object_cast(service));
+    return service;
+}
+
+void
+nfc_host_service_unref(
+    NfcHostService* service)
+{
+    gutil_object_unref(nfc_host_service_object_cast(service));
+}
+
+gulong
+nfc_host_service_add_property_handler(
+    NfcHostService* service,
+    NFC_HOST_SERVICE_PROPERTY property,
+    NfcHostServicePropertyFunc func,
+    void* user_data)
+{
+    NfcHostServiceObject* self = nfc_host_service_object_cast(service);
+
+    return G_LIKELY(self) ? nfc_client_base_add_property_handler(&self->base,
+        property, (NfcClientBasePropertyFunc) func, user_data) : 0;
+}
+
+gulong
+nfc_host_service_add_start_handler(
+    NfcHostService* service,
+    NfcHostServiceHostFunc func,
+    void* user_data)
+{
+    NfcHostServiceObject* self = nfc_host_service_object_cast(service);
+
+    return (G_LIKELY(self) && G_LIKELY(func)) ? g_signal_connect(self,
+        SIGNAL_START_NAME, G_CALLBACK(func), user_data) : 0;
+}
+
+gulong
+nfc_host_service_add_restart_handler(
+    NfcHostService* service,
+    NfcHostServiceHostFunc func,
+    void* user_data)
+{
+    NfcHostServiceObject* self = nfc_host_service_object_cast(service);
+
+    return (G_LIKELY(self) && G_LIKELY(func)) ? g_signal_connect(self,
+        SIGNAL_RESTART_NAME, G_CALLBACK(func), user_data) : 0;
+}
+
+gulong
+nfc_host_service_add_stop_handler(
+    NfcHostService* service,
+    NfcHostServiceHostFunc func,
+    void* user_data)
+{
+    NfcHostServiceObject* self = nfc_host_service_object_cast(service);
+
+    return (G_LIKELY(self) && G_LIKELY(func)) ? g_signal_connect(self,
+        SIGNAL_STOP_NAME, G_CALLBACK(func), user_data) : 0;
+}
+
+void
+nfc_host_service_remove_handler(
+    NfcHostService* service,
+    gulong id)
+{
+    if (G_LIKELY(id)) {
+        NfcHostServiceObject* self = nfc_host_service_object_cast(service);
+
+        if (G_LIKELY(self)) {
+            g_signal_handler_disconnect(self, id);
+        }
+    }
+}
+
+void
+nfc_host_service_remove_handlers(
+    NfcHostService* service,
+    gulong* ids,
+    guint n)
+{
+    gutil_disconnect_handlers(nfc_host_service_object_cast(service), ids, n);
+}
+
+guint
+nfc_host_service_add_app(
+    NfcHostService* service,
+    const GUtilData* aid,
+    NFC_HOST_APP_FLAGS flags,
+    NfcHostServiceProcessFunc process,
+    void* user_data,
+    GDestroyNotify destroy)
+{
+    NfcHostServiceObject* self = nfc_host_service_object_cast(service);
+
+    if (G_LIKELY(self) && aid && aid->size && process) {
+        NfcHostApp* app = g_slice_new0(NfcHostApp);
+        gboolean ok = TRUE;
+
+        if (!(flags & (NFC_HOST_APP_MATCH_EXACT|NFC_HOST_APP_MATCH_PREFIX))) {
+            flags |= NFC_HOST_APP_MATCH_EXACT;
+        }
+        g_atomic_int_set(&app->ref_count, 1);
+        app->aid = nfc_data_copy(aid->bytes, aid->size);
+        app->process = process;
+        app->user_data = user_data;
+        nfc_host_service_lock(self);
+        if (!self->aid_trie) {
+            self->aid_trie = nfc_aid_trie_new();
+            self->apps = g_hash_table_new_full(g_direct_hash,
+                g_direct_equal, NULL, nfc_host_app_unref);
+        }
+
+        /* Only take the slots which we actually got */
+        if (flags & NFC_HOST_APP_MATCH_EXACT) {
+            if (nfc_aid_trie_insert(self->aid_trie, aid, FALSE, app)) {
+                app->flags |= NFC_HOST_APP_MATCH_EXACT;
+            } else {
+                ok = FALSE;
+            }
+        }
+        if (ok && (flags & NFC_HOST_APP_MATCH_PREFIX)) {
+            if (nfc_aid_trie_insert(self->aid_trie, aid, TRUE, app)) {
+                app->flags |= NFC_HOST_APP_MATCH_PREFIX;
+            } else {
+                ok = FALSE;
+            }
+        }
+
+        if (ok) {
+            /* Zero id is reserved */
+            do {
+                app->id = ++self->last_app_id;
+            } while (!app->id || g_hash_table_contains(self->apps,
+                GUINT_TO_POINTER(app->id)));
+            app->destroy = destroy;
+            g_hash_table_insert(self->apps, GUINT_TO_POINTER(app->id), app);
+            nfc_host_service_unlock(self);
+            GDEBUG("App %u registered", app->id);
+            return app->id;
+        }
+
+        GWARN("AID is already taken");
+        nfc_host_service_remove_app_from_trie(self, app);
+        nfc_host_service_unlock(self);
+        nfc_host_app_unref(app);
+    }
+    /* Destroy callback is always invoked if we return zero */
+    if (destroy) {
+        destroy(user_data);
+    }
+    return 0;
+}
+
+void
+nfc_host_service_remove_app(
+    NfcHostService* service,
+    guint id)
+{
+    NfcHostServiceObject* self = nfc_host_service_object_cast(service);
+
+    if (G_LIKELY(self) && G_LIKELY(id) && self->apps) {
+        NfcHostApp* app;
+
+        nfc_host_service_lock(self);
+        app = g_hash_table_lookup(self->apps, GUINT_TO_POINTER(id));
+        if (app) {
+            GDEBUG("App %u unregistered", id);
+            if (self->selected_app == app) {
+                nfc_host_service_deselect_app(self);
+            }
+            nfc_host_service_remove_app_from_trie(self, app);
+            if (self->static_tables) {
+                g_hash_table_remove(self->static_tables,
+                    GUINT_TO_POINTER(id));
+            }
+            /* Steal the app to invoke its destroy callback unlocked */
+            nfc_host_app_ref(app);
+            g_hash_table_remove(self->apps, GUINT_TO_POINTER(id));
+        }
+        nfc_host_service_unlock(self);
+        if (app) {
+            nfc_host_app_unref(app);
+        }
+    }
+}
+
+gboolean
+nfc_host_service_set_static_responses(
+    NfcHostService* service,
+    guint app_id,
+    const NfcHostStaticResponse* responses,
+    guint count)
+{
+    NfcHostServiceObject* self = nfc_host_service_object_cast(service);
+
+    if (G_LIKELY(self) && (!app_id || (self->apps &&
+        g_hash_table_contains(self->apps, GUINT_TO_POINTER(app_id))))) {
+        NfcHostStaticTable* table = NULL;
+
+        if (responses && count) {
+            guint i;
+
+            table = g_slice_new0(NfcHostStaticTable);
+            table->entries = g_new0(NfcHostStaticEntry, count);
+            table->count = count;
+            for (i = 0; i < count; i++) {
+                const NfcHostStaticResponse* src = responses + i;
+                NfcHostStaticEntry* entry = table->entries + i;
+
+                entry->header = src->header;
+                entry->mask = src->mask;
+                if (src->data) {
+                    entry->data = nfc_data_copy(src->data->bytes,
+                        src->data->size);
+                }
+                entry->response = g_bytes_new(src->response.bytes,
+                    src->response.size);
+                entry->sw = src->sw;
+            }
+        }
+
+        nfc_host_service_lock(self);
+        if (table) {
+            if (!self->static_tables) {
+                self->static_tables = g_hash_table_new_full(g_direct_hash,
+                    g_direct_equal, NULL, nfc_host_static_table_free);
+            }
+            g_hash_table_insert(self->static_tables,
+                GUINT_TO_POINTER(app_id), table);
+        } else if (self->static_tables) {
+            g_hash_table_remove(self->static_tables,
+                GUINT_TO_POINTER(app_id));
+        }
+        nfc_host_service_unlock(self);
+
+        if (table && !self->filter_id) {
+            GDBusConnection* connection =
+                nfc_daemon_client_connection(self->daemon);
+
+            if (connection) {
+                g_object_ref(self->filter_connection = connection);
+                self->filter_id = g_dbus_connection_add_filter(connection,
+                    nfc_host_service_filter,
+                    nfc_host_service_shared_ref(self->shared),
+                    nfc_host_service_shared_unref);
+            }
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+NfcHostRequest*
+nfc_host_request_ref(
+    NfcHostRequest* request)
+{
+    NfcHostRequestPriv* priv = nfc_host_request_cast(request);
+
+    if (priv) {
+        GASSERT(priv->refcount > 0);
+        g_atomic_int_inc(&priv->refcount);
+    }
+    return request;
+}
+
+void
+nfc_host_request_unref(
+    NfcHostRequest* request)
+{
+    NfcHostRequestPriv* priv = nfc_host_request_cast(request);
+
+    if (priv) {
+        nfc_host_request_priv_unref(priv);
+    }
+}
+
+gboolean
+nfc_host_request_respond(
+    NfcHostRequest* request,
+    const GUtilData* data,
+    guint sw)
+{
+    NfcHostRequestPriv* priv = nfc_host_request_cast(request);
+
+    if (priv && priv->call) {
+        nfc_host_request_priv_complete(priv,
+            gutil_data_copy_as_variant(data), sw);
+        return TRUE;
+    }
+    /* Already responded */
+    return FALSE;
+}
+
+gboolean
+nfc_host_request_respond_bytes(
+    NfcHostRequest* request,
+    GBytes* data,
+    guint sw)
+{
+    NfcHostRequestPriv* priv = nfc_host_request_cast(request);
+
+    if (priv && priv->call) {
+        GVariant* response;
+
+        if (data) {
+            gsize size = 0;
+            gconstpointer bytes = g_bytes_get_data(data, &size);
+
+            /* The response data is referenced rather than copied */
+            response = g_variant_new_from_data(G_VARIANT_TYPE_BYTESTRING,
+                bytes, size, TRUE, (GDestroyNotify) g_bytes_unref,
+                g_bytes_ref(data));
+        } else {
+            response = g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE,
+                NULL, 0, 1);
+        }
+        nfc_host_request_priv_complete(priv, response, sw);
+        return TRUE;
+    }
+    /* Already responded */
+    return FALSE;
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+nfc_host_service_object_init(
+    NfcHostServiceObject* self)
+{
+}
+
+static
+void
+nfc_host_service_object_finalize(
+    GObject* object)
+{
+    NfcHostServiceObject* self = THIS(object);
+
+    GVERBOSE_("%s", self->path);
+    if (self->exported) {
+        nfc_daemon_client_unregister_local_host_service(self->daemon,
+            self->path, NULL, NULL, NULL, NULL);
+        g_dbus_interface_skeleton_unexport
+            (G_DBUS_INTERFACE_SKELETON(self->object));
+    }
+    gutil_disconnect_handlers(self->object, self->call_id, CALL_COUNT);
+    g_object_unref(self->object);
+
+    /* Detach the filter from the object */
+    nfc_host_service_lock(self);
+    self->shared->obj = NULL;
+    nfc_host_service_unlock(self);
+    if (self->filter_id) {
+        g_dbus_connection_remove_filter(self->filter_connection,
+            self->filter_id);
+        g_object_unref(self->filter_connection);
+    }
+    nfc_host_service_shared_unref(self->shared);
+    if (self->static_tables) {
+        g_hash_table_destroy(self->static_tables);
+    }
+    if (self->apps) {
+        g_hash_table_destroy(self->apps);
+    }
+    nfc_aid_trie_free(self->aid_trie);
+    g_free(self->path);
+    g_free(self->name);
+    nfc_daemon_client_remove_all_handlers(self->daemon, self->daemon_event_id);
+    nfc_daemon_client_unref(self->daemon);
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+nfc_host_service_object_class_init(
+    NfcHostServiceObjectClass* klass)
+{
+    GType type = G_OBJECT_CLASS_TYPE(klass);
+
+    G_OBJECT_CLASS(klass)->finalize = nfc_host_service_object_finalize;
+    klass->public_offset = G_STRUCT_OFFSET(NfcHostServiceObject, pub);
+
+    nfc_host_service_signals[SIGNAL_START] =
+        g_signal_new(SIGNAL_START_NAME, type,
+            G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE, 1,
+            G_TYPE_STRING);
+    nfc_host_service_signals[SIGNAL_RESTART] =
+        g_signal_new(SIGNAL_RESTART_NAME, type,
+            G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE, 1,
+            G_TYPE_STRING);
+    nfc_host_service_signals[SIGNAL_STOP] =
+        g_signal_new(SIGNAL_STOP_NAME, type,
+            G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE, 1,
+            G_TYPE_STRING);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -37,10 +37,15 @@
  * any official policies, either expressed or implied.
  */
 
-#include "nfcdc_isodep.h"
+#include "nfcdc_isodep_p.h"
 #include "nfcdc_base.h"
 #include "nfcdc_dbus.h"
+#include "nfcdc_error.h"
 #include "nfcdc_log.h"
+#include "nfcdc_resync_p.h"
+#include "nfcdc_retry_p.h"
+#include "nfcdc_stats_p.h"
+#include "nfcdc_trace_p.h"
 #include "nfcdc_tag_p.h"
 #include "nfcdc_util_p.h"
 
@@ -60,8 +65,16 @@ typedef struct nfc_isodep_client_object {
     OrgSailfishosNfcIsoDep* proxy;
     GHashTable* act_params;
     gboolean proxy_initializing;
+    gint64 get_all_start;
     gint version;
     const char* name;
+    GBytes* selected_aid;
+    GBytes* selected_fci;
+    guint selected_le;
+    guint selected_lock;
+    guint select_seq;
+    NfcResync* resync;
+    NfcClientRetry retry;
 } NfcIsoDepClientObject;
 
 #define PARENT_CLASS nfc_isodep_client_object_parent_class
@@ -105,10 +118,37 @@ struct nfc_isodep_client_call {
     void* user_data;
     GCancellable* cancel;
     gulong cancel_id;
+    GBytes* fci;
+    guint le;
+    guint deadline_id;
+    guint queue_id;
+    guint8 cla, ins, p1, p2;
+    GVariant* data;
+    gint64 start;
 };
 
+typedef struct nfc_isodep_client_session {
+    NfcIsoDepClientObject* object;
+    NfcIsoDepSessionFunc complete;
+    GDestroyNotify destroy;
+    void* user_data;
+    GCancellable* cancel;
+    gulong cancel_id;
+    gint pending;
+    NfcTagClientLock* lock;
+    GBytes* response;
+    guint sw;
+    GError* error;
+    GBytes* aid;
+    guint le;
+    guint select_seq;
+} NfcIsoDepClientSession;
+
 #define NFC_ISODEP_ACT_PARAM_UNKNOWN NFC_ISODEP_ACT_PARAM_COUNT
 
+#define NFC_ISODEP_INS_SELECT (0xa4)
+#define NFC_ISODEP_SELECT_BY_NAME (0x04)
+
 static GHashTable* nfc_isodep_client_table;
 
 static
@@ -130,6 +170,15 @@ nfc_isodep_client_object_cast(
         NULL;
 }
 
+static
+void
+nfc_isodep_client_init_done(
+    NfcIsoDepClientObject* self)
+{
+    self->proxy_initializing = FALSE;
+    nfc_resync_done(&self->resync);
+}
+
 static
 int
 nfc_isodep_client_act_param_key(
@@ -191,6 +240,34 @@ nfc_isodep_client_call_new(
     return call;
 }
 
+static
+void
+nfc_isodep_client_call_free(
+    gpointer user_data)
+{
+    NfcIsoDepClientCall* call = user_data;
+
+    GASSERT(!call->queue_id);
+    if (call->deadline_id) {
+        g_source_remove(call->deadline_id);
+    }
+    if (call->cancel) {
+        g_signal_handler_disconnect(call->cancel, call->cancel_id);
+        g_object_unref(call->cancel);
+    }
+    if (call->destroy) {
+        call->destroy(call->user_data);
+    }
+    if (call->fci) {
+        g_bytes_unref(call->fci);
+    }
+    if (call->data) {
+        g_variant_unref(call->data);
+    }
+    g_object_unref(call->object);
+    gutil_slice_free(call);
+}
+
 static
 void
 nfc_isodep_client_call_done(
@@ -207,14 +284,117 @@ nfc_isodep_client_call_done(
         call->cancel = NULL;
     }
     call->finish(ORG_SAILFISHOS_NFC_ISO_DEP(proxy), call, result, &error);
-    if (call->destroy) {
-        call->destroy(call->user_data);
-    }
     if (error) {
         g_error_free(error);
     }
-    g_object_unref(call->object);
-    gutil_slice_free(call);
+    /* Let the next one go */
+    nfc_scheduler_finish(nfc_tag_client_scheduler(call->object->tag));
+    nfc_isodep_client_call_free(call);
+}
+
+static
+GError*
+nfc_isodep_client_call_aborted(
+    void)
+{
+    return g_error_new_literal(NFCDC_ERROR, NFCDC_ERROR_ABORTED,
+        "ISO-DEP target is gone");
+}
+
+static
+gboolean
+nfc_isodep_client_apdu_is_select_by_name(
+    const NfcIsoDepApdu* apdu)
+{
+    /*
+     * SELECT by DF name on the basic channel, first or only occurrence,
+     * FCI requested. That's what applications normally send to select
+     * an applet.
+     */
+    return !apdu->cla && apdu->ins == NFC_ISODEP_INS_SELECT &&
+        apdu->p1 == NFC_ISODEP_SELECT_BY_NAME && !apdu->p2 &&
+        apdu->data.size > 0;
+}
+
+static
+void
+nfc_isodep_client_drop_selection(
+    NfcIsoDepClientObject* self)
+{
+    /* This also invalidates SELECTs which are still in progress */
+    self->select_seq++;
+    if (self->selected_aid) {
+        GDEBUG("%s: forgetting selected AID", self->name);
+        g_bytes_unref(self->selected_aid);
+        g_bytes_unref(self->selected_fci);
+        self->selected_aid = NULL;
+        self->selected_fci = NULL;
+        self->selected_le = 0;
+        self->selected_lock = 0;
+    }
+}
+
+static
+GBytes*
+nfc_isodep_client_selected_fci(
+    NfcIsoDepClientObject* self,
+    const NfcIsoDepApdu* apdu)
+{
+    /*
+     * The cached FCI is only good while the lock is held. Nobody else
+     * can talk to the card in the meantime.
+     */
+    if (self->selected_aid && self->selected_le == apdu->le &&
+        self->selected_lock == nfc_tag_client_lock_id(self->tag)) {
+        GUtilData aid;
+
+        aid.bytes = g_bytes_get_data(self->selected_aid, &aid.size);
+        if (gutil_data_equal(&aid, &apdu->data)) {
+            return self->selected_fci;
+        }
+    }
+    return NULL;
+}
+
+static
+void
+nfc_isodep_client_session_selected_aid(
+    NfcIsoDepClientObject* self,
+    NfcIsoDepClientSession* session)
+{
+    /* Nothing must have been selected since the session's SELECT */
+    if (session->aid && session->sw == NFC_ISODEP_SW_OK &&
+        session->select_seq == self->select_seq &&
+        session->lock == nfc_tag_client_get_lock(self->tag)) {
+        GDEBUG("%s: remembering selected AID", self->name);
+        if (self->selected_aid) {
+            g_bytes_unref(self->selected_aid);
+            g_bytes_unref(self->selected_fci);
+        }
+        self->selected_aid = g_bytes_ref(session->aid);
+        self->selected_fci = g_bytes_ref(session->response);
+        self->selected_le = session->le;
+        self->selected_lock = nfc_tag_client_lock_id(self->tag);
+    }
+}
+
+static
+gboolean
+nfc_isodep_client_select_idle(
+    gpointer user_data)
+{
+    NfcIsoDepClientCall* call = user_data;
+
+    if (call->complete.transmit) {
+        NfcIsoDepTransmitFunc callback = call->complete.transmit;
+        GUtilData fci;
+
+        fci.bytes = g_bytes_get_data(call->fci, &fci.size);
+        call->complete.transmit = NULL;
+        callback(&call->object->pub, &fci, NFC_ISODEP_SW_OK, NULL,
+            call->user_data);
+    }
+    return G_SOURCE_REMOVE;
 }
 
 static
@@ -229,19 +409,22 @@ nfc_isodep_client_transmit_finish(
     guchar sw1 = 0, sw2 = 0;
     gboolean ok = org_sailfishos_nfc_iso_dep_call_transmit_finish(proxy,
         &response, &sw1, &sw2, result, error);
+    const GUtilData* resp;
+    GUtilData d;
 
+    nfc_client_stats_finish(call->object->pub.path, NFC_CLIENT_OP_TRANSMIT,
+        call->start, *error);
+    NFCDC_TRACE3(transmit__done, call, NFC_ISODEP_SW(sw1, sw2), ok);
+    if (ok) {
+        d.bytes = g_variant_get_fixed_array(response, &d.size, 1);
+        resp = &d;
+    } else {
+        resp = NULL;
+    }
     if (call->complete.transmit) {
         NfcIsoDepTransmitFunc callback = call->complete.transmit;
         NfcIsoDepClient* isodep = &call->object->pub;
-        const GUtilData* resp;
-        GUtilData d;
-
-        if (ok) {
-            d.bytes = g_variant_get_fixed_array(response, &d.size, 1);
-            resp = &d;
-        } else {
-            resp = NULL;
-        }
+
         call->complete.transmit = NULL;
         callback(isodep, resp, NFC_ISODEP_SW(sw1, sw2), *error, call->user_data);
     }
@@ -253,6 +436,74 @@ nfc_isodep_client_transmit_finish(
     }
 }
 
+static
+void
+nfc_isodep_client_transmit_failed(
+    NfcIsoDepClientCall* call,
+    GError* error)
+{
+    NfcIsoDepClientObject* self = call->object;
+
+    GWARN("%s: %s", self->name, error->message);
+    if (call->complete.transmit) {
+        NfcIsoDepTransmitFunc callback = call->complete.transmit;
+
+        call->complete.transmit = NULL;
+        callback(&self->pub, NULL, 0, error, call->user_data);
+    }
+    g_error_free(error);
+}
+
+static
+gboolean
+nfc_isodep_client_transmit_start(
+    gpointer user_data)
+{
+    NfcIsoDepClientCall* call = user_data;
+    NfcIsoDepClientObject* self = call->object;
+
+    if (self->proxy) {
+        call->start = nfc_client_stats_start();
+        NFCDC_TRACE3(transmit__start, call, self->pub.path, call->ins);
+        org_sailfishos_nfc_iso_dep_call_transmit(self->proxy, call->cla,
+            call->ins, call->p1, call->p2, call->data, call->le,
+            call->cancel, nfc_isodep_client_call_done, call);
+        return TRUE;
+    } else {
+        /* The target is gone while the call was waiting for its turn */
+        nfc_isodep_client_transmit_failed(call,
+            nfc_isodep_client_call_aborted());
+        nfc_isodep_client_call_free(call);
+        return FALSE;
+    }
+}
+
+static
+gboolean
+nfc_isodep_client_transmit_deadline(
+    gpointer user_data)
+{
+    NfcIsoDepClientCall* call = user_data;
+    NfcIsoDepClientObject* self = call->object;
+
+    call->deadline_id = 0;
+    nfc_isodep_client_transmit_failed(call, nfc_deadline_error());
+    if (call->queue_id) {
+        /* It hasn't been submitted yet, there's nothing to abort */
+        nfc_scheduler_cancel(nfc_tag_client_scheduler(self->tag),
+            call->queue_id);
+        nfc_isodep_client_call_free(call);
+    } else {
+        /*
+         * Deactivating the tag is the only way to make sure that the
+         * card which got stuck doesn't hold up everything else.
+         */
+        nfc_isodep_client_drop_selection(self);
+        nfc_tag_client_deactivate(self->tag, NULL, NULL, NULL, NULL);
+    }
+    return G_SOURCE_REMOVE;
+}
+
 static
 gboolean
 nfc_isodep_client_reset_finish(
@@ -273,6 +524,184 @@ nfc_isodep_client_reset_finish(
     return ok;
 }
 
+static
+gboolean
+nfc_isodep_client_reset_start(
+    gpointer user_data)
+{
+    NfcIsoDepClientCall* call = user_data;
+    NfcIsoDepClientObject* self = call->object;
+
+    if (self->proxy) {
+        org_sailfishos_nfc_iso_dep_call_reset(self->proxy, call->cancel,
+            nfc_isodep_client_call_done, call);
+        return TRUE;
+    } else {
+        if (call->complete.generic) {
+            NfcIsoDepCompleteFunc complete = call->complete.generic;
+            GError* error = nfc_isodep_client_call_aborted();
+
+            call->complete.generic = NULL;
+            complete(&self->pub, error, call->user_data);
+            g_error_free(error);
+        }
+        nfc_isodep_client_call_free(call);
+        return FALSE;
+    }
+}
+
+static
+void
+nfc_isodep_client_session_cancelled(
+    GCancellable* cancel,
+    NfcIsoDepClientSession* session)
+{
+    session->complete = NULL;
+}
+
+static
+NfcIsoDepClientSession*
+nfc_isodep_client_session_new(
+    NfcIsoDepClientObject* self,
+    GCancellable* cancel,
+    NfcIsoDepSessionFunc complete,
+    void* user_data,
+    GDestroyNotify destroy)
+{
+    NfcIsoDepClientSession* session = g_slice_new0(NfcIsoDepClientSession);
+
+    /* One reference for Acquire, one for Transmit and one for the caller */
+    g_atomic_int_set(&session->pending, 3);
+    g_object_ref(session->object = self);
+    session->complete = complete;
+    session->user_data = user_data;
+    session->destroy = destroy;
+    if (cancel) {
+        g_object_ref(session->cancel = cancel);
+        session->cancel_id = g_cancellable_connect(cancel,
+            G_CALLBACK(nfc_isodep_client_session_cancelled), session, NULL);
+    }
+    return session;
+}
+
+static
+void
+nfc_isodep_client_session_set_error(
+    NfcIsoDepClientSession* session,
+    const GError* error)
+{
+    /* Only the first error gets reported */
+    if (!session->error) {
+        session->error = g_error_copy(error);
+    }
+}
+
+static
+void
+nfc_isodep_client_session_unref(
+    gpointer user_data)
+{
+    NfcIsoDepClientSession* session = user_data;
+
+    if (g_atomic_int_dec_and_test(&session->pending)) {
+        NfcIsoDepClientObject* self = session->object;
+
+        if (session->cancel) {
+            g_signal_handler_disconnect(session->cancel, session->cancel_id);
+            g_object_unref(session->cancel);
+        }
+        if (!session->error && (!session->lock || !session->response)) {
+            /* One of the calls couldn't even be submitted */
+            session->error = g_error_new_literal(NFCDC_ERROR,
+                NFCDC_ERROR_FAILED, "Failed to open ISO-DEP session");
+        } else if (!session->error) {
+            nfc_isodep_client_session_selected_aid(self, session);
+        }
+        if (session->complete) {
+            NfcIsoDepSessionFunc complete = session->complete;
+
+            session->complete = NULL;
+            if (session->error) {
+                GDEBUG("%s: failed to open session", self->name);
+                complete(&self->pub, NULL, NULL, 0, session->error,
+                    session->user_data);
+            } else {
+                GUtilData resp;
+
+                resp.bytes = g_bytes_get_data(session->response, &resp.size);
+                complete(&self->pub, session->lock, &resp, session->sw,
+                    NULL, session->user_data);
+            }
+        }
+        if (session->destroy) {
+            session->destroy(session->user_data);
+        }
+        /* The lock is dropped unless the callback has taken a reference */
+        nfc_tag_client_lock_unref(session->lock);
+        if (session->response) {
+            g_bytes_unref(session->response);
+        }
+        if (session->error) {
+            g_error_free(session->error);
+        }
+        if (session->aid) {
+            g_bytes_unref(session->aid);
+        }
+        g_object_unref(self);
+        gutil_slice_free(session);
+    }
+}
+
+static
+void
+nfc_isodep_client_session_locked(
+    NfcTagClient* tag,
+    NfcTagClientLock* lock,
+    const GError* error,
+    void* user_data)
+{
+    NfcIsoDepClientSession* session = user_data;
+
+    if (lock) {
+        session->lock = nfc_tag_client_lock_ref(lock);
+    } else {
+        nfc_isodep_client_session_set_error(session, error);
+    }
+}
+
+static
+void
+nfc_isodep_client_session_selected(
+    NfcIsoDepClient* isodep,
+    const GUtilData* response,
+    guint sw,
+    const GError* error,
+    void* user_data)
+{
+    NfcIsoDepClientSession* session = user_data;
+
+    if (response) {
+        session->response = g_bytes_new(response->bytes, response->size);
+        session->sw = sw;
+    } else {
+        nfc_isodep_client_session_set_error(session, error);
+    }
+}
+
+static
+void
+nfc_isodep_client_set_retrying(
+    NfcIsoDepClientObject* self,
+    gboolean retrying)
+{
+    NfcIsoDepClient* pub = &self->pub;
+
+    if (pub->retrying != retrying) {
+        pub->retrying = retrying;
+        nfc_isodep_client_queue_signal(self, RETRYING);
+    }
+}
+
 static
 void
 nfc_isodep_client_update_valid_and_present(
@@ -298,6 +727,14 @@ nfc_isodep_client_update_valid_and_present(
         pub->present = present;
         nfc_isodep_client_queue_signal(self, PRESENT);
     }
+    if (!present) {
+        nfc_isodep_client_drop_selection(self);
+    }
+    if (self->proxy && !self->proxy_initializing) {
+        /* Successfully initialized */
+        nfc_client_retry_reset(&self->retry);
+        nfc_isodep_client_set_retrying(self, FALSE);
+    }
 }
 
 static
@@ -308,6 +745,7 @@ nfc_isodep_client_drop_proxy(
     NfcIsoDepClient* pub = &self->pub;
 
     GASSERT(!self->proxy_initializing);
+    nfc_isodep_client_drop_selection(self);
     if (self->proxy) {
         g_object_unref(self->proxy);
         self->proxy = NULL;
@@ -332,11 +770,35 @@ nfc_isodep_client_update(
             nfc_isodep_client_reinit(self);
         }
     } else if (!self->proxy_initializing) {
+        nfc_client_retry_reset(&self->retry);
+        nfc_isodep_client_set_retrying(self, FALSE);
         nfc_isodep_client_drop_proxy(self);
     }
     nfc_isodep_client_update_valid_and_present(self);
 }
 
+static
+void
+nfc_isodep_client_retry(
+    GObject* object)
+{
+    NfcIsoDepClientObject* self = THIS(object);
+
+    nfc_isodep_client_update(self);
+    nfc_isodep_client_emit_queued_signals(self);
+}
+
+static
+void
+nfc_isodep_client_init_failed(
+    NfcIsoDepClientObject* self)
+{
+    nfc_isodep_client_drop_proxy(self);
+    nfc_isodep_client_set_retrying(self,
+        nfc_client_retry_schedule(&self->retry, G_OBJECT(self),
+            nfc_isodep_client_retry));
+}
+
 static
 void
 nfc_isodep_client_tag_changed(
@@ -359,17 +821,22 @@ nfc_isodep_client_init_5(
 {
     NfcIsoDepClientObject* self = THIS(user_data);
     GError* error = NULL;
+    gboolean ok;
     GVariant* dict = NULL;
     int version = 0;
 
     GASSERT(self->proxy_initializing);
-    self->proxy_initializing = FALSE;
-    if (!org_sailfishos_nfc_iso_dep_call_get_all2_finish(self->proxy,
-        &version, &dict, result, &error)) {
+    nfc_isodep_client_init_done(self);
+    ok = org_sailfishos_nfc_iso_dep_call_get_all2_finish(self->proxy,
+        &version, &dict, result, &error);
+    nfc_client_stats_finish(self->pub.path, NFC_CLIENT_OP_ISODEP_GET_ALL2,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, self->pub.path,
+        NFC_CLIENT_OP_ISODEP_GET_ALL2, ok);
+    if (!ok) {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
-        /* Need to retry? */
-        nfc_isodep_client_drop_proxy(self);
+        nfc_isodep_client_init_failed(self);
     } else {
         GDEBUG("%s: ISO-DEP activation parameters", self->name);
         self->act_params = nfc_parse_dict(self->act_params, dict,
@@ -391,23 +858,30 @@ nfc_isodep_client_init_4(
 {
     NfcIsoDepClientObject* self = THIS(user_data);
     GError* error = NULL;
+    gboolean ok;
     int version = 0;
 
     GASSERT(self->proxy_initializing);
-    if (!org_sailfishos_nfc_iso_dep_call_get_all_finish(self->proxy,
-        &version, result, &error)) {
+    ok = org_sailfishos_nfc_iso_dep_call_get_all_finish(self->proxy,
+        &version, result, &error);
+    nfc_client_stats_finish(self->pub.path, NFC_CLIENT_OP_ISODEP_GET_ALL,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, self->pub.path, NFC_CLIENT_OP_ISODEP_GET_ALL, ok);
+    if (!ok) {
         GERR("%s", GERRMSG(error));
-        self->proxy_initializing = FALSE;
+        nfc_isodep_client_init_done(self);
         g_error_free(error);
-        /* Need to retry? */
-        nfc_isodep_client_drop_proxy(self);
+        nfc_isodep_client_init_failed(self);
     } else if (version > 1) {
         /* Version 2 or greater */
+        self->get_all_start = nfc_client_stats_start();
+        NFCDC_TRACE2(init__start, self->pub.path,
+            NFC_CLIENT_OP_ISODEP_GET_ALL2);
         org_sailfishos_nfc_iso_dep_call_get_all2(self->proxy, NULL,
             nfc_isodep_client_init_5, g_object_ref(self));
     } else {
         self->version = version;
-        self->proxy_initializing = FALSE;
+        nfc_isodep_client_init_done(self);
         nfc_isodep_client_update_valid_and_present(self);
     }
     nfc_isodep_client_emit_queued_signals(self);
@@ -428,12 +902,16 @@ nfc_isodep_client_init_3(
     GASSERT(self->proxy_initializing);
     self->proxy = org_sailfishos_nfc_iso_dep_proxy_new_finish(result, &error);
     if (self->proxy) {
+        self->get_all_start = nfc_client_stats_start();
+        NFCDC_TRACE2(init__start, self->pub.path,
+            NFC_CLIENT_OP_ISODEP_GET_ALL);
         org_sailfishos_nfc_iso_dep_call_get_all(self->proxy, NULL,
             nfc_isodep_client_init_4, g_object_ref(self));
     } else {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
-        self->proxy_initializing = FALSE;
+        nfc_isodep_client_init_done(self);
+        nfc_isodep_client_init_failed(self);
         nfc_isodep_client_update_valid_and_present(self);
         nfc_isodep_client_emit_queued_signals(self);
     }
@@ -473,6 +951,14 @@ nfc_isodep_client_init_1(
     g_object_unref(self);
 }
         
+static
+void
+nfc_isodep_client_resync(
+    GObject* object)
+{
+    nfc_isodep_client_init_2(THIS(object));
+}
+
 static
 void
 nfc_isodep_client_reinit(
@@ -480,7 +966,19 @@ nfc_isodep_client_reinit(
 {
     GASSERT(!self->proxy_initializing);
     self->proxy_initializing = TRUE;
-    nfc_isodep_client_init_2(self);
+    nfc_resync_submit(&self->resync, G_OBJECT(self), nfc_isodep_client_resync);
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+guint
+nfc_isodep_client_count(
+    void)
+{
+    return nfc_isodep_client_table ?
+        g_hash_table_size(nfc_isodep_client_table) : 0;
 }
 
 /*==========================================================================*
@@ -516,7 +1014,7 @@ nfc_isodep_client_new(
                 obj->tag = nfc_tag_client_new(path);
                 obj->tag_event_id =
                     nfc_tag_client_add_property_handler(obj->tag,
-                        NFC_TAG_PROPERTY_VALID,
+                        NFC_TAG_PROPERTY_ANY,
                         nfc_isodep_client_tag_changed, obj);
                 obj->connection = nfc_tag_client_connection(obj->tag);
                 if (obj->connection) {
@@ -578,18 +1076,75 @@ nfc_isodep_client_transmit(
     NfcIsoDepTransmitFunc complete,
     void* user_data,
     GDestroyNotify destroy)
+{
+    return nfc_isodep_client_transmit_with_deadline(isodep, apdu, 0, cancel,
+        complete, user_data, destroy);
+}
+
+gboolean
+nfc_isodep_client_transmit_with_deadline(
+    NfcIsoDepClient* isodep,
+    const NfcIsoDepApdu* apdu,
+    gint64 deadline,
+    GCancellable* cancel,
+    NfcIsoDepTransmitFunc complete,
+    void* user_data,
+    GDestroyNotify destroy) /* Since 1.3.0 */
+{
+    return nfc_isodep_client_transmit_with_priority(isodep, apdu,
+        NFC_CALL_PRIORITY_DEFAULT, deadline, cancel, complete, user_data,
+        destroy);
+}
+
+gboolean
+nfc_isodep_client_transmit_with_priority(
+    NfcIsoDepClient* isodep,
+    const NfcIsoDepApdu* apdu,
+    NFC_CALL_PRIORITY priority,
+    gint64 deadline,
+    GCancellable* cancel,
+    NfcIsoDepTransmitFunc complete,
+    void* user_data,
+    GDestroyNotify destroy) /* Since 1.3.0 */
 {
     NfcIsoDepClientObject* self = nfc_isodep_client_object_cast(isodep);
 
     if (self && apdu && isodep->valid && isodep->present &&
-        (complete || destroy) &&
+        (complete || destroy) && !nfc_deadline_expired(deadline) &&
         (!cancel || !g_cancellable_is_cancelled(cancel))) {
-        org_sailfishos_nfc_iso_dep_call_transmit(self->proxy,
-            apdu->cla, apdu->ins, apdu->p1, apdu->p2,
-            gutil_data_copy_as_variant(&apdu->data), apdu->le, cancel,
-            nfc_isodep_client_call_done, nfc_isodep_client_call_new(self,
-                nfc_isodep_client_transmit_finish, cancel,
-                G_CALLBACK(complete), user_data, destroy));
+        NfcIsoDepClientCall* call = nfc_isodep_client_call_new(self,
+            nfc_isodep_client_transmit_finish, cancel,
+            G_CALLBACK(complete), user_data, destroy);
+
+        if (nfc_isodep_client_apdu_is_select_by_name(apdu)) {
+            GBytes* fci = nfc_isodep_client_selected_fci(self, apdu);
+
+            if (fci) {
+                /* This applet is already selected */
+                GDEBUG("%s: AID is already selected", self->name);
+                call->fci = g_bytes_ref(fci);
+                g_idle_add_full(G_PRIORITY_DEFAULT,
+                    nfc_isodep_client_select_idle, call,
+                    nfc_isodep_client_call_free);
+                return TRUE;
+            }
+
+        }
+        if (apdu->ins == NFC_ISODEP_INS_SELECT) {
+            /* This SELECT may change the current selection */
+            nfc_isodep_client_drop_selection(self);
+        }
+        call->cla = apdu->cla;
+        call->ins = apdu->ins;
+        call->p1 = apdu->p1;
+        call->p2 = apdu->p2;
+        call->le = apdu->le;
+        call->data = g_variant_ref_sink(gutil_data_copy_as_variant
+            (&apdu->data));
+        call->deadline_id = nfc_deadline_timeout_add(deadline,
+            nfc_isodep_client_transmit_deadline, call);
+        nfc_scheduler_submit(nfc_tag_client_scheduler(self->tag), priority,
+            nfc_isodep_client_transmit_start, call, &call->queue_id);
         return TRUE;
     } else {
         /* Destroy callback is always invoked even if we return FALSE */
@@ -613,10 +1168,64 @@ nfc_isodep_reset(
     /* Reset call requires org.sailfishos.nfc.IsoDep interface version 3 */
     if (G_LIKELY(self) && self->version >= 3 &&
         (!cancel || !g_cancellable_is_cancelled(cancel))) {
-        org_sailfishos_nfc_iso_dep_call_reset(self->proxy, cancel,
-            nfc_isodep_client_call_done, nfc_isodep_client_call_new(self,
-                nfc_isodep_client_reset_finish, cancel,
-                G_CALLBACK(complete), user_data, destroy));
+        NfcIsoDepClientCall* call = nfc_isodep_client_call_new(self,
+            nfc_isodep_client_reset_finish, cancel, G_CALLBACK(complete),
+            user_data, destroy);
+
+        /* Reset deselects whatever has been selected */
+        nfc_isodep_client_drop_selection(self);
+        nfc_scheduler_submit(nfc_tag_client_scheduler(self->tag),
+            NFC_CALL_PRIORITY_DEFAULT, nfc_isodep_client_reset_start, call,
+            &call->queue_id);
+        return TRUE;
+    } else {
+        /* Destroy callback is always invoked even if we return FALSE */
+        if (destroy) {
+            destroy(user_data);
+        }
+        return FALSE;
+    }
+}
+
+gboolean
+nfc_isodep_client_open_session(
+    NfcIsoDepClient* isodep,
+    const NfcIsoDepApdu* select,
+    gboolean wait,
+    GCancellable* cancel,
+    NfcIsoDepSessionFunc complete,
+    void* user_data,
+    GDestroyNotify destroy) /* Since 1.3.0 */
+{
+    NfcIsoDepClientObject* self = nfc_isodep_client_object_cast(isodep);
+
+    if (self && select && isodep->valid && isodep->present &&
+        (complete || destroy) &&
+        (!cancel || !g_cancellable_is_cancelled(cancel))) {
+        NfcIsoDepClientSession* session = nfc_isodep_client_session_new(self,
+            cancel, complete, user_data, destroy);
+
+        /*
+         * Both calls go through the same D-Bus connection, and D-Bus
+         * preserves the message order. Which means that there's no need
+         * to wait for Acquire to complete before submitting the SELECT,
+         * nfcd will process them in the same order anyway. That saves
+         * us one round trip.
+         */
+        nfc_tag_client_acquire_lock(self->tag, wait, cancel,
+            nfc_isodep_client_session_locked, session,
+            nfc_isodep_client_session_unref);
+        if (nfc_isodep_client_apdu_is_select_by_name(select)) {
+            session->aid = g_bytes_new(select->data.bytes,
+                select->data.size);
+            session->le = select->le;
+        }
+        nfc_isodep_client_transmit(isodep, select, cancel,
+            nfc_isodep_client_session_selected, session,
+            nfc_isodep_client_session_unref);
+        /* Changes if anything gets selected after this SELECT */
+        session->select_seq = self->select_seq;
+        nfc_isodep_client_session_unref(session);
         return TRUE;
     } else {
         /* Destroy callback is always invoked even if we return FALSE */
@@ -683,7 +1292,9 @@ nfc_isodep_client_object_finalize(
     NfcIsoDepClient* pub = &self->pub;
 
     GVERBOSE_("%s", pub->path);
+    nfc_client_retry_reset(&self->retry);
     nfc_isodep_client_drop_proxy(self);
+    nfc_isodep_client_drop_selection(self);
     nfc_tag_client_remove_handler(self->tag, self->tag_event_id);
     nfc_tag_client_unref(self->tag);
     gutil_object_unref(self->connection);
@@ -35,13 +35,152 @@
  * any official policies, either expressed or implied.
  */
 
+#include "nfcdc_debug.h"
 #include "nfcdc_log.h"
 
 /* Log module */
 GLOG_MODULE_DEFINE("nfc-client");
 
+#define NFCDC_RING_SLOTS (256)
+#define NFCDC_RING_LINE (120)
+
+typedef struct nfcdc_ring_slot {
+    gint seq;   /* Odd while the slot is being written */
+    gint64 time;
+    char line[NFCDC_RING_LINE];
+} NfcdcRingSlot;
+
+static gint nfcdc_ring_enabled = FALSE;
+static gint nfcdc_ring_head = 0;
+static NfcdcRingSlot nfcdc_ring[NFCDC_RING_SLOTS];
+static gint nfcdc_log_rate = 0;
+
 #if GUTIL_LOG_DEBUG
 
+typedef struct nfcdc_log_limit {
+    gint window;        /* Monotonic time in seconds */
+    gint count;         /* Lines logged in this window */
+    gint suppressed;    /* Lines dropped in this window */
+} NfcdcLogLimit;
+
+typedef struct nfcdc_log_buf {
+    GString* hex;
+    GString* line;
+} NfcdcLogBuf;
+
+static NfcdcLogLimit nfcdc_log_limits[NFCDC_LOG_CATEGORY_COUNT];
+
+static const char* const nfcdc_log_category_names[] = {
+    "list", "data", "parameter"
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(nfcdc_log_category_names) ==
+    NFCDC_LOG_CATEGORY_COUNT);
+
+static
+void
+nfcdc_log_buf_free(
+    gpointer data)
+{
+    NfcdcLogBuf* buf = data;
+
+    g_string_free(buf->hex, TRUE);
+    g_string_free(buf->line, TRUE);
+    g_slice_free(NfcdcLogBuf, buf);
+}
+
+static GPrivate nfcdc_log_buf_key = G_PRIVATE_INIT(nfcdc_log_buf_free);
+
+/* Per-thread buffers, reused by all dumps made by the thread */
+static
+NfcdcLogBuf*
+nfcdc_log_buf(
+    void)
+{
+    NfcdcLogBuf* buf = g_private_get(&nfcdc_log_buf_key);
+
+    if (!buf) {
+        buf = g_slice_new(NfcdcLogBuf);
+        buf->hex = g_string_sized_new(64);
+        buf->line = g_string_sized_new(128);
+        g_private_set(&nfcdc_log_buf_key, buf);
+    }
+    return buf;
+}
+
+static
+void
+nfcdc_ring_put(
+    const char* line)
+{
+    const guint pos = (guint) g_atomic_int_add(&nfcdc_ring_head, 1);
+    NfcdcRingSlot* slot = nfcdc_ring + (pos % NFCDC_RING_SLOTS);
+
+    g_atomic_int_inc(&slot->seq);
+    slot->time = g_get_monotonic_time();
+    g_strlcpy(slot->line, line, sizeof(slot->line));
+    g_atomic_int_inc(&slot->seq);
+}
+
+static
+void
+nfcdc_log_put(
+    const char* line)
+{
+    if (g_atomic_int_get(&nfcdc_ring_enabled)) {
+        nfcdc_ring_put(line);
+    } else {
+        GDEBUG("%s", line);
+    }
+}
+
+static
+gboolean
+nfcdc_log_allow(
+    NFCDC_LOG_CATEGORY category)
+{
+    const gint rate = g_atomic_int_get(&nfcdc_log_rate);
+
+    if (rate > 0) {
+        NfcdcLogLimit* limit = nfcdc_log_limits + category;
+        const gint now = (gint) (g_get_monotonic_time() / G_USEC_PER_SEC);
+        const gint window = g_atomic_int_get(&limit->window);
+
+        /* Only one thread gets to start the new window */
+        if (window != now && g_atomic_int_compare_and_exchange
+           (&limit->window, window, now)) {
+            gint suppressed;
+
+            g_atomic_int_set(&limit->count, 0);
+            do {
+                suppressed = g_atomic_int_get(&limit->suppressed);
+            } while (suppressed && !g_atomic_int_compare_and_exchange
+                (&limit->suppressed, suppressed, 0));
+            if (suppressed) {
+                char line[64];
+
+                g_snprintf(line, sizeof(line), "(%d %s dump(s) suppressed)",
+                    suppressed, nfcdc_log_category_names[category]);
+                nfcdc_log_put(line);
+            }
+        }
+        if (g_atomic_int_add(&limit->count, 1) >= rate) {
+            g_atomic_int_inc(&limit->suppressed);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static inline
+gboolean
+nfcdc_dump_enabled(
+    void)
+{
+    return GLOG_ENABLED(GLOG_LEVEL_DEBUG) ||
+        g_atomic_int_get(&nfcdc_ring_enabled);
+}
+
 static inline
 gboolean
 nfcdc_blank_str(
@@ -50,6 +189,30 @@ nfcdc_blank_str(
     return !prefix[strspn(prefix," \t")];
 }
 
+/* Table-driven, XX:XX:XX... */
+static
+const char*
+nfcdc_hex(
+    GString* buf,
+    const GUtilData* data)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    const guint8* ptr = data->bytes;
+    const guint8* end = ptr + data->size;
+    char* out;
+
+    g_string_set_size(buf, data->size * 3 - 1);
+    out = buf->str;
+    *out++ = hex[*ptr >> 4];
+    *out++ = hex[*ptr++ & 0x0f];
+    while (ptr < end) {
+        *out++ = ':';
+        *out++ = hex[*ptr >> 4];
+        *out++ = hex[*ptr++ & 0x0f];
+    }
+    return buf->str;
+}
+
 void
 nfcdc_dump_strv(
     const char* prefix,
@@ -57,74 +220,79 @@ nfcdc_dump_strv(
     const char* sep,
     const GStrV* strv)
 {
-    if (GLOG_ENABLED(GLOG_LEVEL_DEBUG)) {
+    if (nfcdc_dump_enabled() && nfcdc_log_allow(NFCDC_LOG_STRV)) {
+        NfcdcLogBuf* buf = nfcdc_log_buf();
+        GString* line = buf->line;
+
         if (strv) {
-            GString* buf = g_string_new(NULL);
+            GString* list = buf->hex;
             const GStrV* ptr;
 
+            g_string_truncate(list, 0);
             for (ptr = strv; *ptr; ptr++) {
-                if (buf->len > 0) {
-                    g_string_append(buf, ", ");
+                if (list->len > 0) {
+                    g_string_append(list, ", ");
                 }
-                g_string_append(buf, *ptr);
+                g_string_append(list, *ptr);
             }
             if (prefix) {
                 if (sep) {
-                    GDEBUG("%s%s%s %s {%s}", prefix, nfcdc_blank_str(prefix) ?
-                               "" : ": ", name, sep, buf->str);
+                    g_string_printf(line, "%s%s%s %s {%s}", prefix,
+                        nfcdc_blank_str(prefix) ? "" : ": ", name, sep,
+                        list->str);
                 } else {
-                    GDEBUG("%s: %s {%s}", prefix, name, buf->str);
+                    g_string_printf(line, "%s: %s {%s}", prefix, name,
+                        list->str);
                 }
             } else if (sep) {
-                GDEBUG("%s %s {%s}", name, sep, buf->str);
+                g_string_printf(line, "%s %s {%s}", name, sep, list->str);
             } else {
-                GDEBUG("%s {%s}", name, buf->str);
+                g_string_printf(line, "%s {%s}", name, list->str);
             }
-            g_string_free(buf, TRUE);
         } else {
             if (prefix) {
-                GDEBUG("%s%s%s %s", prefix, nfcdc_blank_str(prefix) ?
-                    "" : ": ", name, sep);
+                g_string_printf(line, "%s%s%s %s", prefix,
+                    nfcdc_blank_str(prefix) ? "" : ": ", name, sep);
             } else if (sep) {
-                GDEBUG("%s %s", name, sep);
+                g_string_printf(line, "%s %s", name, sep);
             } else {
-                GDEBUG("%s", name);
+                g_string_assign(line, name);
             }
         }
+        nfcdc_log_put(line->str);
     }
 }
 
 void
 nfcdc_dump_data(
+    NFCDC_LOG_CATEGORY category,
     const char* prefix,
     const char* name,
     const char* sep,
     const GUtilData* data)
 {
-    if (GLOG_ENABLED(GLOG_LEVEL_DEBUG)) {
+    if (nfcdc_dump_enabled() && nfcdc_log_allow(category)) {
+        NfcdcLogBuf* buf = nfcdc_log_buf();
+        GString* line = buf->line;
+
         if (data && data->size) {
-            GString* buf = g_string_new(NULL);
-            gsize i;
+            const char* hex = nfcdc_hex(buf->hex, data);
 
-            g_string_printf(buf, "%02X", data->bytes[0]);
-            for (i = 1; i < data->size; i++) {
-                g_string_append_printf(buf, ":%02X", data->bytes[i]);
-            }
             if (prefix) {
-                GDEBUG("%s%s%s %s %s", prefix, nfcdc_blank_str(prefix) ?
-                    "" : ": ", name, sep, buf->str);
+                g_string_printf(line, "%s%s%s %s %s", prefix,
+                    nfcdc_blank_str(prefix) ? "" : ": ", name, sep, hex);
             } else {
-                GDEBUG("%s %s %s", name, sep, buf->str);
+                g_string_printf(line, "%s %s %s", name, sep, hex);
             }
-            g_string_free(buf, TRUE);
         } else if (prefix) {
-            GDEBUG("%s%s%s %s", prefix, nfcdc_blank_str(prefix) ?
-                "" : ": ", name, sep);
+            g_string_printf(line, "%s%s%s %s", prefix,
+                nfcdc_blank_str(prefix) ? "" : ": ", name, sep);
         } else if (sep) {
-            GDEBUG("%s %s", name, sep);
+            g_string_printf(line, "%s %s", name, sep);
         } else {
-            GDEBUG("%s", name);
+            g_string_assign(line, name);
         }
+        nfcdc_log_put(line->str);
     }
 }
 
@@ -135,20 +303,67 @@ nfcdc_dump_bytes(
     const char* sep,
     GBytes* bytes)
 {
-    if (GLOG_ENABLED(GLOG_LEVEL_DEBUG)) {
+    if (nfcdc_dump_enabled()) {
         if (bytes) {
             GUtilData data;
 
             data.bytes = g_bytes_get_data(bytes, &data.size);
-            nfcdc_dump_data(prefix, name, sep, &data);
+            nfcdc_dump_data(NFCDC_LOG_DATA, prefix, name, sep, &data);
         } else {
-            nfcdc_dump_data(prefix, name, sep, NULL);
+            nfcdc_dump_data(NFCDC_LOG_DATA, prefix, name, sep, NULL);
         }
     }
 }
 
 #endif /* GUTIL_LOG_DEBUG */
 
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+nfc_debug_set_rate_limit(
+    guint lines_per_sec)
+{
+    g_atomic_int_set(&nfcdc_log_rate, (gint) MIN(lines_per_sec, G_MAXINT));
+}
+
+void
+nfc_debug_set_ring_enabled(
+    gboolean enabled)
+{
+    g_atomic_int_set(&nfcdc_ring_enabled, enabled != FALSE);
+}
+
+char*
+nfc_debug_ring_dump(
+    void)
+{
+    const guint head = (guint) g_atomic_int_get(&nfcdc_ring_head);
+    GString* out = g_string_new(NULL);
+    guint i;
+
+    /* Skip the slots which are being written or have been overwritten */
+    for (i = (head > NFCDC_RING_SLOTS) ? (head - NFCDC_RING_SLOTS) : 0;
+         i != head; i++) {
+        NfcdcRingSlot* slot = nfcdc_ring + (i % NFCDC_RING_SLOTS);
+        const gint seq = g_atomic_int_get(&slot->seq);
+
+        if (seq && !(seq & 1)) {
+            NfcdcRingSlot copy;
+
+            memcpy(&copy, slot, sizeof(copy));
+            if (g_atomic_int_get(&slot->seq) == seq) {
+                copy.line[NFCDC_RING_LINE - 1] = 0;
+                g_string_append_printf(out, "[%" G_GINT64_FORMAT ".%06d] "
+                    "%s\n", copy.time / G_USEC_PER_SEC,
+                    (int) (copy.time % G_USEC_PER_SEC), copy.line);
+            }
+        }
+    }
+    return g_string_free(out, FALSE);
+}
+
 /*
  * Local Variables:
  * mode: C
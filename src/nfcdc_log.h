@@ -46,6 +46,14 @@
 
 #if GUTIL_LOG_DEBUG
 
+/* Each category is rate limited separately */
+typedef enum nfcdc_log_category {
+    NFCDC_LOG_STRV,
+    NFCDC_LOG_DATA,
+    NFCDC_LOG_PARAM,
+    NFCDC_LOG_CATEGORY_COUNT
+} NFCDC_LOG_CATEGORY;
+
 void
 nfcdc_dump_strv(
     const char* prefix,
@@ -56,6 +64,7 @@ nfcdc_dump_strv(
 
 void
 nfcdc_dump_data(
+    NFCDC_LOG_CATEGORY category,
     const char* prefix,
     const char* name,
     const char* sep,
@@ -73,12 +82,15 @@ nfcdc_dump_bytes(
 #  define DUMP_STRV(prefix,name,sep,strv) \
    nfcdc_dump_strv(prefix,name,sep,strv)
 #  define DUMP_DATA(prefix,name,sep,data) \
-   nfcdc_dump_data(prefix,name,sep,data)
+   nfcdc_dump_data(NFCDC_LOG_DATA,prefix,name,sep,data)
+#  define DUMP_PARAM(prefix,name,sep,data) \
+   nfcdc_dump_data(NFCDC_LOG_PARAM,prefix,name,sep,data)
 #  define DUMP_BYTES(prefix,name,sep,bytes) \
    nfcdc_dump_bytes(prefix,name,sep,bytes)
 #else
 #  define DUMP_STRV(prefix,name,sep,strv) ((void)0)
 #  define DUMP_DATA(prefix,name,sep,data) ((void)0)
+#  define DUMP_PARAM(prefix,name,sep,data) ((void)0)
 #  define DUMP_BYTES(prefix,name,sep,bytes) ((void)0)
 #endif
 
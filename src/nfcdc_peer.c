@@ -38,10 +38,15 @@
  */
 
 #include "nfcdc_adapter_p.h"
-#include "nfcdc_peer.h"
+#include "nfcdc_peer_p.h"
 #include "nfcdc_base.h"
 #include "nfcdc_dbus.h"
+#include "nfcdc_error.h"
 #include "nfcdc_log.h"
+#include "nfcdc_retry_p.h"
+#include "nfcdc_scheduler_p.h"
+#include "nfcdc_stats_p.h"
+#include "nfcdc_trace_p.h"
 
 #include <gutil_macros.h>
 #include <gutil_misc.h>
@@ -66,6 +71,9 @@ typedef struct nfc_peer_client_object {
     gulong adapter_event_id[ADAPTER_SIGNAL_COUNT];
     OrgSailfishosNfcPeer* proxy;
     gboolean proxy_initializing;
+    gint64 get_all_start;
+    NfcClientRetry retry;
+    NfcScheduler* scheduler;
 } NfcPeerClientObject;
 
 #define PARENT_CLASS nfc_peer_client_object_parent_class
@@ -98,6 +106,10 @@ typedef struct nfc_peer_client_connect_data {
         GUnixFDList** fdl,
         GAsyncResult* result,
         GError** error);
+    GCancellable* cancel;
+    guint rsap;
+    char* sn;
+    guint queue_id;
 } NfcPeerClientConnectData;
 
 static GHashTable* nfc_peer_client_table;
@@ -119,6 +131,20 @@ nfc_peer_client_object_cast(
     return peer ? THIS(G_CAST(peer, NfcPeerClientObject, pub)) : NULL;
 }
 
+static
+void
+nfc_peer_client_set_retrying(
+    NfcPeerClientObject* self,
+    gboolean retrying)
+{
+    NfcPeerClient* peer = &self->pub;
+
+    if (peer->retrying != retrying) {
+        peer->retrying = retrying;
+        nfc_peer_client_queue_signal(self, RETRYING);
+    }
+}
+
 static
 void
 nfc_peer_client_update_valid_and_present(
@@ -144,6 +170,11 @@ nfc_peer_client_update_valid_and_present(
         peer->present = present;
         nfc_peer_client_queue_signal(self, PRESENT);
     }
+    if (self->proxy && !self->proxy_initializing) {
+        /* Successfully initialized */
+        nfc_client_retry_reset(&self->retry);
+        nfc_peer_client_set_retrying(self, FALSE);
+    }
 }
 
 static
@@ -184,11 +215,35 @@ nfc_peer_client_update(
             nfc_peer_client_reinit(self);
         }
     } else if (!self->proxy_initializing) {
+        nfc_client_retry_reset(&self->retry);
+        nfc_peer_client_set_retrying(self, FALSE);
         nfc_peer_client_drop_proxy(self);
     }
     nfc_peer_client_update_valid_and_present(self);
 }
 
+static
+void
+nfc_peer_client_retry(
+    GObject* object)
+{
+    NfcPeerClientObject* self = THIS(object);
+
+    nfc_peer_client_update(self);
+    nfc_peer_client_emit_queued_signals(self);
+}
+
+static
+void
+nfc_peer_client_init_failed(
+    NfcPeerClientObject* self)
+{
+    nfc_peer_client_drop_proxy(self);
+    nfc_peer_client_set_retrying(self,
+        nfc_client_retry_schedule(&self->retry, G_OBJECT(self),
+            nfc_peer_client_retry));
+}
+
 static
 void
 nfc_peer_client_adapter_changed(
@@ -212,13 +267,18 @@ nfc_peer_client_get_all_done(
     NfcPeerClientObject* self = THIS(user_data);
     NfcPeerClient* peer = &self->pub;
     GError* error = NULL;
+    gboolean ok;
     gboolean present;
     guint wks;
 
     GASSERT(self->proxy_initializing);
     self->proxy_initializing = FALSE;
-    if (org_sailfishos_nfc_peer_call_get_all_finish(self->proxy, NULL,
-        &present, NULL, NULL, &wks, result, &error)) {
+    ok = org_sailfishos_nfc_peer_call_get_all_finish(self->proxy, NULL,
+        &present, NULL, NULL, &wks, result, &error);
+    nfc_client_stats_finish(self->pub.path, NFC_CLIENT_OP_PEER_GET_ALL,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, self->pub.path, NFC_CLIENT_OP_PEER_GET_ALL, ok);
+    if (ok) {
         GVERBOSE_("%s", peer->path);
         if (peer->wks != wks) {
             peer->wks = wks;
@@ -227,8 +287,7 @@ nfc_peer_client_get_all_done(
     } else {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
-        /* Need to retry? */
-        nfc_peer_client_drop_proxy(self);
+        nfc_peer_client_init_failed(self);
     }
     nfc_peer_client_update_valid_and_present(self);
     nfc_peer_client_emit_queued_signals(self);
@@ -249,12 +308,15 @@ nfc_peer_client_init_proxy_done(
     GASSERT(self->proxy_initializing);
     self->proxy = org_sailfishos_nfc_peer_proxy_new_finish(result, &error);
     if (self->proxy) {
+        self->get_all_start = nfc_client_stats_start();
+        NFCDC_TRACE2(init__start, self->pub.path, NFC_CLIENT_OP_PEER_GET_ALL);
         org_sailfishos_nfc_peer_call_get_all(self->proxy, NULL,
             nfc_peer_client_get_all_done, g_object_ref(self));
     } else {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
         self->proxy_initializing = FALSE;
+        nfc_peer_client_init_failed(self);
         nfc_peer_client_update_valid_and_present(self);
         nfc_peer_client_emit_queued_signals(self);
     }
@@ -282,6 +344,22 @@ nfc_peer_client_reinit(
     nfc_peer_client_init_start(self);
 }
 
+static
+void
+nfc_peer_client_connect_data_free(
+    NfcPeerClientConnectData* data)
+{
+    if (data->destroy) {
+        data->destroy(data->user_data);
+    }
+    if (data->cancel) {
+        g_object_unref(data->cancel);
+    }
+    g_free(data->sn);
+    nfc_peer_client_unref(data->peer);
+    gutil_slice_free(data);
+}
+
 static
 void
 nfc_peer_client_connect_done(
@@ -290,6 +368,7 @@ nfc_peer_client_connect_done(
     gpointer user_data)
 {
     NfcPeerClientConnectData* data = user_data;
+    NfcPeerClientObject* self = nfc_peer_client_object_cast(data->peer);
     GVariant* fd = NULL;
     GUnixFDList* fdl = NULL;
     GError* error = NULL;
@@ -313,11 +392,99 @@ nfc_peer_client_connect_done(
         }
         g_error_free(error);
     }
-    if (data->destroy) {
-        data->destroy(data->user_data);
+    /* Let the next one go */
+    nfc_scheduler_finish(self->scheduler);
+    nfc_peer_client_connect_data_free(data);
+}
+
+static
+gboolean
+nfc_peer_client_connect_start(
+    gpointer user_data)
+{
+    NfcPeerClientConnectData* data = user_data;
+    NfcPeerClientObject* self = nfc_peer_client_object_cast(data->peer);
+
+    if (self->proxy) {
+        if (data->sn) {
+            org_sailfishos_nfc_peer_call_connect_service_name(self->proxy,
+                data->sn, NULL, data->cancel, nfc_peer_client_connect_done,
+                data);
+        } else {
+            org_sailfishos_nfc_peer_call_connect_access_point(self->proxy,
+                data->rsap, NULL, data->cancel, nfc_peer_client_connect_done,
+                data);
+        }
+        return TRUE;
+    } else {
+        /* The peer is gone while the call was waiting for its turn */
+        if (data->callback) {
+            GError* error = g_error_new_literal(NFCDC_ERROR,
+                NFCDC_ERROR_ABORTED, "Peer is gone");
+
+            data->callback(data->peer, -1, error, data->user_data);
+            g_error_free(error);
+        }
+        nfc_peer_client_connect_data_free(data);
+        return FALSE;
     }
-    nfc_peer_client_unref(data->peer);
-    gutil_slice_free(data);
+}
+
+static
+void
+nfc_peer_client_connect_submit(
+    NfcPeerClientObject* self,
+    guint rsap,
+    const char* sn,
+    GCancellable* cancel,
+    NfcPeerClientConnectionFunc callback,
+    void* user_data,
+    GDestroyNotify destroy)
+{
+    NfcPeerClientConnectData* data = g_slice_new0(NfcPeerClientConnectData);
+
+    data->peer = nfc_peer_client_ref(&self->pub);
+    data->callback = callback;
+    data->user_data = user_data;
+    data->destroy = destroy;
+    if (sn) {
+        data->sn = g_strdup(sn);
+        data->finish_call =
+            org_sailfishos_nfc_peer_call_connect_service_name_finish;
+    } else {
+        data->rsap = rsap;
+        data->finish_call =
+            org_sailfishos_nfc_peer_call_connect_access_point_finish;
+    }
+    if (cancel) {
+        g_object_ref(data->cancel = cancel);
+    }
+    nfc_scheduler_submit(self->scheduler, NFC_CALL_PRIORITY_DEFAULT,
+        nfc_peer_client_connect_start, data, &data->queue_id);
+}
+
+static
+void
+nfc_peer_client_congestion_changed(
+    gpointer user_data)
+{
+    NfcPeerClientObject* self = THIS(user_data);
+
+    self->pub.congested = nfc_scheduler_congested(self->scheduler);
+    nfc_peer_client_queue_signal(self, CONGESTED);
+    nfc_peer_client_emit_queued_signals(self);
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+guint
+nfc_peer_client_count(
+    void)
+{
+    return nfc_peer_client_table ?
+        g_hash_table_size(nfc_peer_client_table) : 0;
 }
 
 /*==========================================================================*
@@ -402,22 +569,8 @@ nfc_peer_client_connect_sap(
 
     if (G_LIKELY(self) && G_LIKELY(rsap) && G_LIKELY(self->proxy) &&
         (!cancel || !g_cancellable_is_cancelled(cancel))) {
-        NfcPeerClientConnectData* data = NULL;
-        GAsyncReadyCallback complete = NULL;
-
-        if (callback || destroy) {
-            complete = nfc_peer_client_connect_done;
-            data = g_slice_new(NfcPeerClientConnectData);
-            data->peer = nfc_peer_client_ref(peer);
-            data->callback = callback;
-            data->user_data = user_data;
-            data->destroy = destroy;
-            data->finish_call =
-                org_sailfishos_nfc_peer_call_connect_access_point_finish;
-        }
-
-        org_sailfishos_nfc_peer_call_connect_access_point(self->proxy, rsap,
-            NULL, cancel, complete, data);
+        nfc_peer_client_connect_submit(self, rsap, NULL, cancel, callback,
+            user_data, destroy);
         return TRUE;
     } else {
         /* Destroy callback is always invoked even if we return FALSE */
@@ -441,22 +594,8 @@ nfc_peer_client_connect_sn(
 
     if (G_LIKELY(self) && G_LIKELY(sn) && G_LIKELY(self->proxy) &&
         (!cancel || !g_cancellable_is_cancelled(cancel))) {
-        NfcPeerClientConnectData* data = NULL;
-        GAsyncReadyCallback complete = NULL;
-
-        if (callback || destroy) {
-            complete = nfc_peer_client_connect_done;
-            data = g_slice_new(NfcPeerClientConnectData);
-            data->peer = nfc_peer_client_ref(peer);
-            data->callback = callback;
-            data->user_data = user_data;
-            data->destroy = destroy;
-            data->finish_call =
-                org_sailfishos_nfc_peer_call_connect_service_name_finish;
-        }
-
-        org_sailfishos_nfc_peer_call_connect_service_name(self->proxy, sn,
-            NULL, cancel, complete, data);
+        nfc_peer_client_connect_submit(self, 0, sn, cancel, callback,
+            user_data, destroy);
         return TRUE;
     } else {
         /* Destroy callback is always invoked even if we return FALSE */
@@ -513,6 +652,8 @@ nfc_peer_client_object_init(
     NfcPeerClientObject* self)
 {
     self->proxy_initializing = TRUE;
+    self->scheduler = nfc_scheduler_new(nfc_peer_client_congestion_changed,
+        self);
 }
 
 static
@@ -524,11 +665,13 @@ nfc_peer_client_object_finalize(
     NfcPeerClient* peer = &self->pub;
 
     GVERBOSE_("%s", peer->path);
+    nfc_client_retry_reset(&self->retry);
     nfc_peer_client_drop_proxy(self);
     nfc_adapter_client_remove_all_handlers(self->adapter,
         self->adapter_event_id);
     nfc_adapter_client_unref(self->adapter);
     gutil_object_unref(self->connection);
+    nfc_scheduler_free(self->scheduler);
     g_hash_table_remove(nfc_peer_client_table, peer->path);
     if (g_hash_table_size(nfc_peer_client_table) == 0) {
         g_hash_table_unref(nfc_peer_client_table);
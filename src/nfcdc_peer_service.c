@@ -62,11 +62,30 @@ enum nfc_peer_service_calls {
     CALL_ACCEPT,
     CALL_PEER_ARRIVED,
     CALL_PEER_LEFT,
+    CALL_DATAGRAM_RECEIVED,
     CALL_COUNT
 };
 
+typedef struct nfc_peer_service_object NfcPeerServiceObject;
+
+/*
+ * Connections may be accepted and released on any thread, the part of
+ * the accept queue touched by them (active counter and dispatch flag)
+ * is atomic. Everything else is only accessed on the main thread.
+ */
+typedef struct nfc_peer_service_accept_queue {
+    gint ref_count;
+    gint active;
+    gint dispatch_pending;
+    guint backlog;
+    guint max_active;
+    GQueue pending;
+    GMainContext* context;
+    NfcPeerServiceObject* service;
+} NfcPeerServiceAcceptQueue;
+
 typedef NfcClientBaseClass NfcPeerServiceObjectClass;
-typedef struct nfc_peer_service_object {
+struct nfc_peer_service_object {
     NfcClientBase base;
     NfcPeerService pub;
     NfcDaemonClient* daemon;
@@ -78,12 +97,14 @@ typedef struct nfc_peer_service_object {
     gboolean exported;
     char* path;
     char* sn;
-} NfcPeerServiceObject;
+    NfcPeerServiceAcceptQueue* accept_queue;
+};
 
 typedef struct nfc_service_connection_priv {
     NfcServiceConnection pub;
     OrgSailfishosNfcLocalService* object;
     GDBusMethodInvocation* accept_call;
+    NfcPeerServiceAcceptQueue* queue;
     gint refcount;
 } NfcServiceConnectionPriv;
 
@@ -115,12 +136,14 @@ enum nfc_peer_service_signal {
     SIGNAL_PEER_ARRIVED,
     SIGNAL_PEER_LEFT,
     SIGNAL_ACCEPT,
+    SIGNAL_DATAGRAM,
     SIGNAL_COUNT
 };
 
 #define SIGNAL_PEER_ARRIVED_NAME      "nfcdc-peer-service-peer-arrived"
 #define SIGNAL_PEER_LEFT_NAME         "nfcdc-peer-service-peer-left"
 #define SIGNAL_ACCEPT_NAME            "nfcdc-peer-service-accept"
+#define SIGNAL_DATAGRAM_NAME          "nfcdc-peer-service-datagram"
 
 static guint nfc_peer_service_signals[SIGNAL_COUNT];
 
@@ -144,6 +167,34 @@ nfc_service_connection_cast(
     return conn ? G_CAST(conn, NfcServiceConnectionPriv, pub) : NULL;
 }
 
+static
+NfcPeerServiceAcceptQueue*
+nfc_peer_service_accept_queue_ref(
+    NfcPeerServiceAcceptQueue* queue)
+{
+    g_atomic_int_inc(&queue->ref_count);
+    return queue;
+}
+
+static
+void
+nfc_peer_service_accept_queue_unref(
+    gpointer data)
+{
+    NfcPeerServiceAcceptQueue* queue = data;
+
+    if (g_atomic_int_dec_and_test(&queue->ref_count)) {
+        GASSERT(g_queue_is_empty(&queue->pending));
+        g_main_context_unref(queue->context);
+        gutil_slice_free(queue);
+    }
+}
+
+static
+void
+nfc_peer_service_accept_queue_schedule(
+    NfcPeerServiceAcceptQueue* queue);
+
 static
 NfcServiceConnectionPriv*
 nfc_service_connection_priv_new(
@@ -181,10 +232,75 @@ nfc_service_connection_priv_unref(
         g_object_unref(priv->object);
         shutdown(conn->fd, SHUT_RDWR);
         close(conn->fd);
+        if (priv->queue) {
+            NfcPeerServiceAcceptQueue* queue = priv->queue;
+
+            /* This may happen on any thread */
+            g_atomic_int_add(&queue->active, -1);
+            nfc_peer_service_accept_queue_schedule(queue);
+            nfc_peer_service_accept_queue_unref(queue);
+        }
         gutil_slice_free(conn);
     }
 }
 
+static
+gboolean
+nfc_peer_service_accept_queue_dispatch(
+    gpointer user_data)
+{
+    NfcPeerServiceAcceptQueue* queue = user_data;
+    NfcPeerServiceObject* self = queue->service;
+
+    g_atomic_int_set(&queue->dispatch_pending, 0);
+    if (self) {
+        g_object_ref(self);
+        while (!g_queue_is_empty(&queue->pending) && (!queue->max_active ||
+            g_atomic_int_get(&queue->active) < (gint) queue->max_active)) {
+            NfcServiceConnectionPriv* priv = g_queue_pop_head(&queue->pending);
+
+            /* The connection stays active until it's finalized */
+            priv->queue = nfc_peer_service_accept_queue_ref(queue);
+            g_atomic_int_inc(&queue->active);
+            self->handler(&self->pub, &priv->pub, self->handler_data);
+            nfc_service_connection_priv_unref(priv);
+        }
+        g_object_unref(self);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+nfc_peer_service_accept_queue_schedule(
+    NfcPeerServiceAcceptQueue* queue)
+{
+    if (g_atomic_int_compare_and_exchange(&queue->dispatch_pending, 0, 1)) {
+        GSource* src = g_idle_source_new();
+
+        g_source_set_callback(src, nfc_peer_service_accept_queue_dispatch,
+            nfc_peer_service_accept_queue_ref(queue),
+            nfc_peer_service_accept_queue_unref);
+        g_source_attach(src, queue->context);
+        g_source_unref(src);
+    }
+}
+
+static
+void
+nfc_peer_service_accept_queue_detach(
+    NfcPeerServiceAcceptQueue* queue)
+{
+    NfcServiceConnectionPriv* priv;
+
+    /* Reject whatever is still waiting */
+    queue->service = NULL;
+    while ((priv = g_queue_pop_head(&queue->pending)) != NULL) {
+        nfc_service_connection_priv_unref(priv);
+    }
+    nfc_peer_service_accept_queue_unref(queue);
+}
+
 static
 void
 nfc_peer_service_try_register(
@@ -249,6 +365,28 @@ nfc_peer_service_object_handle_peer_left(
     return TRUE;
 }
 
+static
+gboolean
+nfc_peer_service_object_handle_datagram_received(
+    OrgSailfishosNfcLocalService* object,
+    GDBusMethodInvocation* call,
+    guint rsap,
+    GVariant* var,
+    NfcPeerServiceObject* self)
+{
+    GUtilData data;
+    gsize size = 0;
+
+    /* Handlers get a view of the message payload, nothing is copied */
+    data.bytes = g_variant_get_fixed_array(var, &size, 1);
+    data.size = size;
+    GDEBUG("Datagram from %u (%u bytes)", rsap, (guint) size);
+    g_signal_emit(self, nfc_peer_service_signals[SIGNAL_DATAGRAM], 0,
+        rsap, &data);
+    org_sailfishos_nfc_local_service_complete_datagram_received(object, call);
+    return TRUE;
+}
+
 static
 gboolean
 nfc_peer_service_object_handle_accept(
@@ -262,8 +400,18 @@ nfc_peer_service_object_handle_accept(
     if (self->handler) {
         NfcServiceConnectionPriv* priv =
             nfc_service_connection_priv_new(object, call, fdl,rsap);
-
-        self->handler(&self->pub, &priv->pub, self->handler_data);
+        NfcPeerServiceAcceptQueue* queue = self->accept_queue;
+
+        if (!queue) {
+            self->handler(&self->pub, &priv->pub, self->handler_data);
+        } else if (queue->pending.length < queue->backlog) {
+            GDEBUG("Queuing connection from %u", rsap);
+            g_queue_push_tail(&queue->pending, priv);
+            nfc_peer_service_accept_queue_schedule(queue);
+            return TRUE;
+        } else {
+            GDEBUG("Backlog is full");
+        }
         nfc_service_connection_priv_unref(priv);
     }
     return TRUE;
@@ -342,6 +490,10 @@ nfc_peer_service_new(
         self->call_id[CALL_PEER_LEFT] =
             g_signal_connect(self->object, "handle-peer-left",
                 G_CALLBACK(nfc_peer_service_object_handle_peer_left), self);
+        self->call_id[CALL_DATAGRAM_RECEIVED] =
+            g_signal_connect(self->object, "handle-datagram-received",
+                G_CALLBACK(nfc_peer_service_object_handle_datagram_received),
+                self);
 
         self->exported = g_dbus_interface_skeleton_export
             (G_DBUS_INTERFACE_SKELETON(self->object),
@@ -410,6 +562,51 @@ nfc_peer_service_add_peer_left_handler(
         SIGNAL_PEER_LEFT_NAME, G_CALLBACK(func), user_data) : 0;
 }
 
+gulong
+nfc_peer_service_add_datagram_handler(
+    NfcPeerService* service,
+    NfcPeerServiceDatagramFunc func,
+    void* user_data) /* Since 1.3.0 */
+{
+    NfcPeerServiceObject* self = nfc_peer_service_object_cast(service);
+
+    return (G_LIKELY(self) && G_LIKELY(func)) ? g_signal_connect(self,
+        SIGNAL_DATAGRAM_NAME, G_CALLBACK(func), user_data) : 0;
+}
+
+void
+nfc_peer_service_set_accept_queue(
+    NfcPeerService* service,
+    guint backlog,
+    guint max_active) /* Since 1.3.0 */
+{
+    NfcPeerServiceObject* self = nfc_peer_service_object_cast(service);
+
+    if (G_LIKELY(self)) {
+        NfcPeerServiceAcceptQueue* queue = self->accept_queue;
+
+        if (backlog) {
+            if (!queue) {
+                queue = g_slice_new0(NfcPeerServiceAcceptQueue);
+                g_atomic_int_set(&queue->ref_count, 1);
+                g_queue_init(&queue->pending);
+                queue->context = g_main_context_ref_thread_default();
+                queue->service = self;
+                self->accept_queue = queue;
+            }
+            queue->backlog = backlog;
+            queue->max_active = max_active;
+
+            /* The limits may have been raised */
+            nfc_peer_service_accept_queue_schedule(queue);
+        } else if (queue) {
+            /* Back to synchronous mode */
+            self->accept_queue = NULL;
+            nfc_peer_service_accept_queue_detach(queue);
+        }
+    }
+}
+
 void
 nfc_peer_service_remove_handler(
     NfcPeerService* service,
@@ -462,13 +659,16 @@ nfc_service_connection_accept(
     NfcServiceConnection* conn)
 {
     NfcServiceConnectionPriv* priv = nfc_service_connection_cast(conn);
+    GDBusMethodInvocation* call = priv ?
+        g_atomic_pointer_get(&priv->accept_call) : NULL;
 
-    if (priv && priv->accept_call) {
+    /* Make sure that only one thread gets to complete the call */
+    if (call && g_atomic_pointer_compare_and_exchange(&priv->accept_call,
+        call, NULL)) {
         GDEBUG("Accepting connection from %u", conn->rsap);
         org_sailfishos_nfc_local_service_complete_accept(priv->object,
-            priv->accept_call, NULL, TRUE);
-        g_object_unref(priv->accept_call);
-        priv->accept_call = NULL;
+            call, NULL, TRUE);
+        g_object_unref(call);
         /* Add a reference */
         g_atomic_int_inc(&priv->refcount);
         return conn;
@@ -496,6 +696,9 @@ nfc_peer_service_object_finalize(
     NfcPeerServiceObject* self = THIS(object);
 
     GVERBOSE_("%s", self->path);
+    if (self->accept_queue) {
+        nfc_peer_service_accept_queue_detach(self->accept_queue);
+    }
     if (self->exported) {
         nfc_daemon_client_unregister_service(self->daemon, self->path);
         g_dbus_interface_skeleton_unexport
@@ -528,6 +731,10 @@ nfc_peer_service_object_class_init(
         g_signal_new(SIGNAL_PEER_LEFT_NAME, type,
             G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE, 1,
             G_TYPE_STRING);
+    nfc_peer_service_signals[SIGNAL_DATAGRAM] =
+        g_signal_new(SIGNAL_DATAGRAM_NAME, type,
+            G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE, 2,
+            G_TYPE_UINT, G_TYPE_POINTER);
 }
 
 /*
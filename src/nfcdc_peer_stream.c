@@ -0,0 +1,753 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#define _GNU_SOURCE /* splice() */
+
+#include "nfcdc_peer_stream.h"
+#include "nfcdc_log.h"
+
+#include <gutil_macros.h>
+
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NFC_PEER_STREAM_DEFAULT_MIU (128)
+#define NFC_PEER_STREAM_DEFAULT_BUFFER_SIZE (4096)
+#define NFC_PEER_STREAM_WRITE_LIMIT (0x10000)
+#define NFC_PEER_STREAM_BULK_CHUNK (0x4000)
+
+typedef enum nfc_peer_stream_bulk_mode {
+    BULK_SENDFILE,
+    BULK_SPLICE,
+    BULK_COPY
+} NFC_PEER_STREAM_BULK_MODE;
+
+typedef struct nfc_peer_stream_bulk {
+    int fd;
+    int flags;          /* Original flags if we had to change them */
+    GIOChannel* io;
+    guint watch_id;
+    gboolean starved;   /* Waiting for the source to become readable */
+    NFC_PEER_STREAM_BULK_MODE mode;
+    gsize remaining;    /* Zero means until EOF */
+    gboolean unlimited;
+    gsize sent;
+    NfcPeerStreamSendFunc complete;
+    GDestroyNotify destroy;
+    void* user_data;
+} NfcPeerStreamBulk;
+
+typedef struct nfc_peer_stream_priv {
+    NfcPeerStream pub;
+    gint ref_count;
+    GIOChannel* io;
+    guint read_id;
+    guint write_id;
+    NfcPeerStreamFunc read_cb;
+    NfcPeerStreamFunc closed_cb;
+    NfcPeerStreamFunc write_cb;
+    void* user_data;
+    /* Read ring buffer */
+    guint8* rbuf;
+    gsize rsize;
+    gsize rstart;
+    /* Write queue */
+    GByteArray* wbuf;
+    gsize woff;
+    gboolean write_blocked;
+    NfcPeerStreamBulk* bulk;
+    GByteArray* held;   /* Written during the bulk transfer */
+} NfcPeerStreamPriv;
+
+static
+void
+nfc_peer_stream_update_watches(
+    NfcPeerStreamPriv* self);
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static inline
+NfcPeerStreamPriv*
+nfc_peer_stream_cast(
+    NfcPeerStream* stream)
+{
+    return stream ? G_CAST(stream, NfcPeerStreamPriv, pub) : NULL;
+}
+
+static
+int
+nfc_peer_stream_set_nonblock(
+    int fd)
+{
+    const int flags = fcntl(fd, F_GETFL);
+
+    /* Returns the original flags if they have been changed, -1 if not */
+    if (flags >= 0 && !(flags & O_NONBLOCK) &&
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK) >= 0) {
+        return flags;
+    }
+    return -1;
+}
+
+static
+gboolean
+nfc_peer_stream_fd_writable(
+    int fd)
+{
+    struct pollfd pfd;
+
+    memset(&pfd, 0, sizeof(pfd));
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLOUT);
+}
+
+static
+void
+nfc_peer_stream_bulk_finish(
+    NfcPeerStreamPriv* self,
+    int err)
+{
+    NfcPeerStreamBulk* bulk = self->bulk;
+
+    self->bulk = NULL;
+    if (self->held->len) {
+        /* Goes after whatever is left from the bulk transfer */
+        g_byte_array_append(self->wbuf, self->held->data, self->held->len);
+        self->pub.pending += self->held->len;
+        g_byte_array_set_size(self->held, 0);
+    }
+    if (bulk->watch_id) {
+        g_source_remove(bulk->watch_id);
+    }
+    g_io_channel_unref(bulk->io);
+    if (bulk->flags >= 0) {
+        /* Restore the flags, the descriptor belongs to the caller */
+        fcntl(bulk->fd, F_SETFL, bulk->flags);
+    }
+    if (bulk->complete) {
+        GError* error = NULL;
+
+        if (err) {
+            error = g_error_new_literal(G_IO_ERROR,
+                g_io_error_from_errno(err), g_strerror(err));
+        }
+        bulk->complete(&self->pub, bulk->sent, error, bulk->user_data);
+        if (error) {
+            g_error_free(error);
+        }
+    }
+    if (bulk->destroy) {
+        bulk->destroy(bulk->user_data);
+    }
+    gutil_slice_free(bulk);
+}
+
+static
+void
+nfc_peer_stream_shutdown(
+    NfcPeerStreamPriv* self)
+{
+    NfcPeerStream* stream = &self->pub;
+
+    if (!stream->closed) {
+        stream->closed = TRUE;
+        if (self->read_id) {
+            g_source_remove(self->read_id);
+            self->read_id = 0;
+        }
+        if (self->write_id) {
+            g_source_remove(self->write_id);
+            self->write_id = 0;
+        }
+        g_byte_array_set_size(self->wbuf, 0);
+        g_byte_array_set_size(self->held, 0);
+        self->woff = 0;
+        stream->pending = 0;
+        shutdown(stream->fd, SHUT_RDWR);
+        if (self->bulk) {
+            nfc_peer_stream_bulk_finish(self, EPIPE);
+        }
+    }
+}
+
+static
+void
+nfc_peer_stream_closed(
+    NfcPeerStreamPriv* self)
+{
+    if (!self->pub.closed) {
+        GDEBUG("Peer stream %d closed", self->pub.fd);
+        nfc_peer_stream_shutdown(self);
+        if (self->closed_cb) {
+            self->closed_cb(&self->pub, self->user_data);
+        }
+    }
+}
+
+/* Returns FALSE if the connection has failed */
+static
+gboolean
+nfc_peer_stream_flush_buffer(
+    NfcPeerStreamPriv* self)
+{
+    NfcPeerStream* stream = &self->pub;
+    /* Bulk transfers don't need to be split into packets */
+    const gsize max = self->bulk ? NFC_PEER_STREAM_BULK_CHUNK : stream->miu;
+
+    while (stream->pending) {
+        const gsize len = MIN(stream->pending, max);
+        const gssize sent = send(stream->fd, self->wbuf->data + self->woff,
+            len, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (sent > 0) {
+            self->woff += sent;
+            stream->pending -= sent;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EINTR)) {
+            break;
+        } else {
+            GDEBUG("Peer stream %d send error: %s", stream->fd,
+                g_strerror(errno));
+            return FALSE;
+        }
+    }
+    if (!stream->pending) {
+        g_byte_array_set_size(self->wbuf, 0);
+        self->woff = 0;
+    }
+    return TRUE;
+}
+
+/* Returns FALSE if the connection has failed */
+static
+gboolean
+nfc_peer_stream_flush_bulk(
+    NfcPeerStreamPriv* self)
+{
+    NfcPeerStream* stream = &self->pub;
+    NfcPeerStreamBulk* bulk = self->bulk;
+
+    while (bulk && !bulk->starved && !stream->pending) {
+        /* Well above the MIU, it's the number of syscalls that hurts */
+        const gsize len = bulk->unlimited ? NFC_PEER_STREAM_BULK_CHUNK :
+            MIN(bulk->remaining, NFC_PEER_STREAM_BULK_CHUNK);
+        gssize n;
+
+        if (bulk->mode == BULK_COPY) {
+            /* Copy through the write buffer */
+            g_byte_array_set_size(self->wbuf, len);
+            n = read(bulk->fd, self->wbuf->data, len);
+            g_byte_array_set_size(self->wbuf, MAX(n, 0));
+            if (n > 0) {
+                self->woff = 0;
+                stream->pending = n;
+                if (!nfc_peer_stream_flush_buffer(self)) {
+                    return FALSE;
+                }
+            }
+        } else {
+            n = (bulk->mode == BULK_SPLICE) ?
+                splice(bulk->fd, NULL, stream->fd, NULL, len,
+                    SPLICE_F_MOVE | SPLICE_F_NONBLOCK) :
+                sendfile(stream->fd, bulk->fd, NULL, len);
+            if (n < 0 && (errno == EINVAL || errno == ENOSYS) &&
+                !bulk->sent) {
+                /* The kernel can't do it for this pair of descriptors */
+                GDEBUG("Peer stream %d falling back to copying", stream->fd);
+                bulk->mode = BULK_COPY;
+                continue;
+            }
+        }
+
+        if (n > 0) {
+            bulk->sent += n;
+            if (!bulk->unlimited) {
+                bulk->remaining -= n;
+            }
+        } else if (n < 0) {
+            const int err = errno;
+
+            if (err == EINTR) {
+                continue;
+            } else if (err == EAGAIN) {
+                /*
+                 * Either the source has nothing to give or the socket
+                 * is full. In the former case we have to wait for the
+                 * source, otherwise the socket would keep waking us up.
+                 * sendfile() only reads regular files which are always
+                 * readable.
+                 */
+                bulk->starved = (bulk->mode == BULK_COPY) ||
+                    (bulk->mode == BULK_SPLICE &&
+                     nfc_peer_stream_fd_writable(stream->fd));
+                break;
+            }
+            GDEBUG("Peer stream %d bulk transfer error: %s", stream->fd,
+                g_strerror(err));
+            nfc_peer_stream_bulk_finish(self, err);
+            return err != EPIPE && err != ECONNRESET;
+        }
+
+        if (!n || (!bulk->unlimited && !bulk->remaining)) {
+            /* EOF or done */
+            GDEBUG("Peer stream %d sent %u bytes", stream->fd, (guint)
+                bulk->sent);
+            nfc_peer_stream_bulk_finish(self, 0);
+            bulk = NULL;
+        }
+    }
+    return TRUE;
+}
+
+static
+void
+nfc_peer_stream_flush(
+    NfcPeerStreamPriv* self)
+{
+    if (!self->pub.closed) {
+        if (nfc_peer_stream_flush_buffer(self) &&
+            nfc_peer_stream_flush_bulk(self)) {
+            nfc_peer_stream_update_watches(self);
+        } else {
+            nfc_peer_stream_closed(self);
+        }
+    }
+}
+
+static
+gboolean
+nfc_peer_stream_source_ready(
+    GIOChannel* channel,
+    GIOCondition condition,
+    gpointer user_data)
+{
+    NfcPeerStreamPriv* self = user_data;
+    NfcPeerStreamBulk* bulk = self->bulk;
+
+    /* EOF and errors are picked up by the next read */
+    bulk->watch_id = 0;
+    bulk->starved = FALSE;
+    nfc_peer_stream_ref(&self->pub);
+    nfc_peer_stream_flush(self);
+    nfc_peer_stream_unref(&self->pub);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+nfc_peer_stream_can_write(
+    GIOChannel* channel,
+    GIOCondition condition,
+    gpointer user_data)
+{
+    NfcPeerStreamPriv* self = user_data;
+
+    self->write_id = 0;
+    nfc_peer_stream_ref(&self->pub);
+    if (condition & (G_IO_ERR | G_IO_HUP)) {
+        nfc_peer_stream_closed(self);
+    } else {
+        nfc_peer_stream_flush(self);
+        /* Held back writes are unblocked after the bulk transfer */
+        if (self->write_blocked && !self->pub.closed && !self->bulk &&
+            self->pub.pending <= NFC_PEER_STREAM_WRITE_LIMIT / 2) {
+            /* There's room for more */
+            self->write_blocked = FALSE;
+            if (self->write_cb) {
+                self->write_cb(&self->pub, self->user_data);
+            }
+        }
+    }
+    nfc_peer_stream_unref(&self->pub);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+nfc_peer_stream_can_read(
+    GIOChannel* channel,
+    GIOCondition condition,
+    gpointer user_data)
+{
+    NfcPeerStreamPriv* self = user_data;
+    NfcPeerStream* stream = &self->pub;
+    gboolean eof = FALSE;
+
+    self->read_id = 0;
+    nfc_peer_stream_ref(stream);
+    if (condition & G_IO_IN) {
+        const gsize space = self->rsize - stream->available;
+        const gsize end = (self->rstart + stream->available) % self->rsize;
+        struct iovec iov[2];
+        int iovcnt = 1;
+        gssize n;
+
+        /* Free space may wrap around the end of the buffer */
+        iov[0].iov_base = self->rbuf + end;
+        iov[0].iov_len = MIN(space, self->rsize - end);
+        if (iov[0].iov_len < space) {
+            iov[1].iov_base = self->rbuf;
+            iov[1].iov_len = space - iov[0].iov_len;
+            iovcnt = 2;
+        }
+        n = readv(stream->fd, iov, iovcnt);
+        if (n > 0) {
+            stream->available += n;
+            if (self->read_cb) {
+                self->read_cb(stream, self->user_data);
+            }
+        } else if (!n || (errno != EAGAIN && errno != EINTR)) {
+            eof = TRUE;
+        }
+    } else if (condition & (G_IO_ERR | G_IO_HUP)) {
+        eof = TRUE;
+    }
+    if (eof) {
+        nfc_peer_stream_closed(self);
+    } else {
+        nfc_peer_stream_update_watches(self);
+    }
+    nfc_peer_stream_unref(stream);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+nfc_peer_stream_update_watches(
+    NfcPeerStreamPriv* self)
+{
+    NfcPeerStream* stream = &self->pub;
+
+    if (!stream->closed) {
+        /* Stop reading when there's no room for a full packet */
+        const gboolean want_read = (self->rsize - stream->available) >=
+            stream->miu;
+        NfcPeerStreamBulk* bulk = self->bulk;
+        const gboolean want_write = stream->pending ||
+            (bulk && !bulk->starved);
+
+        if (want_read && !self->read_id) {
+            self->read_id = g_io_add_watch(self->io,
+                G_IO_IN | G_IO_ERR | G_IO_HUP, nfc_peer_stream_can_read,
+                self);
+        } else if (!want_read && self->read_id) {
+            g_source_remove(self->read_id);
+            self->read_id = 0;
+        }
+        if (want_write && !self->write_id) {
+            self->write_id = g_io_add_watch(self->io,
+                G_IO_OUT | G_IO_ERR | G_IO_HUP, nfc_peer_stream_can_write,
+                self);
+        } else if (!want_write && self->write_id) {
+            g_source_remove(self->write_id);
+            self->write_id = 0;
+        }
+        if (bulk) {
+            if (bulk->starved && !bulk->watch_id) {
+                bulk->watch_id = g_io_add_watch(bulk->io,
+                    G_IO_IN | G_IO_ERR | G_IO_HUP,
+                    nfc_peer_stream_source_ready, self);
+            } else if (!bulk->starved && bulk->watch_id) {
+                g_source_remove(bulk->watch_id);
+                bulk->watch_id = 0;
+            }
+        }
+    }
+}
+
+static
+gsize
+nfc_peer_stream_copy_out(
+    NfcPeerStreamPriv* self,
+    void* buf,
+    gsize size)
+{
+    NfcPeerStream* stream = &self->pub;
+    const gsize n = MIN(size, stream->available);
+
+    if (n && buf) {
+        const gsize first = MIN(n, self->rsize - self->rstart);
+
+        memcpy(buf, self->rbuf + self->rstart, first);
+        if (first < n) {
+            memcpy((guint8*)buf + first, self->rbuf, n - first);
+        }
+    }
+    return n;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+NfcPeerStream*
+nfc_peer_stream_new(
+    int fd,
+    guint miu,
+    gsize buffer_size,
+    NfcPeerStreamFunc read_cb,
+    NfcPeerStreamFunc closed_cb,
+    void* user_data)
+{
+    const int dup_fd = (fd >= 0) ? dup(fd) : -1;
+
+    if (dup_fd >= 0) {
+        NfcPeerStreamPriv* self = g_slice_new0(NfcPeerStreamPriv);
+        NfcPeerStream* stream = &self->pub;
+
+        /*
+         * The duplicate shares the file status flags with the original
+         * descriptor, so this makes both of them non-blocking.
+         */
+        nfc_peer_stream_set_nonblock(dup_fd);
+        g_atomic_int_set(&self->ref_count, 1);
+        stream->fd = dup_fd;
+        stream->miu = miu ? miu : NFC_PEER_STREAM_DEFAULT_MIU;
+        self->rsize = MAX(buffer_size ? buffer_size :
+            NFC_PEER_STREAM_DEFAULT_BUFFER_SIZE, stream->miu);
+        self->rbuf = g_malloc(self->rsize);
+        self->wbuf = g_byte_array_new();
+        self->held = g_byte_array_new();
+        self->read_cb = read_cb;
+        self->closed_cb = closed_cb;
+        self->user_data = user_data;
+        self->io = g_io_channel_unix_new(dup_fd);
+        g_io_channel_set_close_on_unref(self->io, TRUE);
+        nfc_peer_stream_update_watches(self);
+        return stream;
+    }
+    return NULL;
+}
+
+NfcPeerStream*
+nfc_peer_stream_ref(
+    NfcPeerStream* stream)
+{
+    NfcPeerStreamPriv* self = nfc_peer_stream_cast(stream);
+
+    if (G_LIKELY(self)) {
+        GASSERT(self->ref_count > 0);
+        g_atomic_int_inc(&self->ref_count);
+    }
+    return stream;
+}
+
+void
+nfc_peer_stream_unref(
+    NfcPeerStream* stream)
+{
+    NfcPeerStreamPriv* self = nfc_peer_stream_cast(stream);
+
+    if (G_LIKELY(self) && g_atomic_int_dec_and_test(&self->ref_count)) {
+        /* The callbacks are not invoked from here */
+        self->closed_cb = NULL;
+        if (self->bulk) {
+            self->bulk->complete = NULL;
+        }
+        nfc_peer_stream_shutdown(self);
+        g_io_channel_unref(self->io);
+        g_byte_array_free(self->wbuf, TRUE);
+        g_byte_array_free(self->held, TRUE);
+        g_free(self->rbuf);
+        gutil_slice_free(self);
+    }
+}
+
+void
+nfc_peer_stream_close(
+    NfcPeerStream* stream)
+{
+    NfcPeerStreamPriv* self = nfc_peer_stream_cast(stream);
+
+    if (G_LIKELY(self)) {
+        nfc_peer_stream_shutdown(self);
+    }
+}
+
+gboolean
+nfc_peer_stream_write(
+    NfcPeerStream* stream,
+    const void* data,
+    gsize size)
+{
+    GUtilData chunk;
+
+    chunk.bytes = data;
+    chunk.size = size;
+    return nfc_peer_stream_writev(stream, &chunk, 1);
+}
+
+gboolean
+nfc_peer_stream_writev(
+    NfcPeerStream* stream,
+    const GUtilData* chunks,
+    guint count)
+{
+    NfcPeerStreamPriv* self = nfc_peer_stream_cast(stream);
+
+    if (G_LIKELY(self) && !stream->closed && (chunks || !count)) {
+        /*
+         * Whatever is written during the bulk transfer is held back
+         * until the transfer is finished, not to get mixed with it.
+         */
+        GByteArray* buf = self->bulk ? self->held : self->wbuf;
+        const gsize queued = self->bulk ? buf->len : stream->pending;
+        gsize total = 0;
+        guint i;
+
+        for (i = 0; i < count; i++) {
+            total += chunks[i].size;
+        }
+        if (queued && queued + total > NFC_PEER_STREAM_WRITE_LIMIT) {
+            /* No room, the write callback will tell when to try again */
+            self->write_blocked = TRUE;
+            return FALSE;
+        }
+
+        /* Small writes get merged into MIU sized packets */
+        for (i = 0; i < count; i++) {
+            if (chunks[i].size) {
+                g_byte_array_append(buf, chunks[i].bytes, chunks[i].size);
+            }
+        }
+        if (!self->bulk) {
+            stream->pending += total;
+            nfc_peer_stream_flush(self);
+        }
+        return !stream->closed;
+    }
+    return FALSE;
+}
+
+void
+nfc_peer_stream_set_write_func(
+    NfcPeerStream* stream,
+    NfcPeerStreamFunc write_cb)
+{
+    NfcPeerStreamPriv* self = nfc_peer_stream_cast(stream);
+
+    if (G_LIKELY(self)) {
+        self->write_cb = write_cb;
+    }
+}
+
+gsize
+nfc_peer_stream_peek(
+    NfcPeerStream* stream,
+    void* buf,
+    gsize size)
+{
+    NfcPeerStreamPriv* self = nfc_peer_stream_cast(stream);
+
+    return G_LIKELY(self) ? nfc_peer_stream_copy_out(self, buf, size) : 0;
+}
+
+gsize
+nfc_peer_stream_read(
+    NfcPeerStream* stream,
+    void* buf,
+    gsize size)
+{
+    NfcPeerStreamPriv* self = nfc_peer_stream_cast(stream);
+
+    if (G_LIKELY(self)) {
+        const gsize n = nfc_peer_stream_copy_out(self, buf, size);
+
+        if (n) {
+            stream->available -= n;
+            self->rstart = stream->available ?
+                ((self->rstart + n) % self->rsize) : 0;
+            /* There may be room for more now */
+            nfc_peer_stream_update_watches(self);
+        }
+        return n;
+    }
+    return 0;
+}
+
+gboolean
+nfc_peer_stream_send_fd(
+    NfcPeerStream* stream,
+    int fd,
+    gsize count,
+    NfcPeerStreamSendFunc complete,
+    void* user_data,
+    GDestroyNotify destroy)
+{
+    NfcPeerStreamPriv* self = nfc_peer_stream_cast(stream);
+
+    if (G_LIKELY(self) && !stream->closed && !self->bulk && fd >= 0) {
+        NfcPeerStreamBulk* bulk = g_slice_new0(NfcPeerStreamBulk);
+        struct stat st;
+
+        bulk->fd = fd;
+        bulk->remaining = count;
+        bulk->unlimited = !count;
+        bulk->complete = complete;
+        bulk->user_data = user_data;
+        bulk->destroy = destroy;
+        bulk->mode = (!fstat(fd, &st) && S_ISFIFO(st.st_mode)) ?
+            BULK_SPLICE : BULK_SENDFILE;
+        bulk->flags = nfc_peer_stream_set_nonblock(fd);
+        bulk->io = g_io_channel_unix_new(fd);
+        self->bulk = bulk;
+        nfc_peer_stream_flush(self);
+        return TRUE;
+    } else {
+        /* Destroy callback is always invoked even if we return FALSE */
+        if (destroy) {
+            destroy(user_data);
+        }
+        return FALSE;
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
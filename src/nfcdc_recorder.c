@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcdc_recorder.h"
+#include "nfcdc_dbus.h"
+#include "nfcdc_log.h"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define NFC_RECORDER_ALIGN(n) (((n) + 7) & ~7)
+#define NFC_RECORDER_MIN_SIZE (4096)
+
+G_STATIC_ASSERT(sizeof(NfcRecorderHeader) == 64);
+G_STATIC_ASSERT(sizeof(NfcRecorderRecord) == 32);
+
+typedef struct nfc_recorder {
+    GDBusConnection* connection;
+    guint filter_id;
+    void* map;
+    gsize map_size;
+    NfcRecorderHeader* header;
+    guint8* data;
+    gsize size;
+} NfcRecorder;
+
+/*
+ * Filters are invoked on the D-Bus worker thread and may still be
+ * running after g_dbus_connection_remove_filter() returns, hence the
+ * global pointer protected by the lock.
+ */
+static NfcRecorder* nfc_recorder = NULL;
+G_LOCK_DEFINE_STATIC(nfc_recorder);
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static inline
+gboolean
+nfc_recorder_at_end(
+    NfcRecorder* self,
+    gsize pos)
+{
+    return pos + sizeof(NfcRecorderRecord) > self->size ||
+        !((NfcRecorderRecord*) (self->data + pos))->size;
+}
+
+static
+void
+nfc_recorder_drop_oldest(
+    NfcRecorder* self)
+{
+    NfcRecorderHeader* h = self->header;
+
+    if (--h->count) {
+        h->tail += ((NfcRecorderRecord*) (self->data + h->tail))->size;
+        if (nfc_recorder_at_end(self, h->tail)) {
+            h->tail = 0;
+        }
+    } else {
+        h->head = h->tail = 0;
+    }
+}
+
+/* Makes room for len bytes, dropping the oldest records if necessary */
+static
+gsize
+nfc_recorder_reserve(
+    NfcRecorder* self,
+    gsize len)
+{
+    NfcRecorderHeader* h = self->header;
+
+    for (;;) {
+        if (!h->count || h->head > h->tail) {
+            /* Free space is [head, size) and [0, tail) */
+            if (h->head + len <= self->size) {
+                return h->head;
+            }
+            if (h->head + sizeof(guint32) <= self->size) {
+                /* End of the lap */
+                *((guint32*) (self->data + h->head)) = 0;
+            }
+            h->head = 0;
+            if (!h->count) {
+                return 0;
+            }
+        } else if (h->head + len <= h->tail) {
+            /* Free space is [head, tail) */
+            return h->head;
+        } else {
+            nfc_recorder_drop_oldest(self);
+        }
+    }
+}
+
+static inline
+guint8*
+nfc_recorder_put(
+    guint8* ptr,
+    const void* data,
+    gsize len)
+{
+    if (len) {
+        memcpy(ptr, data, len);
+    }
+    return ptr + len;
+}
+
+static
+void
+nfc_recorder_write(
+    NfcRecorder* self,
+    GDBusMessage* message,
+    gboolean incoming)
+{
+    const char* path = g_dbus_message_get_path(message);
+    const char* member = g_dbus_message_get_member(message);
+    const char* signature = g_dbus_message_get_signature(message);
+    GVariant* body = g_dbus_message_get_body(message);
+    const GDBusMessageType type = g_dbus_message_get_message_type(message);
+    const gsize max_len = self->size / 4;
+    NfcRecorderRecord rec;
+    gsize path_len, member_len, sig_len, body_len, len, pos;
+    guint8* ptr;
+
+    if (type == G_DBUS_MESSAGE_TYPE_ERROR) {
+        member = g_dbus_message_get_error_name(message);
+    }
+    path_len = path ? MIN(strlen(path), G_MAXUINT16) : 0;
+    member_len = member ? MIN(strlen(member), G_MAXUINT8) : 0;
+    sig_len = signature ? MIN(strlen(signature), G_MAXUINT8) : 0;
+    body_len = body ? g_variant_get_size(body) : 0;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.type = (guint8) type;
+    rec.flags = incoming ? NFC_RECORDER_FLAG_INCOMING : 0;
+    len = sizeof(rec) + path_len + member_len + sig_len;
+    if (len + body_len > max_len) {
+        /* Keep the ring from being flushed by a single record */
+        body_len = (max_len > len) ? (max_len - len) : 0;
+        rec.flags |= NFC_RECORDER_FLAG_TRUNCATED;
+    }
+    len = NFC_RECORDER_ALIGN(len + body_len);
+    if (len > max_len) {
+        return;
+    }
+
+    rec.size = (guint32) len;
+    rec.member_len = (guint8) member_len;
+    rec.signature_len = (guint8) sig_len;
+    rec.path_len = (guint16) path_len;
+    rec.serial = g_dbus_message_get_serial(message);
+    rec.reply_serial = g_dbus_message_get_reply_serial(message);
+    rec.body_len = (guint32) body_len;
+    rec.time = g_get_monotonic_time();
+
+    pos = nfc_recorder_reserve(self, len);
+    ptr = nfc_recorder_put(self->data + pos, &rec, sizeof(rec));
+    ptr = nfc_recorder_put(ptr, path, path_len);
+    ptr = nfc_recorder_put(ptr, member, member_len);
+    ptr = nfc_recorder_put(ptr, signature, sig_len);
+    nfc_recorder_put(ptr, body_len ? g_variant_get_data(body) : NULL,
+        body_len);
+
+    self->header->head = pos + len;
+    self->header->count++;
+}
+
+static
+GDBusMessage*
+nfc_recorder_filter(
+    GDBusConnection* connection,
+    GDBusMessage* message,
+    gboolean incoming,
+    gpointer user_data)
+{
+    G_LOCK(nfc_recorder);
+    if (nfc_recorder) {
+        nfc_recorder_write(nfc_recorder, message, incoming);
+    }
+    G_UNLOCK(nfc_recorder);
+    return message;
+}
+
+static
+void
+nfc_recorder_free(
+    NfcRecorder* self)
+{
+    if (self->filter_id) {
+        g_dbus_connection_remove_filter(self->connection, self->filter_id);
+    }
+    if (self->connection) {
+        g_object_unref(self->connection);
+    }
+    if (self->map) {
+        msync(self->map, self->map_size, MS_ASYNC);
+        munmap(self->map, self->map_size);
+    }
+    g_slice_free(NfcRecorder, self);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+gboolean
+nfc_recorder_start(
+    const char* path,
+    gsize size)
+{
+    NfcRecorder* self;
+    GError* error = NULL;
+    int fd;
+
+    if (G_UNLIKELY(!path)) {
+        return FALSE;
+    }
+
+    nfc_recorder_stop();
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        GERR("Can't open %s: %s", path, strerror(errno));
+        return FALSE;
+    }
+
+    self = g_slice_new0(NfcRecorder);
+    self->size = NFC_RECORDER_ALIGN(MAX(size, NFC_RECORDER_MIN_SIZE));
+    self->map_size = sizeof(NfcRecorderHeader) + self->size;
+    if (ftruncate(fd, self->map_size) < 0) {
+        GERR("Can't resize %s: %s", path, strerror(errno));
+    } else {
+        void* map = mmap(NULL, self->map_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+
+        if (map == MAP_FAILED) {
+            GERR("Can't map %s: %s", path, strerror(errno));
+        } else {
+            NfcRecorderHeader* h = map;
+
+            self->map = map;
+            self->header = h;
+            self->data = (guint8*) (h + 1);
+            memcpy(h->magic, NFC_RECORDER_MAGIC, sizeof(h->magic));
+            h->version = NFC_RECORDER_VERSION;
+            h->header_size = sizeof(*h);
+            h->data_size = self->size;
+            h->start_time = g_get_monotonic_time();
+            h->start_real_time = g_get_real_time();
+        }
+    }
+    close(fd);
+
+    if (self->map) {
+        self->connection = g_bus_get_sync(NFCD_DBUS_TYPE, NULL, &error);
+        if (self->connection) {
+            G_LOCK(nfc_recorder);
+            nfc_recorder = self;
+            G_UNLOCK(nfc_recorder);
+            self->filter_id = g_dbus_connection_add_filter(self->connection,
+                nfc_recorder_filter, NULL, NULL);
+            GDEBUG("Recording to %s", path);
+            return TRUE;
+        }
+        GERR("%s", GERRMSG(error));
+        g_error_free(error);
+    }
+    nfc_recorder_free(self);
+    return FALSE;
+}
+
+void
+nfc_recorder_stop(
+    void)
+{
+    NfcRecorder* self;
+
+    G_LOCK(nfc_recorder);
+    self = nfc_recorder;
+    nfc_recorder = NULL;
+    G_UNLOCK(nfc_recorder);
+    if (self) {
+        GDEBUG("Recording stopped");
+        nfc_recorder_free(self);
+    }
+}
+
+gboolean
+nfc_recorder_active(
+    void)
+{
+    gboolean active;
+
+    G_LOCK(nfc_recorder);
+    active = (nfc_recorder != NULL);
+    G_UNLOCK(nfc_recorder);
+    return active;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
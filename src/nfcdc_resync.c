@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcdc_resync_p.h"
+#include "nfcdc_log.h"
+
+#include <gutil_macros.h>
+
+/* Maximum number of initialization chains in flight */
+#define NFC_RESYNC_MAX_ACTIVE (8)
+
+struct nfc_resync {
+    GObject* object;
+    NfcResyncFunc start;
+    gboolean active;
+};
+
+/* Clients only live on the main thread, so no locking */
+static GQueue nfc_resync_queue = G_QUEUE_INIT;
+static guint nfc_resync_active = 0;
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+nfc_resync_start(
+    NfcResync* resync)
+{
+    resync->active = TRUE;
+    nfc_resync_active++;
+    resync->start(resync->object);
+}
+
+static
+void
+nfc_resync_start_next(
+    void)
+{
+    while (nfc_resync_active < NFC_RESYNC_MAX_ACTIVE &&
+        nfc_resync_queue.length) {
+        nfc_resync_start(g_queue_pop_head(&nfc_resync_queue));
+    }
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+void
+nfc_resync_submit(
+    NfcResync** ticket,
+    GObject* object,
+    NfcResyncFunc start)
+{
+    NfcResync* resync = g_slice_new0(NfcResync);
+
+    GASSERT(!*ticket);
+    g_object_ref(resync->object = object);
+    resync->start = start;
+    *ticket = resync;
+    if (nfc_resync_active < NFC_RESYNC_MAX_ACTIVE) {
+        nfc_resync_start(resync);
+    } else {
+        g_queue_push_tail(&nfc_resync_queue, resync);
+        GDEBUG("%u resync(s) queued", nfc_resync_queue.length);
+    }
+}
+
+void
+nfc_resync_done(
+    NfcResync** ticket)
+{
+    NfcResync* resync = *ticket;
+
+    if (resync) {
+        GObject* object = resync->object;
+
+        *ticket = NULL;
+        if (resync->active) {
+            GASSERT(nfc_resync_active > 0);
+            nfc_resync_active--;
+        } else {
+            g_queue_remove(&nfc_resync_queue, resync);
+        }
+        gutil_slice_free(resync);
+        nfc_resync_start_next();
+        g_object_unref(object);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcdc_retry_p.h"
+#include "nfcdc_log.h"
+
+#define NFC_CLIENT_RETRY_DEFAULT_INITIAL_DELAY_MS (250)
+#define NFC_CLIENT_RETRY_DEFAULT_MAX_DELAY_MS (10000)
+#define NFC_CLIENT_RETRY_DEFAULT_MAX_RETRIES (5)
+
+static const NfcClientRetryPolicy nfc_client_retry_default_policy = {
+    NFC_CLIENT_RETRY_DEFAULT_INITIAL_DELAY_MS,
+    NFC_CLIENT_RETRY_DEFAULT_MAX_DELAY_MS,
+    NFC_CLIENT_RETRY_DEFAULT_MAX_RETRIES
+};
+
+static NfcClientRetryPolicy nfc_client_retry_policy = {
+    NFC_CLIENT_RETRY_DEFAULT_INITIAL_DELAY_MS,
+    NFC_CLIENT_RETRY_DEFAULT_MAX_DELAY_MS,
+    NFC_CLIENT_RETRY_DEFAULT_MAX_RETRIES
+};
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+guint
+nfc_client_retry_delay(
+    guint attempt)
+{
+    const NfcClientRetryPolicy* policy = &nfc_client_retry_policy;
+    /* g_random_int_range() takes gint32 */
+    const guint max = MIN(MAX(policy->max_delay_ms, 1), G_MAXINT32);
+    guint delay = MIN(MAX(policy->initial_delay_ms, 1), max);
+
+    /* Exponential backoff, doubling until it hits the limit */
+    while (--attempt > 0 && delay < max) {
+        delay = (delay > max / 2) ? max : (delay * 2);
+    }
+
+    /* And the jitter, so that clients don't retry in lockstep */
+    return (delay + 1) / 2 + g_random_int_range(0, delay / 2 + 1);
+}
+
+static
+gboolean
+nfc_client_retry_timeout(
+    gpointer user_data)
+{
+    NfcClientRetry* retry = user_data;
+
+    retry->timer_id = 0;
+    retry->func(retry->object);
+    return G_SOURCE_REMOVE;
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+gboolean
+nfc_client_retry_schedule(
+    NfcClientRetry* retry,
+    GObject* object,
+    NfcClientRetryFunc func)
+{
+    if (retry->timer_id) {
+        g_source_remove(retry->timer_id);
+        retry->timer_id = 0;
+    }
+    if (retry->attempts < nfc_client_retry_policy.max_retries) {
+        const guint delay = nfc_client_retry_delay(++retry->attempts);
+
+        GDEBUG("Retry %u in %u ms", retry->attempts, delay);
+        retry->object = object;
+        retry->func = func;
+        retry->timer_id = g_timeout_add(delay, nfc_client_retry_timeout,
+            retry);
+        return TRUE;
+    } else {
+        GDEBUG("Giving up after %u retries", retry->attempts);
+        return FALSE;
+    }
+}
+
+void
+nfc_client_retry_reset(
+    NfcClientRetry* retry)
+{
+    if (retry->timer_id) {
+        g_source_remove(retry->timer_id);
+        retry->timer_id = 0;
+    }
+    retry->attempts = 0;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+nfc_client_retry_get_policy(
+    NfcClientRetryPolicy* policy)
+{
+    if (G_LIKELY(policy)) {
+        *policy = nfc_client_retry_policy;
+    }
+}
+
+void
+nfc_client_retry_set_policy(
+    const NfcClientRetryPolicy* policy)
+{
+    nfc_client_retry_policy = policy ? *policy :
+        nfc_client_retry_default_policy;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
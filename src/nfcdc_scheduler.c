@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcdc_scheduler_p.h"
+#include "nfcdc_log.h"
+
+#include <gutil_macros.h>
+
+/* No limit unless the application asks for one */
+#define NFC_CALL_SCHEDULER_DEFAULT_WINDOW (0)
+
+typedef struct nfc_scheduler_entry {
+    guint id;
+    guint* id_ptr;
+    NfcSchedulerStartFunc start;
+    gpointer data;
+} NfcSchedulerEntry;
+
+struct nfc_scheduler {
+    GQueue queue[NFC_CALL_PRIORITY_COUNT];
+    NfcSchedulerFunc congestion_changed;
+    gpointer data;
+    guint last_id;
+    guint in_flight;
+    gboolean congested;
+    gboolean running;
+    gboolean dead;
+};
+
+static guint nfc_call_scheduler_current_window =
+    NFC_CALL_SCHEDULER_DEFAULT_WINDOW;
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+void
+nfc_scheduler_destroy(
+    NfcScheduler* self)
+{
+    int i;
+
+    for (i = 0; i < NFC_CALL_PRIORITY_COUNT; i++) {
+        NfcSchedulerEntry* entry;
+
+        /* Queued calls are supposed to keep the owner alive */
+        GASSERT(g_queue_is_empty(self->queue + i));
+        while ((entry = g_queue_pop_head(self->queue + i)) != NULL) {
+            if (entry->id_ptr) {
+                *entry->id_ptr = 0;
+            }
+            gutil_slice_free(entry);
+        }
+    }
+    gutil_slice_free(self);
+}
+
+static
+gboolean
+nfc_scheduler_has_queued_calls(
+    NfcScheduler* self)
+{
+    int i;
+
+    for (i = 0; i < NFC_CALL_PRIORITY_COUNT; i++) {
+        if (!g_queue_is_empty(self->queue + i)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static
+void
+nfc_scheduler_update_congested(
+    NfcScheduler* self)
+{
+    const gboolean congested = nfc_scheduler_has_queued_calls(self);
+
+    if (self->congested != congested) {
+        self->congested = congested;
+        if (self->congestion_changed) {
+            self->congestion_changed(self->data);
+        }
+    }
+}
+
+static
+NfcSchedulerEntry*
+nfc_scheduler_next(
+    NfcScheduler* self)
+{
+    int i;
+
+    for (i = NFC_CALL_PRIORITY_COUNT - 1; i >= 0; i--) {
+        NfcSchedulerEntry* entry = g_queue_pop_head(self->queue + i);
+
+        if (entry) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static
+void
+nfc_scheduler_run(
+    NfcScheduler* self)
+{
+    /*
+     * The start callback may complete the call synchronously, and that
+     * may submit more calls. Those will be picked up by the outer loop.
+     */
+    if (!self->running) {
+        const guint window = nfc_call_scheduler_current_window;
+
+        self->running = TRUE;
+        while (!self->dead && (!window || self->in_flight < window)) {
+            NfcSchedulerEntry* entry = nfc_scheduler_next(self);
+
+            if (entry) {
+                if (entry->id_ptr) {
+                    *entry->id_ptr = 0;
+                }
+                self->in_flight++;
+                if (!entry->start(entry->data)) {
+                    self->in_flight--;
+                }
+                gutil_slice_free(entry);
+            } else {
+                break;
+            }
+        }
+        self->running = FALSE;
+        if (self->dead) {
+            /* Freed by the callback */
+            nfc_scheduler_destroy(self);
+        } else {
+            nfc_scheduler_update_congested(self);
+        }
+    }
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+NfcScheduler*
+nfc_scheduler_new(
+    NfcSchedulerFunc congestion_changed,
+    gpointer data)
+{
+    NfcScheduler* self = g_slice_new0(NfcScheduler);
+    int i;
+
+    for (i = 0; i < NFC_CALL_PRIORITY_COUNT; i++) {
+        g_queue_init(self->queue + i);
+    }
+    self->congestion_changed = congestion_changed;
+    self->data = data;
+    return self;
+}
+
+void
+nfc_scheduler_free(
+    NfcScheduler* self)
+{
+    if (self) {
+        if (self->running) {
+            /* nfc_scheduler_run() will take care of it */
+            self->dead = TRUE;
+        } else {
+            nfc_scheduler_destroy(self);
+        }
+    }
+}
+
+void
+nfc_scheduler_submit(
+    NfcScheduler* self,
+    NFC_CALL_PRIORITY priority,
+    NfcSchedulerStartFunc start,
+    gpointer data,
+    guint* id)
+{
+    NfcSchedulerEntry* entry = g_slice_new(NfcSchedulerEntry);
+
+    /* Zero is reserved for "not queued" */
+    entry->id = ++self->last_id;
+    if (!entry->id) {
+        entry->id = ++self->last_id;
+    }
+    entry->id_ptr = id;
+    entry->start = start;
+    entry->data = data;
+    if (id) {
+        *id = entry->id;
+    }
+    if (priority < NFC_CALL_PRIORITY_BACKGROUND ||
+        priority >= NFC_CALL_PRIORITY_COUNT) {
+        priority = NFC_CALL_PRIORITY_DEFAULT;
+    }
+    g_queue_push_tail(self->queue + priority, entry);
+    nfc_scheduler_run(self);
+}
+
+gboolean
+nfc_scheduler_cancel(
+    NfcScheduler* self,
+    guint id)
+{
+    if (self && id) {
+        int i;
+
+        for (i = 0; i < NFC_CALL_PRIORITY_COUNT; i++) {
+            GQueue* queue = self->queue + i;
+            GList* l;
+
+            for (l = queue->head; l; l = l->next) {
+                NfcSchedulerEntry* entry = l->data;
+
+                if (entry->id == id) {
+                    g_queue_delete_link(queue, l);
+                    if (entry->id_ptr) {
+                        *entry->id_ptr = 0;
+                    }
+                    gutil_slice_free(entry);
+                    nfc_scheduler_update_congested(self);
+                    return TRUE;
+                }
+            }
+        }
+    }
+    return FALSE;
+}
+
+void
+nfc_scheduler_finish(
+    NfcScheduler* self)
+{
+    GASSERT(self->in_flight > 0);
+    if (self->in_flight > 0) {
+        self->in_flight--;
+    }
+    nfc_scheduler_run(self);
+}
+
+gboolean
+nfc_scheduler_congested(
+    NfcScheduler* self)
+{
+    return self && self->congested;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+nfc_call_scheduler_set_window(
+    guint window)
+{
+    /* Takes effect when the next call gets submitted or completed */
+    nfc_call_scheduler_current_window = window;
+}
+
+guint
+nfc_call_scheduler_window(
+    void)
+{
+    return nfc_call_scheduler_current_window;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_SCHEDULER_PRIVATE_H
+#define NFCDC_SCHEDULER_PRIVATE_H
+
+#include "nfcdc_scheduler.h"
+
+typedef struct nfc_scheduler NfcScheduler;
+
+/*
+ * Returns FALSE if the call has failed to start, in which case it has
+ * already been completed and deallocated.
+ */
+typedef
+gboolean
+(*NfcSchedulerStartFunc)(
+    gpointer data);
+
+typedef
+void
+(*NfcSchedulerFunc)(
+    gpointer data);
+
+NfcScheduler*
+nfc_scheduler_new(
+    NfcSchedulerFunc congestion_changed,
+    gpointer data)
+    G_GNUC_INTERNAL;
+
+void
+nfc_scheduler_free(
+    NfcScheduler* scheduler)
+    G_GNUC_INTERNAL;
+
+/*
+ * Starts the call right away or queues it, in which case non-zero
+ * id is stored at the location pointed to by id (unless it's NULL).
+ * It's zeroed when the call gets started or cancelled.
+ */
+void
+nfc_scheduler_submit(
+    NfcScheduler* scheduler,
+    NFC_CALL_PRIORITY priority,
+    NfcSchedulerStartFunc start,
+    gpointer data,
+    guint* id)
+    G_GNUC_INTERNAL;
+
+/* Removes the queued call from the queue, nothing gets invoked */
+gboolean
+nfc_scheduler_cancel(
+    NfcScheduler* scheduler,
+    guint id)
+    G_GNUC_INTERNAL;
+
+/* The call started by the scheduler has completed */
+void
+nfc_scheduler_finish(
+    NfcScheduler* scheduler)
+    G_GNUC_INTERNAL;
+
+gboolean
+nfc_scheduler_congested(
+    NfcScheduler* scheduler)
+    G_GNUC_INTERNAL;
+
+#endif /* NFCDC_SCHEDULER_PRIVATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,350 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcdc_adapter_p.h"
+#include "nfcdc_isodep_p.h"
+#include "nfcdc_peer_p.h"
+#include "nfcdc_stats_p.h"
+#include "nfcdc_tag_p.h"
+
+#include <gutil_strv.h>
+
+/*
+ * Bucket index is made of the position of the most significant bit
+ * and the next NFC_CLIENT_STATS_SUB_BITS bits below it. Values below
+ * NFC_CLIENT_STATS_SUB_BUCKETS map to buckets one to one.
+ */
+#define NFC_CLIENT_STATS_SUB_BITS (2)
+#define NFC_CLIENT_STATS_SUB_BUCKETS (1 << NFC_CLIENT_STATS_SUB_BITS)
+
+G_STATIC_ASSERT(NFC_CLIENT_STATS_BUCKETS ==
+    (32 - NFC_CLIENT_STATS_SUB_BITS + 1) * NFC_CLIENT_STATS_SUB_BUCKETS);
+
+typedef struct nfc_client_stats_adapter {
+    NfcClientStatsHistogram op[NFC_CLIENT_OP_COUNT];
+} NfcClientStatsAdapter;
+
+static gint nfc_client_stats_on = FALSE;
+static GHashTable* nfc_client_stats_table = NULL;
+G_LOCK_DEFINE_STATIC(nfc_client_stats);
+
+static const char* const nfc_client_stats_op_names[] = {
+    "Transmit",
+    "Transceive",
+    "Acquire",
+    "Daemon.GetAll",
+    "Daemon.GetAll2",
+    "Daemon.GetAll3",
+    "Daemon.GetAll4",
+    "Adapter.GetAll",
+    "Adapter.GetAll2",
+    "Adapter.GetAll3",
+    "Adapter.GetAll4",
+    "Tag.GetAll",
+    "Tag.GetAll3",
+    "IsoDep.GetAll",
+    "IsoDep.GetAll2",
+    "Peer.GetAll",
+    "RequestMode",
+    "ReleaseMode",
+    "RequestTechs",
+    "ReleaseTechs"
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(nfc_client_stats_op_names) ==
+    NFC_CLIENT_OP_COUNT);
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static
+guint
+nfc_client_stats_bucket(
+    guint64 us)
+{
+    if (us < NFC_CLIENT_STATS_SUB_BUCKETS) {
+        return (guint) us;
+    } else if (us > G_MAXUINT32) {
+        return NFC_CLIENT_STATS_BUCKETS - 1;
+    } else {
+        const guint msb = g_bit_storage((gulong) us) - 1;
+        const guint sub = (guint) (us >> (msb - NFC_CLIENT_STATS_SUB_BITS)) &
+            (NFC_CLIENT_STATS_SUB_BUCKETS - 1);
+
+        return (msb - NFC_CLIENT_STATS_SUB_BITS + 1) *
+            NFC_CLIENT_STATS_SUB_BUCKETS + sub;
+    }
+}
+
+static
+void
+nfc_client_stats_record(
+    NfcClientStatsHistogram* h,
+    guint64 us,
+    gboolean failed)
+{
+    if (!h->count || h->min_us > us) {
+        h->min_us = us;
+    }
+    if (h->max_us < us) {
+        h->max_us = us;
+    }
+    h->count++;
+    h->sum_us += us;
+    h->buckets[nfc_client_stats_bucket(us)]++;
+    if (failed) {
+        h->errors++;
+    }
+}
+
+static
+NfcClientStatsAdapter*
+nfc_client_stats_adapter(
+    const char* path)
+{
+    /* The first path component identifies the adapter */
+    const char* end = path[0] ? strchr(path + 1, '/') : NULL;
+    const gsize len = end ? (gsize)(end - path) : strlen(path);
+    NfcClientStatsAdapter* adapter;
+    char buf[64];
+    char* key;
+
+    if (len < sizeof(buf)) {
+        memcpy(key = buf, path, len);
+        key[len] = 0;
+    } else {
+        key = g_strndup(path, len);
+    }
+
+    if (!nfc_client_stats_table) {
+        nfc_client_stats_table = g_hash_table_new_full(g_str_hash,
+            g_str_equal, g_free, g_free);
+    }
+
+    adapter = g_hash_table_lookup(nfc_client_stats_table, key);
+    if (!adapter) {
+        adapter = g_new0(NfcClientStatsAdapter, 1);
+        g_hash_table_insert(nfc_client_stats_table, (key == buf) ?
+            g_strdup(key) : key, adapter);
+    } else if (key != buf) {
+        g_free(key);
+    }
+    return adapter;
+}
+
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+gint64
+nfc_client_stats_start(
+    void)
+{
+    return g_atomic_int_get(&nfc_client_stats_on) ?
+        g_get_monotonic_time() : 0;
+}
+
+void
+nfc_client_stats_finish(
+    const char* path,
+    NFC_CLIENT_OP op,
+    gint64 start,
+    const GError* error)
+{
+    /* Zero start means that the call was issued with stats disabled */
+    if (start && path && op < NFC_CLIENT_OP_COUNT &&
+        g_atomic_int_get(&nfc_client_stats_on)) {
+        const gint64 now = g_get_monotonic_time();
+
+        G_LOCK(nfc_client_stats);
+        nfc_client_stats_record(nfc_client_stats_adapter(path)->op + op,
+            (now > start) ? (guint64)(now - start) : 0, error != NULL);
+        G_UNLOCK(nfc_client_stats);
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+nfc_client_stats_set_enabled(
+    gboolean enabled)
+{
+    g_atomic_int_set(&nfc_client_stats_on, enabled != FALSE);
+}
+
+gboolean
+nfc_client_stats_enabled(
+    void)
+{
+    return g_atomic_int_get(&nfc_client_stats_on);
+}
+
+void
+nfc_client_stats_reset(
+    void)
+{
+    G_LOCK(nfc_client_stats);
+    if (nfc_client_stats_table) {
+        g_hash_table_destroy(nfc_client_stats_table);
+        nfc_client_stats_table = NULL;
+    }
+    G_UNLOCK(nfc_client_stats);
+}
+
+char**
+nfc_client_stats_adapters(
+    void)
+{
+    GPtrArray* paths = g_ptr_array_new();
+
+    G_LOCK(nfc_client_stats);
+    if (nfc_client_stats_table) {
+        GHashTableIter it;
+        gpointer key;
+
+        g_hash_table_iter_init(&it, nfc_client_stats_table);
+        while (g_hash_table_iter_next(&it, &key, NULL)) {
+            g_ptr_array_add(paths, g_strdup(key));
+        }
+    }
+    G_UNLOCK(nfc_client_stats);
+    g_ptr_array_add(paths, NULL);
+    return gutil_strv_sort((char**) g_ptr_array_free(paths, FALSE), TRUE);
+}
+
+gboolean
+nfc_client_stats_get(
+    const char* adapter,
+    NFC_CLIENT_OP op,
+    NfcClientStatsHistogram* histogram)
+{
+    gboolean found = FALSE;
+
+    if (G_LIKELY(adapter) && op < NFC_CLIENT_OP_COUNT) {
+        NfcClientStatsAdapter* stats;
+
+        G_LOCK(nfc_client_stats);
+        stats = nfc_client_stats_table ?
+            g_hash_table_lookup(nfc_client_stats_table, adapter) : NULL;
+        if (stats && stats->op[op].count) {
+            if (histogram) {
+                *histogram = stats->op[op];
+            }
+            found = TRUE;
+        }
+        G_UNLOCK(nfc_client_stats);
+    }
+    if (!found && histogram) {
+        memset(histogram, 0, sizeof(*histogram));
+    }
+    return found;
+}
+
+const char*
+nfc_client_stats_op_name(
+    NFC_CLIENT_OP op)
+{
+    return (op < NFC_CLIENT_OP_COUNT) ? nfc_client_stats_op_names[op] : NULL;
+}
+
+guint64
+nfc_client_stats_bucket_min(
+    guint bucket)
+{
+    if (bucket < NFC_CLIENT_STATS_SUB_BUCKETS) {
+        return bucket;
+    } else if (bucket < NFC_CLIENT_STATS_BUCKETS) {
+        const guint msb = bucket / NFC_CLIENT_STATS_SUB_BUCKETS +
+            NFC_CLIENT_STATS_SUB_BITS - 1;
+        const guint sub = bucket % NFC_CLIENT_STATS_SUB_BUCKETS;
+
+        return (G_GUINT64_CONSTANT(1) << msb) |
+            ((guint64) sub << (msb - NFC_CLIENT_STATS_SUB_BITS));
+    } else {
+        return G_MAXUINT64;
+    }
+}
+
+guint64
+nfc_client_stats_percentile(
+    const NfcClientStatsHistogram* h,
+    double percent)
+{
+    if (G_LIKELY(h) && h->count) {
+        const double limit = h->count * CLAMP(percent, 0, 100) / 100;
+        guint64 total = 0;
+        guint i;
+
+        for (i = 0; i < NFC_CLIENT_STATS_BUCKETS; i++) {
+            total += h->buckets[i];
+            if (total && total >= limit) {
+                return MAX(nfc_client_stats_bucket_min(i), h->min_us);
+            }
+        }
+        return h->max_us;
+    }
+    return 0;
+}
+
+guint
+nfc_client_stats_live_objects(
+    NFC_CLIENT_OBJECT type)
+{
+    switch (type) {
+    case NFC_CLIENT_OBJECT_ADAPTER:
+        return nfc_adapter_client_count();
+    case NFC_CLIENT_OBJECT_TAG:
+        return nfc_tag_client_count();
+    case NFC_CLIENT_OBJECT_ISODEP:
+        return nfc_isodep_client_count();
+    case NFC_CLIENT_OBJECT_PEER:
+        return nfc_peer_client_count();
+    case NFC_CLIENT_OBJECT_COUNT:
+        break;
+    }
+    return 0;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
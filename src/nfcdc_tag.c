@@ -40,7 +40,13 @@
 #include "nfcdc_adapter_p.h"
 #include "nfcdc_base.h"
 #include "nfcdc_dbus.h"
+#include "nfcdc_error.h"
 #include "nfcdc_log.h"
+#include "nfcdc_resync_p.h"
+#include "nfcdc_retry_p.h"
+#include "nfcdc_scheduler_p.h"
+#include "nfcdc_stats_p.h"
+#include "nfcdc_trace_p.h"
 #include "nfcdc_tag_p.h"
 #include "nfcdc_util_p.h"
 
@@ -56,6 +62,16 @@ enum nfc_tag_client_adapter_signals {
     ADAPTER_SIGNAL_COUNT
 };
 
+/* Property groups which lite clients fetch on demand */
+enum nfc_tag_client_groups {
+    TAG_GROUP_NONE = 0x00,
+    TAG_GROUP_INTERFACES = 0x01,
+    TAG_GROUP_NDEF_RECORDS = 0x02,
+    TAG_GROUP_TECHNOLOGY = 0x04,
+    TAG_GROUP_POLL_PARAMS = 0x08,
+    TAG_GROUP_ALL = 0x0f
+};
+
 typedef NfcClientBaseClass NfcTagClientObjectClass;
 typedef struct nfc_tag_client_object {
     NfcClientBase base;
@@ -67,10 +83,18 @@ typedef struct nfc_tag_client_object {
     OrgSailfishosNfcTag* proxy;
     GHashTable* poll_params;
     gboolean proxy_initializing;
+    gint64 get_all_start;
     gint version;
     const char* name;
     GStrV* interfaces;
     GStrV* ndef_records;
+    NfcResync* resync;
+    NfcClientRetry retry;
+    NfcScheduler* scheduler;
+    guint wanted;
+    guint required;
+    guint fetched;
+    guint fetching;
 } NfcTagClientObject;
 
 #define PARENT_CLASS nfc_tag_client_object_parent_class
@@ -92,6 +116,14 @@ NFC_CLIENT_BASE_ASSERT_COUNT(NFC_TAG_PROPERTY_COUNT);
 #define nfc_tag_client_queue_signal(self,NAME) \
     ((self)->base.queued_signals |= SIGNAL_BIT_(NAME))
 
+typedef struct nfc_tag_client_fetch {
+    NfcTagClientObject* obj;
+    OrgSailfishosNfcTag* proxy;
+    guint groups;
+    guint pending;
+    guint queue_id;
+} NfcTagClientFetch;
+
 typedef struct nfc_tag_client_call NfcTagClientCall;
 
 typedef
@@ -109,10 +141,16 @@ struct nfc_tag_client_call {
     void* user_data;
     GCancellable* cancel;
     gulong cancel_id;
+    guint deadline_id;
+    guint queue_id;
+    gboolean in_flight;
+    GVariant* data;
+    gint64 start;
 };
 
 static char* nfc_tag_client_empty_strv = NULL;
 static GHashTable* nfc_tag_client_table;
+static guint nfc_tag_client_last_lock_id;
 
 static
 void
@@ -126,6 +164,7 @@ nfc_tag_client_reinit(
 struct nfc_tag_client_lock {
     NfcTagClientObject* tag;
     gint ref_count;
+    guint id;
 };
 
 typedef struct nfc_tag_client_lock_data {
@@ -135,6 +174,8 @@ typedef struct nfc_tag_client_lock_data {
     void* user_data;
     GCancellable* cancel;
     gulong cancel_id;
+    guint deadline_id;
+    gint64 start;
 } NfcTagClientLockData;
 
 typedef struct nfc_tag_client_lock_data_idle {
@@ -178,6 +219,9 @@ void
 nfc_tag_client_lock_data_deinit(
     NfcTagClientLockData* data)
 {
+    if (data->deadline_id) {
+        g_source_remove(data->deadline_id);
+    }
     if (data->cancel) {
         g_signal_handler_disconnect(data->cancel, data->cancel_id);
         g_object_unref(data->cancel);
@@ -223,6 +267,28 @@ nfc_tag_client_lock_idle_callback(
     return G_SOURCE_REMOVE;
 }
 
+static
+gboolean
+nfc_tag_client_lock_deadline(
+    gpointer user_data)
+{
+    NfcTagClientLockData* data = user_data;
+    NfcTagClientObject* tag = data->tag;
+
+    data->deadline_id = 0;
+    if (data->callback) {
+        NfcTagClientLockFunc callback = data->callback;
+        GError* error = nfc_deadline_error();
+
+        /* The lock will be released as soon as Acquire completes */
+        GWARN("Failed to acquire %s lock: %s", tag->name, error->message);
+        data->callback = NULL;
+        callback(&tag->pub, NULL, error, data->user_data);
+        g_error_free(error);
+    }
+    return G_SOURCE_REMOVE;
+}
+
 static
 void
 nfc_tag_client_lock_done(
@@ -267,6 +333,8 @@ nfc_tag_client_lock_acquire_done(
     } else {
         GWARN("Failed to acquire %s lock: %s", tag->name, GERRMSG(error));
     }
+    nfc_client_stats_finish(tag->pub.path, NFC_CLIENT_OP_ACQUIRE,
+        data->start, error);
 
     if (data->callback) {
         NfcTagClientLockFunc callback = data->callback;
@@ -290,6 +358,9 @@ nfc_tag_client_lock_acquire_done(
                 lock = g_slice_new0(NfcTagClientLock);
                 g_atomic_int_set(&lock->ref_count, 1);
                 g_object_ref(lock->tag = tag);
+                if (!(lock->id = ++nfc_tag_client_last_lock_id)) {
+                    lock->id = ++nfc_tag_client_last_lock_id;
+                }
                 tag->lock = lock;
             }
             callback(&tag->pub, lock, error, data->user_data);
@@ -357,6 +428,15 @@ nfc_tag_client_object_cast(
         NULL;
 }
 
+static
+void
+nfc_tag_client_init_done(
+    NfcTagClientObject* self)
+{
+    self->proxy_initializing = FALSE;
+    nfc_resync_done(&self->resync);
+}
+
 static
 int
 nfc_tag_client_poll_param_key(
@@ -412,6 +492,29 @@ nfc_tag_client_call_new(
     return call;
 }
 
+static
+void
+nfc_tag_client_call_free(
+    NfcTagClientCall* call)
+{
+    GASSERT(!call->queue_id);
+    if (call->deadline_id) {
+        g_source_remove(call->deadline_id);
+    }
+    if (call->cancel) {
+        g_signal_handler_disconnect(call->cancel, call->cancel_id);
+        g_object_unref(call->cancel);
+    }
+    if (call->data) {
+        g_variant_unref(call->data);
+    }
+    if (call->destroy) {
+        call->destroy(call->user_data);
+    }
+    g_object_unref(call->obj);
+    gutil_slice_free(call);
+}
+
 static
 void
 nfc_tag_client_call_done(
@@ -420,21 +523,16 @@ nfc_tag_client_call_done(
     gpointer user_data)
 {
     NfcTagClientCall* call = user_data;
-    NfcTagClientObject* self = call->obj;
     GError* error = call->finish(ORG_SAILFISHOS_NFC_TAG(proxy), call, result);
 
     if (error) {
         g_error_free(error);
     }
-    if (call->cancel) {
-        g_signal_handler_disconnect(call->cancel, call->cancel_id);
-        g_object_unref(call->cancel);
-    }
-    if (call->destroy) {
-        call->destroy(call->user_data);
+    if (call->in_flight) {
+        /* Let the next one go */
+        nfc_scheduler_finish(call->obj->scheduler);
     }
-    g_object_unref(self);
-    gutil_slice_free(call);
+    nfc_tag_client_call_free(call);
 }
 
 static
@@ -475,6 +573,9 @@ nfc_tag_client_call_transceive_finish(
         result, &error)) {
         GWARN("%s: %s", self->name, GERRMSG(error));
     }
+    nfc_client_stats_finish(self->pub.path, NFC_CLIENT_OP_TRANSCEIVE,
+        call->start, error);
+    NFCDC_TRACE2(transceive__done, call, !error);
     if (call->callback) {
         NfcTagTransceiveFunc callback = (NfcTagTransceiveFunc) call->callback;
 
@@ -494,6 +595,97 @@ nfc_tag_client_call_transceive_finish(
     return error;
 }
 
+static
+void
+nfc_tag_client_call_transceive_failed(
+    NfcTagClientCall* call,
+    GError* error)
+{
+    NfcTagClientObject* self = call->obj;
+
+    GWARN("%s: %s", self->name, error->message);
+    if (call->callback) {
+        NfcTagTransceiveFunc callback = (NfcTagTransceiveFunc) call->callback;
+
+        call->callback = NULL;
+        callback(&self->pub, NULL, error, call->user_data);
+    }
+    g_error_free(error);
+}
+
+static
+gboolean
+nfc_tag_client_call_transceive_start(
+    gpointer user_data)
+{
+    NfcTagClientCall* call = user_data;
+    NfcTagClientObject* self = call->obj;
+
+    if (self->proxy) {
+        call->in_flight = TRUE;
+        call->start = nfc_client_stats_start();
+        NFCDC_TRACE3(transceive__start, call, self->pub.path,
+            g_variant_n_children(call->data));
+        org_sailfishos_nfc_tag_call_transceive(self->proxy, call->data,
+            call->cancel, nfc_tag_client_call_done, call);
+        return TRUE;
+    } else {
+        /* The tag is gone while the call was waiting for its turn */
+        nfc_tag_client_call_transceive_failed(call,
+            g_error_new_literal(NFCDC_ERROR, NFCDC_ERROR_ABORTED,
+                "Tag is gone"));
+        nfc_tag_client_call_free(call);
+        return FALSE;
+    }
+}
+
+static
+gboolean
+nfc_tag_client_call_transceive_deadline(
+    gpointer user_data)
+{
+    NfcTagClientCall* call = user_data;
+    NfcTagClientObject* self = call->obj;
+
+    call->deadline_id = 0;
+    nfc_tag_client_call_transceive_failed(call, nfc_deadline_error());
+    if (call->queue_id) {
+        /* It hasn't been submitted yet, there's nothing to abort */
+        nfc_scheduler_cancel(self->scheduler, call->queue_id);
+        nfc_tag_client_call_free(call);
+    } else {
+        /* Don't let the stuck tag hold up everything else */
+        nfc_tag_client_deactivate(&self->pub, NULL, NULL, NULL, NULL);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+nfc_tag_client_congestion_changed(
+    gpointer user_data)
+{
+    NfcTagClientObject* self = THIS(user_data);
+
+    self->pub.congested = nfc_scheduler_congested(self->scheduler);
+    nfc_tag_client_queue_signal(self, CONGESTED);
+    nfc_tag_client_emit_queued_signals(self);
+}
+
+static
+void
+nfc_tag_client_set_retrying(
+    NfcTagClientObject* self,
+    gboolean retrying)
+{
+    NfcTagClient* pub = &self->pub;
+
+    if (pub->retrying != retrying) {
+        pub->retrying = retrying;
+        nfc_tag_client_queue_signal(self, RETRYING);
+    }
+}
+
 static
 void
 nfc_tag_client_update_valid_and_present(
@@ -503,7 +695,9 @@ nfc_tag_client_update_valid_and_present(
     NfcAdapterClient* adapter = self->adapter;
     gboolean valid, present;
 
-    if (!adapter->valid || self->proxy_initializing) {
+    if (!adapter->valid || self->proxy_initializing ||
+        (self->proxy && (self->fetched & self->required) != self->required)) {
+        /* Not ready yet or still waiting for the properties */
         valid = FALSE;
         present = FALSE;
     } else {
@@ -519,6 +713,11 @@ nfc_tag_client_update_valid_and_present(
         pub->present = present;
         nfc_tag_client_queue_signal(self, PRESENT);
     }
+    if (self->proxy && !self->proxy_initializing) {
+        /* Successfully initialized */
+        nfc_client_retry_reset(&self->retry);
+        nfc_tag_client_set_retrying(self, FALSE);
+    }
 }
 
 static
@@ -533,6 +732,7 @@ nfc_tag_client_drop_proxy(
         g_object_unref(self->proxy);
         self->proxy = NULL;
     }
+    self->fetched = self->fetching = 0;
     if (pub->valid) {
         pub->valid = FALSE;
         nfc_tag_client_queue_signal(self, VALID);
@@ -567,11 +767,35 @@ nfc_tag_client_update(
             nfc_tag_client_reinit(self);
         }
     } else if (!self->proxy_initializing) {
+        nfc_client_retry_reset(&self->retry);
+        nfc_tag_client_set_retrying(self, FALSE);
         nfc_tag_client_drop_proxy(self);
     }
     nfc_tag_client_update_valid_and_present(self);
 }
 
+static
+void
+nfc_tag_client_retry(
+    GObject* object)
+{
+    NfcTagClientObject* self = THIS(object);
+
+    nfc_tag_client_update(self);
+    nfc_tag_client_emit_queued_signals(self);
+}
+
+static
+void
+nfc_tag_client_init_failed(
+    NfcTagClientObject* self)
+{
+    nfc_tag_client_drop_proxy(self);
+    nfc_tag_client_set_retrying(self,
+        nfc_client_retry_schedule(&self->retry, G_OBJECT(self),
+            nfc_tag_client_retry));
+}
+
 static
 void
 nfc_tag_client_adapter_changed(
@@ -587,13 +811,9 @@ nfc_tag_client_adapter_changed(
 
 static
 void
-nfc_tag_client_init_finished(
+nfc_tag_client_set_technology(
     NfcTagClientObject* self,
-    gboolean present,
-    NFC_TECH tech,
-    gchar** interfaces,
-    gchar** ndef_records,
-    GVariant* dict)
+    NFC_TECH tech)
 {
     NfcTagClient* tag = &self->pub;
 
@@ -615,34 +835,362 @@ nfc_tag_client_init_finished(
     }
 #endif /* GUTIL_LOG_DEBUG */
 
-    if (tag->present != present) {
-        tag->present = present;
-        nfc_tag_client_queue_signal(self, PRESENT);
-    }
     if (tag->technology != tech) {
         tag->technology = tech;
         nfc_tag_client_queue_signal(self, TECHNOLOGY);
     }
+}
+
+static
+void
+nfc_tag_client_set_interfaces(
+    NfcTagClientObject* self,
+    gchar** interfaces)
+{
     if (gutil_strv_equal(self->interfaces, interfaces)) {
         g_strfreev(interfaces);
     } else {
         g_strfreev(self->interfaces);
-        tag->interfaces = self->interfaces = interfaces;
+        self->pub.interfaces = self->interfaces = interfaces;
         nfc_tag_client_queue_signal(self, INTERFACES);
     }
+}
+
+static
+void
+nfc_tag_client_set_ndef_records(
+    NfcTagClientObject* self,
+    gchar** ndef_records)
+{
     if (gutil_strv_equal(self->ndef_records, ndef_records)) {
         g_strfreev(ndef_records);
     } else {
         g_strfreev(self->ndef_records);
-        tag->ndef_records = self->ndef_records = ndef_records;
+        self->pub.ndef_records = self->ndef_records = ndef_records;
         nfc_tag_client_queue_signal(self, NDEF_RECORDS);
     }
+}
+
+static
+void
+nfc_tag_client_set_poll_params(
+    NfcTagClientObject* self,
+    GVariant* dict)
+{
+    GDEBUG("%s: Poll parameters", self->name);
+    self->poll_params = nfc_parse_dict(self->poll_params, dict,
+        nfc_tag_client_poll_param_key);
+    g_variant_unref(dict);
+    nfc_tag_client_queue_signal(self, POLL_PARAMS);
+}
+
+static
+void
+nfc_tag_client_init_finished(
+    NfcTagClientObject* self,
+    gboolean present,
+    NFC_TECH tech,
+    gchar** interfaces,
+    gchar** ndef_records,
+    GVariant* dict)
+{
+    NfcTagClient* tag = &self->pub;
+
+    if (tag->present != present) {
+        tag->present = present;
+        nfc_tag_client_queue_signal(self, PRESENT);
+    }
+    nfc_tag_client_set_technology(self, tech);
+    nfc_tag_client_set_interfaces(self, interfaces);
+    nfc_tag_client_set_ndef_records(self, ndef_records);
     if (dict) {
-        GDEBUG("%s: Poll parameters", self->name);
-        self->poll_params = nfc_parse_dict(self->poll_params, dict,
-            nfc_tag_client_poll_param_key);
+        nfc_tag_client_set_poll_params(self, dict);
+    }
+
+    /* Poll parameters are not available prior to version 3 */
+    self->fetched = TAG_GROUP_ALL;
+}
+
+static
+gboolean
+nfc_tag_client_fetch_done(
+    NfcTagClientObject* self,
+    GObject* proxy,
+    guint group,
+    gboolean ok,
+    GError* error)
+{
+    if (error) {
+        GERR("%s: %s", self->name, GERRMSG(error));
+        g_error_free(error);
+    }
+
+    /* Whatever comes from the old proxy is ignored */
+    if (self->proxy && proxy == G_OBJECT(self->proxy)) {
+        self->fetching &= ~group;
+        if (ok) {
+            self->fetched |= group;
+            nfc_tag_client_update_valid_and_present(self);
+            return TRUE;
+        } else if (self->required & group) {
+            /* The client can't become valid without it, start over */
+            nfc_tag_client_init_failed(self);
+        } else {
+            /* Will be fetched again when it's needed next time */
+            self->wanted &= ~group;
+        }
+    }
+    return FALSE;
+}
+
+static
+void
+nfc_tag_client_fetch_free(
+    NfcTagClientFetch* fetch)
+{
+    GASSERT(!fetch->queue_id);
+    g_object_unref(fetch->proxy);
+    g_object_unref(fetch->obj);
+    gutil_slice_free(fetch);
+}
+
+static
+void
+nfc_tag_client_fetch_call_done(
+    NfcTagClientFetch* fetch)
+{
+    GASSERT(fetch->pending > 0);
+    if (!--fetch->pending) {
+        /* Let the next one go */
+        nfc_scheduler_finish(fetch->obj->scheduler);
+        nfc_tag_client_fetch_free(fetch);
+    }
+}
+
+static
+void
+nfc_tag_client_interfaces_fetched(
+    GObject* proxy,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    NfcTagClientFetch* fetch = user_data;
+    NfcTagClientObject* self = fetch->obj;
+    GError* error = NULL;
+    gchar** interfaces = NULL;
+    const gboolean ok = org_sailfishos_nfc_tag_call_get_interfaces_finish
+        (ORG_SAILFISHOS_NFC_TAG(proxy), &interfaces, result, &error);
+
+    if (nfc_tag_client_fetch_done(self, proxy, TAG_GROUP_INTERFACES, ok,
+        error)) {
+        nfc_tag_client_set_interfaces(self, interfaces);
+    } else {
+        g_strfreev(interfaces);
+    }
+    nfc_tag_client_emit_queued_signals(self);
+    nfc_tag_client_fetch_call_done(fetch);
+}
+
+static
+void
+nfc_tag_client_ndef_records_fetched(
+    GObject* proxy,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    NfcTagClientFetch* fetch = user_data;
+    NfcTagClientObject* self = fetch->obj;
+    GError* error = NULL;
+    gchar** ndef_records = NULL;
+    const gboolean ok = org_sailfishos_nfc_tag_call_get_ndef_records_finish
+        (ORG_SAILFISHOS_NFC_TAG(proxy), &ndef_records, result, &error);
+
+    if (nfc_tag_client_fetch_done(self, proxy, TAG_GROUP_NDEF_RECORDS, ok,
+        error)) {
+        nfc_tag_client_set_ndef_records(self, ndef_records);
+    } else {
+        g_strfreev(ndef_records);
+    }
+    nfc_tag_client_emit_queued_signals(self);
+    nfc_tag_client_fetch_call_done(fetch);
+}
+
+static
+void
+nfc_tag_client_technology_fetched(
+    GObject* proxy,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    NfcTagClientFetch* fetch = user_data;
+    NfcTagClientObject* self = fetch->obj;
+    GError* error = NULL;
+    guint tech = NFC_TECH_NONE;
+    const gboolean ok = org_sailfishos_nfc_tag_call_get_technology_finish
+        (ORG_SAILFISHOS_NFC_TAG(proxy), &tech, result, &error);
+
+    if (nfc_tag_client_fetch_done(self, proxy, TAG_GROUP_TECHNOLOGY, ok,
+        error)) {
+        nfc_tag_client_set_technology(self, tech);
+    }
+    nfc_tag_client_emit_queued_signals(self);
+    nfc_tag_client_fetch_call_done(fetch);
+}
+
+static
+void
+nfc_tag_client_poll_params_fetched(
+    GObject* proxy,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    NfcTagClientFetch* fetch = user_data;
+    NfcTagClientObject* self = fetch->obj;
+    GError* error = NULL;
+    GVariant* dict = NULL;
+    const gboolean ok = org_sailfishos_nfc_tag_call_get_poll_parameters_finish
+        (ORG_SAILFISHOS_NFC_TAG(proxy), &dict, result, &error);
+
+    if (nfc_tag_client_fetch_done(self, proxy, TAG_GROUP_POLL_PARAMS, ok,
+        error)) {
+        nfc_tag_client_set_poll_params(self, dict);
+    } else if (dict) {
         g_variant_unref(dict);
     }
+    nfc_tag_client_emit_queued_signals(self);
+    nfc_tag_client_fetch_call_done(fetch);
+}
+
+static
+gboolean
+nfc_tag_client_fetch_start(
+    gpointer user_data)
+{
+    NfcTagClientFetch* fetch = user_data;
+    NfcTagClientObject* self = fetch->obj;
+
+    if (self->proxy == fetch->proxy) {
+        OrgSailfishosNfcTag* proxy = fetch->proxy;
+        const guint groups = fetch->groups;
+
+        GDEBUG("%s: Fetching 0x%02x", self->name, groups);
+        if (groups & TAG_GROUP_INTERFACES) {
+            fetch->pending++;
+            org_sailfishos_nfc_tag_call_get_interfaces(proxy, NULL,
+                nfc_tag_client_interfaces_fetched, fetch);
+        }
+        if (groups & TAG_GROUP_NDEF_RECORDS) {
+            fetch->pending++;
+            org_sailfishos_nfc_tag_call_get_ndef_records(proxy, NULL,
+                nfc_tag_client_ndef_records_fetched, fetch);
+        }
+        if (groups & TAG_GROUP_TECHNOLOGY) {
+            fetch->pending++;
+            org_sailfishos_nfc_tag_call_get_technology(proxy, NULL,
+                nfc_tag_client_technology_fetched, fetch);
+        }
+        if (groups & TAG_GROUP_POLL_PARAMS) {
+            fetch->pending++;
+            org_sailfishos_nfc_tag_call_get_poll_parameters(proxy, NULL,
+                nfc_tag_client_poll_params_fetched, fetch);
+        }
+        return TRUE;
+    } else {
+        /* The proxy is gone while the fetch was waiting for its turn */
+        nfc_tag_client_fetch_free(fetch);
+        return FALSE;
+    }
+}
+
+static
+void
+nfc_tag_client_fetch(
+    NfcTagClientObject* self)
+{
+    guint missing = self->wanted & ~(self->fetched | self->fetching);
+
+    /* GetPollParameters appeared in org.sailfishos.nfc.Tag v3 */
+    if ((missing & TAG_GROUP_POLL_PARAMS) && self->version < 3 &&
+        self->proxy && !self->proxy_initializing) {
+        missing &= ~TAG_GROUP_POLL_PARAMS;
+        self->fetched |= TAG_GROUP_POLL_PARAMS;
+    }
+    if (missing && self->proxy && !self->proxy_initializing) {
+        NfcTagClientFetch* fetch = g_slice_new0(NfcTagClientFetch);
+
+        g_object_ref(fetch->obj = self);
+        g_object_ref(fetch->proxy = self->proxy);
+        fetch->groups = missing;
+        self->fetching |= missing;
+        nfc_scheduler_submit(self->scheduler, NFC_CALL_PRIORITY_BACKGROUND,
+            nfc_tag_client_fetch_start, fetch, &fetch->queue_id);
+    }
+}
+
+static
+void
+nfc_tag_client_want(
+    NfcTagClientObject* self,
+    guint groups)
+{
+    if ((self->wanted & groups) != groups) {
+        self->wanted |= groups;
+        nfc_tag_client_fetch(self);
+    }
+}
+
+static
+guint
+nfc_tag_client_property_groups(
+    NFC_TAG_PROPERTY property)
+{
+    switch (property) {
+    case NFC_TAG_PROPERTY_ANY:
+        return TAG_GROUP_ALL;
+    case NFC_TAG_PROPERTY_INTERFACES:
+        return TAG_GROUP_INTERFACES;
+    case NFC_TAG_PROPERTY_NDEF_RECORDS:
+        return TAG_GROUP_NDEF_RECORDS;
+    case NFC_TAG_PROPERTY_TECHNOLOGY:
+        return TAG_GROUP_TECHNOLOGY;
+    case NFC_TAG_PROPERTY_POLL_PARAMS:
+        return TAG_GROUP_POLL_PARAMS;
+    case NFC_TAG_PROPERTY_VALID:
+    case NFC_TAG_PROPERTY_PRESENT:
+    case NFC_TAG_PROPERTY_CONGESTED:
+    case NFC_TAG_PROPERTY_RETRYING:
+    case NFC_TAG_PROPERTY_COUNT:
+        break;
+    }
+    return TAG_GROUP_NONE;
+}
+
+static
+void
+nfc_tag_client_init_lite(
+    GObject* proxy,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    NfcTagClientObject* self = THIS(user_data);
+    GError* error = NULL;
+
+    GASSERT(self->proxy_initializing);
+    nfc_tag_client_init_done(self);
+    if (org_sailfishos_nfc_tag_call_get_interface_version_finish(self->proxy,
+        &self->version, result, &error)) {
+        GDEBUG("%s: Lite mode, version %d", self->name, self->version);
+        nfc_tag_client_fetch(self);
+        nfc_tag_client_update_valid_and_present(self);
+    } else {
+        GERR("%s", GERRMSG(error));
+        g_error_free(error);
+        nfc_tag_client_init_failed(self);
+    }
+    nfc_tag_client_emit_queued_signals(self);
+    /* Let the next one go */
+    nfc_scheduler_finish(self->scheduler);
+    g_object_unref(self);
 }
 
 static
@@ -654,6 +1202,7 @@ nfc_tag_client_init_5(
 {
     NfcTagClientObject* self = THIS(user_data);
     GError* error = NULL;
+    gboolean ok;
     gboolean present;
     guint tech;
     gchar** interfaces;
@@ -661,19 +1210,25 @@ nfc_tag_client_init_5(
     GVariant* dict;
 
     GASSERT(self->proxy_initializing);
-    self->proxy_initializing = FALSE;
-    if (org_sailfishos_nfc_tag_call_get_all3_finish(self->proxy,
+    nfc_tag_client_init_done(self);
+    ok = org_sailfishos_nfc_tag_call_get_all3_finish(self->proxy,
         NULL, &present, &tech, NULL, NULL, &interfaces,
-        &ndef_records, &dict, result, &error)) {
+        &ndef_records, &dict, result, &error);
+    nfc_client_stats_finish(self->pub.path, NFC_CLIENT_OP_TAG_GET_ALL3,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, self->pub.path, NFC_CLIENT_OP_TAG_GET_ALL3, ok);
+    if (ok) {
         nfc_tag_client_init_finished(self, present, tech, interfaces,
             ndef_records, dict);
         nfc_tag_client_update_valid_and_present(self);
     } else {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
-        nfc_tag_client_drop_proxy(self);
+        nfc_tag_client_init_failed(self);
     }
     nfc_tag_client_emit_queued_signals(self);
+    /* Let the next one go */
+    nfc_scheduler_finish(self->scheduler);
     g_object_unref(self);
 }
 
@@ -686,34 +1241,67 @@ nfc_tag_client_init_4(
 {
     NfcTagClientObject* self = THIS(user_data);
     GError* error = NULL;
+    gboolean ok;
     gboolean present;
     guint tech;
     gchar** interfaces;
     gchar** ndef_records;
 
     GASSERT(self->proxy_initializing);
-    if (!org_sailfishos_nfc_tag_call_get_all_finish(self->proxy,
+    ok = org_sailfishos_nfc_tag_call_get_all_finish(self->proxy,
         &self->version, &present, &tech, NULL, NULL, &interfaces,
-        &ndef_records, result, &error)) {
+        &ndef_records, result, &error);
+    nfc_client_stats_finish(self->pub.path, NFC_CLIENT_OP_TAG_GET_ALL,
+        self->get_all_start, error);
+    NFCDC_TRACE3(init__done, self->pub.path, NFC_CLIENT_OP_TAG_GET_ALL, ok);
+    if (!ok) {
         GERR("%s", GERRMSG(error));
-        self->proxy_initializing = FALSE;
+        nfc_tag_client_init_done(self);
         g_error_free(error);
-        nfc_tag_client_drop_proxy(self);
+        nfc_tag_client_init_failed(self);
+        nfc_tag_client_emit_queued_signals(self);
+        nfc_scheduler_finish(self->scheduler);
     } else if (self->version >= 3) {
+        /* The slot is still taken */
         g_strfreev(interfaces);
         g_strfreev(ndef_records);
+        self->get_all_start = nfc_client_stats_start();
+        NFCDC_TRACE2(init__start, self->pub.path, NFC_CLIENT_OP_TAG_GET_ALL3);
         org_sailfishos_nfc_tag_call_get_all3(self->proxy, NULL,
             nfc_tag_client_init_5, g_object_ref(self));
     } else {
-        self->proxy_initializing = FALSE;
+        nfc_tag_client_init_done(self);
         nfc_tag_client_init_finished(self, present, tech, interfaces,
             ndef_records, NULL);
         nfc_tag_client_update_valid_and_present(self);
         nfc_tag_client_emit_queued_signals(self);
+        nfc_scheduler_finish(self->scheduler);
     }
     g_object_unref(self);
 }
 
+static
+gboolean
+nfc_tag_client_init_query(
+    gpointer user_data)
+{
+    NfcTagClientObject* self = THIS(user_data);
+
+    GASSERT(self->proxy);
+    GASSERT(self->proxy_initializing);
+    if (self->wanted != TAG_GROUP_ALL) {
+        /* Everything else will be fetched on demand */
+        org_sailfishos_nfc_tag_call_get_interface_version(self->proxy, NULL,
+            nfc_tag_client_init_lite, self);
+    } else {
+        self->get_all_start = nfc_client_stats_start();
+        NFCDC_TRACE2(init__start, self->pub.path, NFC_CLIENT_OP_TAG_GET_ALL);
+        org_sailfishos_nfc_tag_call_get_all(self->proxy, NULL,
+            nfc_tag_client_init_4, self);
+    }
+    return TRUE;
+}
+
 static
 void
 nfc_tag_client_init_3(
@@ -728,12 +1316,14 @@ nfc_tag_client_init_3(
     GASSERT(self->proxy_initializing);
     self->proxy = org_sailfishos_nfc_tag_proxy_new_finish(result, &error);
     if (self->proxy) {
-        org_sailfishos_nfc_tag_call_get_all(self->proxy, NULL,
-            nfc_tag_client_init_4, g_object_ref(self));
+        /* The reference is released by the completion callback */
+        nfc_scheduler_submit(self->scheduler, NFC_CALL_PRIORITY_BACKGROUND,
+            nfc_tag_client_init_query, g_object_ref(self), NULL);
     } else {
         GERR("%s", GERRMSG(error));
         g_error_free(error);
-        self->proxy_initializing = FALSE;
+        nfc_tag_client_init_done(self);
+        nfc_tag_client_init_failed(self);
         nfc_tag_client_update_valid_and_present(self);
         nfc_tag_client_emit_queued_signals(self);
     }
@@ -768,13 +1358,21 @@ nfc_tag_client_init_1(
     } else {
         GERR("Failed to attach to NFC daemon bus: %s", GERRMSG(error));
         g_error_free(error);
-        self->proxy_initializing = FALSE;
+        nfc_tag_client_init_done(self);
         nfc_tag_client_update_valid_and_present(self);
         nfc_tag_client_emit_queued_signals(self);
     }
     g_object_unref(self);
 }
 
+static
+void
+nfc_tag_client_resync(
+    GObject* object)
+{
+    nfc_tag_client_init_2(THIS(object));
+}
+
 static
 void
 nfc_tag_client_reinit(
@@ -782,29 +1380,14 @@ nfc_tag_client_reinit(
 {
     GASSERT(!self->proxy_initializing);
     self->proxy_initializing = TRUE;
-    nfc_tag_client_init_2(self);
+    nfc_resync_submit(&self->resync, G_OBJECT(self), nfc_tag_client_resync);
 }
 
-/*==========================================================================*
- * Internal API
- *==========================================================================*/
-
-GDBusConnection*
-nfc_tag_client_connection(
-    NfcTagClient* tag)
-{
-    NfcTagClientObject* self = nfc_tag_client_object_cast(tag);
-
-    return G_LIKELY(self) ? self->connection : NULL;
-}
-
-/*==========================================================================*
- * API
- *==========================================================================*/
-
+static
 NfcTagClient*
-nfc_tag_client_new(
-    const char* path)
+nfc_tag_client_create(
+    const char* path,
+    guint wanted)
 {
     if (G_LIKELY(path) && g_variant_is_object_path(path)) {
         const char* sep = strrchr(path, '/');
@@ -817,11 +1400,22 @@ nfc_tag_client_new(
             }
             if (obj) {
                 g_object_ref(obj);
+                if ((obj->required & wanted) != wanted) {
+                    /*
+                     * Lite client is turning into a normal one. It stays
+                     * invalid until all the properties have arrived.
+                     */
+                    obj->required |= wanted;
+                    nfc_tag_client_want(obj, wanted);
+                    nfc_tag_client_update_valid_and_present(obj);
+                    nfc_tag_client_emit_queued_signals(obj);
+                }
             } else {
                 char* key = g_strdup(path);
 
                 GVERBOSE_("%s", path);
                 obj = g_object_new(THIS_TYPE, NULL);
+                obj->wanted = obj->required = wanted;
                 if (!nfc_tag_client_table) {
                     nfc_tag_client_table = g_hash_table_new_full(g_str_hash,
                         g_str_equal, g_free, NULL);
@@ -856,6 +1450,63 @@ nfc_tag_client_new(
     return NULL;
 }
 
+/*==========================================================================*
+ * Internal API
+ *==========================================================================*/
+
+GDBusConnection*
+nfc_tag_client_connection(
+    NfcTagClient* tag)
+{
+    NfcTagClientObject* self = nfc_tag_client_object_cast(tag);
+
+    return G_LIKELY(self) ? self->connection : NULL;
+}
+
+NfcScheduler*
+nfc_tag_client_scheduler(
+    NfcTagClient* tag)
+{
+    NfcTagClientObject* self = nfc_tag_client_object_cast(tag);
+
+    return G_LIKELY(self) ? self->scheduler : NULL;
+}
+
+guint
+nfc_tag_client_lock_id(
+    NfcTagClient* tag)
+{
+    NfcTagClientObject* self = nfc_tag_client_object_cast(tag);
+
+    return (G_LIKELY(self) && self->lock) ? self->lock->id : 0;
+}
+
+guint
+nfc_tag_client_count(
+    void)
+{
+    return nfc_tag_client_table ?
+        g_hash_table_size(nfc_tag_client_table) : 0;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+NfcTagClient*
+nfc_tag_client_new(
+    const char* path)
+{
+    return nfc_tag_client_create(path, TAG_GROUP_ALL);
+}
+
+NfcTagClient*
+nfc_tag_client_new_lite(
+    const char* path) /* Since 1.3.0 */
+{
+    return nfc_tag_client_create(path, TAG_GROUP_NONE);
+}
+
 NfcTagClient*
 nfc_tag_client_ref(
     NfcTagClient* tag)
@@ -886,10 +1537,25 @@ nfc_tag_client_acquire_lock(
     NfcTagClientLockFunc callback,
     void* user_data,
     GDestroyNotify destroy)
+{
+    return nfc_tag_client_acquire_lock_with_deadline(tag, wait, 0, cancel,
+        callback, user_data, destroy);
+}
+
+gboolean
+nfc_tag_client_acquire_lock_with_deadline(
+    NfcTagClient* tag,
+    gboolean wait,
+    gint64 deadline,
+    GCancellable* cancel,
+    NfcTagClientLockFunc callback,
+    void* user_data,
+    GDestroyNotify destroy) /* Since 1.3.0 */
 {
     NfcTagClientObject* self = nfc_tag_client_object_cast(tag);
 
     if (self && tag->valid && tag->present && (callback || destroy) &&
+        !nfc_deadline_expired(deadline) &&
         (!cancel || !g_cancellable_is_cancelled(cancel))) {
         if (self->lock) {
             NfcTagClientLockDataIdle* idle =
@@ -913,6 +1579,9 @@ nfc_tag_client_acquire_lock(
              * cancelled (by not passing GCacellable through), to maintain
              * the lock reference count.
              */
+            call->start = nfc_client_stats_start();
+            call->deadline_id = nfc_deadline_timeout_add(deadline,
+                nfc_tag_client_lock_deadline, call);
             org_sailfishos_nfc_tag_call_acquire(self->proxy, wait, NULL,
                 nfc_tag_client_lock_acquire_done, call);
         }
@@ -933,9 +1602,15 @@ nfc_tag_client_poll_param(
 {
     NfcTagClientObject* self = nfc_tag_client_object_cast(tag);
 
-    return (self && self->poll_params) ?
-        g_hash_table_lookup(self->poll_params, GINT_TO_POINTER(param)) :
-        NULL;
+    if (G_LIKELY(self)) {
+        /* Lite client fetches those on the first request */
+        nfc_tag_client_want(self, TAG_GROUP_POLL_PARAMS);
+        if (self->poll_params) {
+            return g_hash_table_lookup(self->poll_params,
+                GINT_TO_POINTER(param));
+        }
+    }
+    return NULL;
 }
 
 gboolean
@@ -978,24 +1653,52 @@ nfc_tag_client_transceive(
     NfcTagTransceiveFunc callback,
     void* user_data,
     GDestroyNotify destroy) /* Since 1.2.1 */
+{
+    return nfc_tag_client_transceive_with_deadline(tag, data, 0, cancel,
+        callback, user_data, destroy);
+}
+
+gboolean
+nfc_tag_client_transceive_with_deadline(
+    NfcTagClient* tag,
+    const GUtilData* data,
+    gint64 deadline,
+    GCancellable* cancel,
+    NfcTagTransceiveFunc callback,
+    void* user_data,
+    GDestroyNotify destroy) /* Since 1.3.0 */
+{
+    return nfc_tag_client_transceive_with_priority(tag, data,
+        NFC_CALL_PRIORITY_DEFAULT, deadline, cancel, callback, user_data,
+        destroy);
+}
+
+gboolean
+nfc_tag_client_transceive_with_priority(
+    NfcTagClient* tag,
+    const GUtilData* data,
+    NFC_CALL_PRIORITY priority,
+    gint64 deadline,
+    GCancellable* cancel,
+    NfcTagTransceiveFunc callback,
+    void* user_data,
+    GDestroyNotify destroy) /* Since 1.3.0 */
 {
     NfcTagClientObject* self = nfc_tag_client_object_cast(tag);
 
     /* Transceive appeared in org.sailfishos.nfc.Tag v4 */
     if (self && tag->valid && tag->present && self->version >= 4 &&
+       !nfc_deadline_expired(deadline) &&
        (!cancel || !g_cancellable_is_cancelled(cancel))) {
-        GVariant* var = gutil_data_copy_as_variant(data);
-
-        if (callback || destroy) {
-            org_sailfishos_nfc_tag_call_transceive(self->proxy, var, cancel,
-                nfc_tag_client_call_done, nfc_tag_client_call_new(self,
-                    nfc_tag_client_call_transceive_finish, cancel,
-                    G_CALLBACK(callback), user_data, destroy));
-        } else {
-            /* No need to allocate the context */
-            org_sailfishos_nfc_tag_call_transceive(self->proxy, var,
-                NULL, NULL, NULL);
-        }
+        NfcTagClientCall* call = nfc_tag_client_call_new(self,
+            nfc_tag_client_call_transceive_finish, cancel,
+            G_CALLBACK(callback), user_data, destroy);
+
+        call->data = g_variant_ref_sink(gutil_data_copy_as_variant(data));
+        call->deadline_id = nfc_deadline_timeout_add(deadline,
+            nfc_tag_client_call_transceive_deadline, call);
+        nfc_scheduler_submit(self->scheduler, priority,
+            nfc_tag_client_call_transceive_start, call, &call->queue_id);
         return TRUE;
     } else {
         /* Destroy callback is always invoked even if we return FALSE */
@@ -1015,8 +1718,18 @@ nfc_tag_client_add_property_handler(
 {
     NfcTagClientObject* self = nfc_tag_client_object_cast(tag);
 
-    return G_LIKELY(self) ? nfc_client_base_add_property_handler(&self->base,
-        property, (NfcClientBasePropertyFunc) callback, user_data) : 0;
+    if (G_LIKELY(self)) {
+        const gulong id = nfc_client_base_add_property_handler(&self->base,
+            property, (NfcClientBasePropertyFunc) callback, user_data);
+
+        if (id) {
+            /* Lite client starts fetching the property when it's needed */
+            nfc_tag_client_want(self, nfc_tag_client_property_groups
+                (property));
+        }
+        return id;
+    }
+    return 0;
 }
 
 void
@@ -1056,6 +1769,8 @@ nfc_tag_client_object_init(
     pub->interfaces = &nfc_tag_client_empty_strv;
     pub->ndef_records = &nfc_tag_client_empty_strv;
     self->proxy_initializing = TRUE;
+    self->scheduler = nfc_scheduler_new(nfc_tag_client_congestion_changed,
+        self);
 }
 
 static
@@ -1068,6 +1783,7 @@ nfc_tag_client_object_finalize(
 
     GVERBOSE_("%s", pub->path);
     GASSERT(!self->lock); /* Lock holds a reference to the tag */
+    nfc_client_retry_reset(&self->retry);
     nfc_tag_client_drop_proxy(self);
     nfc_adapter_client_remove_all_handlers(self->adapter,
         self->adapter_event_id);
@@ -1078,6 +1794,7 @@ nfc_tag_client_object_finalize(
     }
     g_strfreev(self->interfaces);
     g_strfreev(self->ndef_records);
+    nfc_scheduler_free(self->scheduler);
     g_hash_table_remove(nfc_tag_client_table, pub->path);
     if (g_hash_table_size(nfc_tag_client_table) == 0) {
         g_hash_table_unref(nfc_tag_client_table);
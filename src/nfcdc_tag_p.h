@@ -39,12 +39,31 @@
 #define NFCDC_TAG_PRIVATE_H
 
 #include "nfcdc_tag.h"
+#include "nfcdc_scheduler_p.h"
 
 GDBusConnection*
 nfc_tag_client_connection(
     NfcTagClient* tag)
     G_GNUC_INTERNAL;
 
+/* Shared with the ISO-DEP client */
+NfcScheduler*
+nfc_tag_client_scheduler(
+    NfcTagClient* tag)
+    G_GNUC_INTERNAL;
+
+/* Identifies the lock held by this process, zero if there's none */
+guint
+nfc_tag_client_lock_id(
+    NfcTagClient* tag)
+    G_GNUC_INTERNAL;
+
+/* Size of the object table, for nfc_client_stats_live_objects() */
+guint
+nfc_tag_client_count(
+    void)
+    G_GNUC_INTERNAL;
+
 #endif /* NFCDC_TAG_PRIVATE_H */
 
 /*
@@ -0,0 +1,971 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#include "nfcdc_base.h"
+#include "nfcdc_dbus.h"
+#include "nfcdc_log.h"
+#include "nfcdc_target_monitor.h"
+#include "nfcdc_util_p.h"
+
+#include <gutil_macros.h>
+#include <gutil_misc.h>
+#include <gutil_strv.h>
+
+#define NFCD_DAEMON_INTERFACE  "org.sailfishos.nfc.Daemon"
+#define NFCD_ADAPTER_INTERFACE "org.sailfishos.nfc.Adapter"
+#define NFCD_TAG_INTERFACE     "org.sailfishos.nfc.Tag"
+
+enum nfc_target_monitor_subscriptions {
+    SUBSCRIPTION_ADAPTERS_CHANGED,
+    SUBSCRIPTION_TAGS_CHANGED,
+    SUBSCRIPTION_PEERS_CHANGED,
+    SUBSCRIPTION_COUNT
+};
+
+enum nfc_target_monitor_signal {
+    SIGNAL_EVENT,
+    SIGNAL_TAG_IDENTIFIED,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_EVENT_NAME          "nfcdc-target-monitor-event"
+#define SIGNAL_TAG_IDENTIFIED_NAME "nfcdc-target-monitor-tag-identified"
+
+typedef struct nfc_target_monitor_adapter {
+    char* path;
+    GStrV* tags;
+    GStrV* peers;
+    gboolean tags_known;
+    gboolean peers_known;
+} NfcTargetMonitorAdapter;
+
+typedef NfcClientBaseClass NfcTargetMonitorObjectClass;
+typedef struct nfc_target_monitor_object {
+    NfcClientBase base;
+    NfcTargetMonitor pub;
+    GDBusConnection* connection;
+    GCancellable* cancel;
+    GHashTable* adapters;
+    guint subscription_id[SUBSCRIPTION_COUNT];
+    guint watch_id;
+    guint pending;
+} NfcTargetMonitorObject;
+
+typedef struct nfc_target_monitor_query {
+    NfcTargetMonitorObject* self;
+    char* path;
+    gboolean tags;
+} NfcTargetMonitorQuery;
+
+typedef struct nfc_target_monitor_identify {
+    NfcTargetMonitorObject* self;
+    char* adapter;
+    char* path;
+    gint64 time;
+    NFC_TECH technology;
+    GUtilData* uid;
+    int pending;
+} NfcTargetMonitorIdentify;
+
+typedef struct nfc_target_monitor_closure {
+    GCClosure cclosure;
+    NfcTargetMonitorEventFunc callback;
+    void* user_data;
+} NfcTargetMonitorClosure;
+
+#define nfc_target_monitor_closure_new() ((NfcTargetMonitorClosure *) \
+    g_closure_new_simple(sizeof(NfcTargetMonitorClosure), NULL))
+
+#define PARENT_CLASS nfc_target_monitor_object_parent_class
+#define THIS_TYPE nfc_target_monitor_object_get_type()
+#define THIS(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, THIS_TYPE, \
+    NfcTargetMonitorObject)
+
+GType THIS_TYPE G_GNUC_INTERNAL;
+G_DEFINE_TYPE(NfcTargetMonitorObject, nfc_target_monitor_object, \
+    NFC_CLIENT_TYPE_BASE)
+
+NFC_CLIENT_BASE_ASSERT_VALID(NFC_TARGET_MONITOR_PROPERTY_VALID);
+NFC_CLIENT_BASE_ASSERT_COUNT(NFC_TARGET_MONITOR_PROPERTY_COUNT);
+
+static guint nfc_target_monitor_signals[SIGNAL_COUNT];
+static NfcTargetMonitorObject* nfc_target_monitor_instance = NULL;
+
+/*==========================================================================*
+ * Implementation
+ *==========================================================================*/
+
+static inline
+NfcTargetMonitorObject*
+nfc_target_monitor_object_cast(
+    NfcTargetMonitor* pub)
+{
+    return G_LIKELY(pub) ?
+        THIS(G_CAST(pub, NfcTargetMonitorObject, pub)) :
+        NULL;
+}
+
+static
+void
+nfc_target_monitor_event(
+    NfcTargetMonitorObject* self,
+    const NfcTargetEvent* event,
+    NfcTargetMonitorClosure* closure)
+{
+    closure->callback(&self->pub, event, closure->user_data);
+}
+
+static
+void
+nfc_target_monitor_adapter_free(
+    gpointer data)
+{
+    NfcTargetMonitorAdapter* adapter = data;
+
+    g_free(adapter->path);
+    g_strfreev(adapter->tags);
+    g_strfreev(adapter->peers);
+    gutil_slice_free(adapter);
+}
+
+static
+NfcTargetMonitorAdapter*
+nfc_target_monitor_adapter(
+    NfcTargetMonitorObject* self,
+    const char* path)
+{
+    NfcTargetMonitorAdapter* adapter = g_hash_table_lookup(self->adapters,
+        path);
+
+    if (!adapter) {
+        adapter = g_slice_new0(NfcTargetMonitorAdapter);
+        adapter->path = g_strdup(path);
+        g_hash_table_insert(self->adapters, adapter->path, adapter);
+    }
+    return adapter;
+}
+
+static
+void
+nfc_target_monitor_identify_unref(
+    NfcTargetMonitorIdentify* identify)
+{
+    if (!--identify->pending) {
+        NfcTargetMonitorObject* self = identify->self;
+        NfcTargetMonitorAdapter* adapter = g_hash_table_lookup(self->adapters,
+            identify->adapter);
+
+        /* Don't report the tag which is already gone */
+        if (adapter && gutil_strv_contains(adapter->tags, identify->path)) {
+            NfcTargetEvent event;
+
+            event.type = NFC_TARGET_TAG_IDENTIFIED;
+            event.adapter = adapter->path;
+            event.path = identify->path;
+            event.time = identify->time;
+            event.technology = identify->technology;
+            event.uid = identify->uid;
+            GDEBUG("%s identified in %d ms", identify->path, (int)
+                ((g_get_monotonic_time() - identify->time) / 1000));
+            g_signal_emit(self, nfc_target_monitor_signals
+                [SIGNAL_TAG_IDENTIFIED], 0, &event);
+        }
+        g_free(identify->adapter);
+        g_free(identify->path);
+        g_free(identify->uid);
+        g_object_unref(self);
+        gutil_slice_free(identify);
+    }
+}
+
+static
+void
+nfc_target_monitor_technology_done(
+    GObject* connection,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    NfcTargetMonitorIdentify* identify = user_data;
+    GError* error = NULL;
+    GVariant* ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION
+        (connection), result, &error);
+
+    if (ret) {
+        guint tech;
+
+        g_variant_get(ret, "(u)", &tech);
+        identify->technology = tech;
+        g_variant_unref(ret);
+    } else {
+        GDEBUG("%s: %s", identify->path, GERRMSG(error));
+        g_error_free(error);
+    }
+    nfc_target_monitor_identify_unref(identify);
+}
+
+static
+void
+nfc_target_monitor_poll_params_done(
+    GObject* connection,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    NfcTargetMonitorIdentify* identify = user_data;
+    GError* error = NULL;
+    GVariant* ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION
+        (connection), result, &error);
+
+    if (ret) {
+        GVariant* dict = g_variant_get_child_value(ret, 0);
+        GVariant* uid = g_variant_lookup_value(dict, "NFCID1",
+            G_VARIANT_TYPE_BYTESTRING);
+
+        if (!uid) {
+            uid = g_variant_lookup_value(dict, "NFCID0",
+                G_VARIANT_TYPE_BYTESTRING);
+        }
+        if (uid) {
+            identify->uid = nfc_data_from_variant(uid);
+            g_variant_unref(uid);
+        }
+        g_variant_unref(dict);
+        g_variant_unref(ret);
+    } else {
+        /* GetPollParameters is missing from older tag interfaces */
+        GDEBUG("%s: %s", identify->path, GERRMSG(error));
+        g_error_free(error);
+    }
+    nfc_target_monitor_identify_unref(identify);
+}
+
+static
+void
+nfc_target_monitor_identify(
+    NfcTargetMonitorObject* self,
+    const char* adapter,
+    const char* path,
+    gint64 time)
+{
+    NfcTargetMonitorIdentify* identify =
+        g_slice_new0(NfcTargetMonitorIdentify);
+
+    /*
+     * These two are the smallest calls carrying the UID and the
+     * technology. Both go out together and complete within the same
+     * round trip.
+     */
+    g_object_ref(identify->self = self);
+    identify->adapter = g_strdup(adapter);
+    identify->path = g_strdup(path);
+    identify->time = time;
+    identify->pending = 2;
+    g_dbus_connection_call(self->connection, NFCD_DBUS_DAEMON_NAME, path,
+        NFCD_TAG_INTERFACE, "GetPollParameters", NULL,
+        G_VARIANT_TYPE("(a{sv})"), G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+        nfc_target_monitor_poll_params_done, identify);
+    g_dbus_connection_call(self->connection, NFCD_DBUS_DAEMON_NAME, path,
+        NFCD_TAG_INTERFACE, "GetTechnology", NULL,
+        G_VARIANT_TYPE("(u)"), G_DBUS_CALL_FLAGS_NONE, -1, NULL,
+        nfc_target_monitor_technology_done, identify);
+}
+
+static
+void
+nfc_target_monitor_identify_all(
+    NfcTargetMonitorObject* self,
+    NfcTargetMonitorAdapter* adapter)
+{
+    /* Tags which were already there when we started */
+    if (adapter->tags && g_signal_has_handler_pending(self,
+        nfc_target_monitor_signals[SIGNAL_TAG_IDENTIFIED], 0, FALSE)) {
+        const gint64 now = g_get_monotonic_time();
+        const GStrV* ptr;
+
+        for (ptr = adapter->tags; *ptr; ptr++) {
+            nfc_target_monitor_identify(self, adapter->path, *ptr, now);
+        }
+    }
+}
+
+static
+void
+nfc_target_monitor_emit(
+    NfcTargetMonitorObject* self,
+    NFC_TARGET_EVENT_TYPE type,
+    const char* adapter,
+    const char* path,
+    gint64 time)
+{
+    NfcTargetEvent event;
+
+    /* Ask for the UID first, the arrival handlers may take a while */
+    if (type == NFC_TARGET_TAG_ARRIVED && g_signal_has_handler_pending(self,
+        nfc_target_monitor_signals[SIGNAL_TAG_IDENTIFIED], 0, FALSE)) {
+        nfc_target_monitor_identify(self, adapter, path, time);
+    }
+    event.type = type;
+    event.adapter = adapter;
+    event.path = path;
+    event.time = time;
+    event.technology = NFC_TECH_NONE;
+    event.uid = NULL;
+    g_signal_emit(self, nfc_target_monitor_signals[SIGNAL_EVENT], 0, &event);
+}
+
+static
+void
+nfc_target_monitor_update(
+    NfcTargetMonitorObject* self,
+    const char* adapter,
+    GStrV** known,
+    const GStrV* present,
+    NFC_TARGET_EVENT_TYPE arrived,
+    NFC_TARGET_EVENT_TYPE left,
+    gint64 time)
+{
+    GStrV* prev = *known;
+    const GStrV* ptr;
+
+    /* Update the state first, handlers may want to look at it */
+    *known = (present && present[0]) ? g_strdupv((char**)present) : NULL;
+    for (ptr = prev; ptr && *ptr; ptr++) {
+        if (!gutil_strv_contains(*known, *ptr)) {
+            nfc_target_monitor_emit(self, left, adapter, *ptr, time);
+        }
+    }
+    for (ptr = *known; ptr && *ptr; ptr++) {
+        if (!gutil_strv_contains(prev, *ptr)) {
+            nfc_target_monitor_emit(self, arrived, adapter, *ptr, time);
+        }
+    }
+    g_strfreev(prev);
+}
+
+static
+void
+nfc_target_monitor_drop_adapter(
+    NfcTargetMonitorObject* self,
+    NfcTargetMonitorAdapter* adapter,
+    gint64 time)
+{
+    nfc_target_monitor_update(self, adapter->path, &adapter->tags, NULL,
+        NFC_TARGET_TAG_ARRIVED, NFC_TARGET_TAG_LEFT, time);
+    nfc_target_monitor_update(self, adapter->path, &adapter->peers, NULL,
+        NFC_TARGET_PEER_ARRIVED, NFC_TARGET_PEER_LEFT, time);
+    g_hash_table_remove(self->adapters, adapter->path);
+}
+
+static
+void
+nfc_target_monitor_drop_adapters(
+    NfcTargetMonitorObject* self,
+    const GStrV* keep,
+    gint64 time)
+{
+    GSList* drop = NULL;
+    GSList* l;
+    GHashTableIter it;
+    gpointer value;
+
+    g_hash_table_iter_init(&it, self->adapters);
+    while (g_hash_table_iter_next(&it, NULL, &value)) {
+        NfcTargetMonitorAdapter* adapter = value;
+
+        if (!gutil_strv_contains(keep, adapter->path)) {
+            drop = g_slist_append(drop, adapter);
+        }
+    }
+    for (l = drop; l; l = l->next) {
+        nfc_target_monitor_drop_adapter(self, l->data, time);
+    }
+    g_slist_free(drop);
+}
+
+static
+void
+nfc_target_monitor_set_valid(
+    NfcTargetMonitorObject* self,
+    gboolean valid)
+{
+    NfcTargetMonitor* pub = &self->pub;
+
+    if (pub->valid != valid) {
+        pub->valid = valid;
+        GDEBUG("Target monitor %svalid", valid ? "" : "in");
+        nfc_client_base_signal_property_change(&self->base,
+            NFC_TARGET_MONITOR_PROPERTY_VALID);
+    }
+}
+
+static
+void
+nfc_target_monitor_query_done(
+    GObject* connection,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    NfcTargetMonitorQuery* query = user_data;
+    GError* error = NULL;
+    GVariant* ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION
+        (connection), result, &error);
+
+    /* The monitor may be gone if the call has been cancelled */
+    if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        NfcTargetMonitorObject* self = query->self;
+        NfcTargetMonitorAdapter* adapter = g_hash_table_lookup(self->adapters,
+            query->path);
+
+        if (adapter) {
+            GStrV* list = NULL;
+
+            if (ret) {
+                g_variant_get(ret, "(^ao)", &list);
+            } else {
+                /* GetPeers is missing from older adapter interfaces */
+                GDEBUG("%s: %s", query->path, GERRMSG(error));
+            }
+
+            /* Signals (if any) carry newer information */
+            if (query->tags) {
+                if (!adapter->tags_known) {
+                    adapter->tags_known = TRUE;
+                    adapter->tags = list;
+                    list = NULL;
+                    nfc_target_monitor_identify_all(self, adapter);
+                }
+            } else if (!adapter->peers_known) {
+                adapter->peers_known = TRUE;
+                adapter->peers = list;
+                list = NULL;
+            }
+            g_strfreev(list);
+        }
+        GASSERT(self->pending);
+        if (!--self->pending) {
+            nfc_target_monitor_set_valid(self, TRUE);
+        }
+    }
+    if (ret) {
+        g_variant_unref(ret);
+    }
+    if (error) {
+        g_error_free(error);
+    }
+    g_free(query->path);
+    gutil_slice_free(query);
+}
+
+static
+void
+nfc_target_monitor_query(
+    NfcTargetMonitorObject* self,
+    const char* path,
+    gboolean tags)
+{
+    NfcTargetMonitorQuery* query = g_slice_new(NfcTargetMonitorQuery);
+
+    query->self = self;
+    query->path = g_strdup(path);
+    query->tags = tags;
+    self->pending++;
+    g_dbus_connection_call(self->connection, NFCD_DBUS_DAEMON_NAME, path,
+        NFCD_ADAPTER_INTERFACE, tags ? "GetTags" : "GetPeers", NULL,
+        G_VARIANT_TYPE("(ao)"), G_DBUS_CALL_FLAGS_NONE, -1, self->cancel,
+        nfc_target_monitor_query_done, query);
+}
+
+static
+void
+nfc_target_monitor_get_adapters_done(
+    GObject* connection,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    GError* error = NULL;
+    GVariant* ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION
+        (connection), result, &error);
+
+    if (ret) {
+        NfcTargetMonitorObject* self = THIS(user_data);
+        GStrV* list = NULL;
+        const GStrV* ptr;
+
+        g_variant_get(ret, "(^ao)", &list);
+        g_variant_unref(ret);
+        g_object_ref(self);
+        nfc_target_monitor_drop_adapters(self, list, g_get_monotonic_time());
+        for (ptr = list; ptr && *ptr; ptr++) {
+            nfc_target_monitor_adapter(self, *ptr);
+            nfc_target_monitor_query(self, *ptr, TRUE);
+            nfc_target_monitor_query(self, *ptr, FALSE);
+        }
+        g_strfreev(list);
+        GASSERT(self->pending);
+        if (!--self->pending) {
+            nfc_target_monitor_set_valid(self, TRUE);
+        }
+        g_object_unref(self);
+    } else if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        /* The monitor may be gone */
+        g_error_free(error);
+    } else {
+        NfcTargetMonitorObject* self = THIS(user_data);
+
+        /*
+         * Don't wait forever. Adapters (if any) will show up with the
+         * next AdaptersChanged signal, until then there's nothing.
+         */
+        GERR("%s", GERRMSG(error));
+        g_error_free(error);
+        g_object_ref(self);
+        nfc_target_monitor_drop_adapters(self, NULL, g_get_monotonic_time());
+        GASSERT(self->pending);
+        if (!--self->pending) {
+            nfc_target_monitor_set_valid(self, TRUE);
+        }
+        g_object_unref(self);
+    }
+}
+
+static
+void
+nfc_target_monitor_cancel_queries(
+    NfcTargetMonitorObject* self)
+{
+    if (self->cancel) {
+        g_cancellable_cancel(self->cancel);
+        g_object_unref(self->cancel);
+        self->cancel = NULL;
+    }
+    self->pending = 0;
+}
+
+static
+void
+nfc_target_monitor_daemon_appeared(
+    GDBusConnection* connection,
+    const gchar* name,
+    const gchar* owner,
+    gpointer user_data)
+{
+    NfcTargetMonitorObject* self = THIS(user_data);
+
+    GDEBUG("%s appeared (%s)", name, owner);
+    nfc_target_monitor_cancel_queries(self);
+    nfc_target_monitor_set_valid(self, FALSE);
+    self->cancel = g_cancellable_new();
+    self->pending = 1;
+    g_dbus_connection_call(connection, NFCD_DBUS_DAEMON_NAME,
+        NFCD_DBUS_DAEMON_PATH, NFCD_DAEMON_INTERFACE, "GetAdapters", NULL,
+        G_VARIANT_TYPE("(ao)"), G_DBUS_CALL_FLAGS_NONE, -1, self->cancel,
+        nfc_target_monitor_get_adapters_done, self);
+}
+
+static
+void
+nfc_target_monitor_daemon_vanished(
+    GDBusConnection* connection,
+    const gchar* name,
+    gpointer user_data)
+{
+    NfcTargetMonitorObject* self = THIS(user_data);
+
+    GDEBUG("%s vanished", name);
+    g_object_ref(self);
+    nfc_target_monitor_cancel_queries(self);
+    nfc_target_monitor_drop_adapters(self, NULL, g_get_monotonic_time());
+
+    /* No daemon means nothing is present, that's a known state */
+    nfc_target_monitor_set_valid(self, TRUE);
+    g_object_unref(self);
+}
+
+static
+void
+nfc_target_monitor_adapters_changed(
+    GDBusConnection* connection,
+    const char* sender,
+    const char* path,
+    const char* iface,
+    const char* name,
+    GVariant* args,
+    gpointer user_data)
+{
+    if (g_variant_is_of_type(args, G_VARIANT_TYPE("(ao)"))) {
+        NfcTargetMonitorObject* self = THIS(user_data);
+        GStrV* list = NULL;
+        const GStrV* ptr;
+
+        g_variant_get(args, "(^ao)", &list);
+        g_object_ref(self);
+        nfc_target_monitor_drop_adapters(self, list, g_get_monotonic_time());
+        for (ptr = list; ptr && *ptr; ptr++) {
+            NfcTargetMonitorAdapter* adapter =
+                nfc_target_monitor_adapter(self, *ptr);
+
+            /* Nothing can be present on a brand new adapter */
+            adapter->tags_known = adapter->peers_known = TRUE;
+        }
+        g_strfreev(list);
+        g_object_unref(self);
+    }
+}
+
+static
+void
+nfc_target_monitor_targets_changed(
+    GDBusConnection* connection,
+    const char* sender,
+    const char* path,
+    const char* iface,
+    const char* name,
+    GVariant* args,
+    gpointer user_data)
+{
+    if (g_variant_is_of_type(args, G_VARIANT_TYPE("(ao)"))) {
+        NfcTargetMonitorObject* self = THIS(user_data);
+        NfcTargetMonitorAdapter* adapter =
+            nfc_target_monitor_adapter(self, path);
+        const gint64 now = g_get_monotonic_time();
+        GStrV* list = NULL;
+
+        g_variant_get(args, "(^ao)", &list);
+        g_object_ref(self);
+        if (!strcmp(name, "TagsChanged")) {
+            adapter->tags_known = TRUE;
+            nfc_target_monitor_update(self, adapter->path, &adapter->tags,
+                list, NFC_TARGET_TAG_ARRIVED, NFC_TARGET_TAG_LEFT, now);
+        } else {
+            adapter->peers_known = TRUE;
+            nfc_target_monitor_update(self, adapter->path, &adapter->peers,
+                list, NFC_TARGET_PEER_ARRIVED, NFC_TARGET_PEER_LEFT, now);
+        }
+        g_strfreev(list);
+        g_object_unref(self);
+    }
+}
+
+static
+guint
+nfc_target_monitor_subscribe(
+    NfcTargetMonitorObject* self,
+    const char* iface,
+    const char* name,
+    GDBusSignalCallback callback)
+{
+    return g_dbus_connection_signal_subscribe(self->connection,
+        NFCD_DBUS_DAEMON_NAME, iface, name, NULL, NULL,
+        G_DBUS_SIGNAL_FLAGS_NONE, callback, self, NULL);
+}
+
+static
+void
+nfc_target_monitor_foreach_path(
+    NfcTargetMonitorObject* self,
+    NfcTargetEvent* event,
+    const GStrV* list,
+    NfcTargetMonitorEventFunc callback,
+    void* user_data)
+{
+    const GStrV* ptr;
+
+    for (ptr = list; ptr && *ptr; ptr++) {
+        event->path = *ptr;
+        callback(&self->pub, event, user_data);
+    }
+}
+
+static
+gulong
+nfc_target_monitor_add_handler(
+    NfcTargetMonitorObject* self,
+    int signal,
+    NfcTargetMonitorEventFunc callback,
+    void* user_data)
+{
+    if (G_LIKELY(self) && G_LIKELY(callback)) {
+        /* Same trick as in nfc_client_base_add_property_handler() */
+        NfcTargetMonitorClosure* closure = nfc_target_monitor_closure_new();
+        GCClosure* cc = &closure->cclosure;
+
+        cc->closure.data = closure;
+        cc->callback = G_CALLBACK(nfc_target_monitor_event);
+        closure->callback = callback;
+        closure->user_data = user_data;
+
+        return g_signal_connect_closure_by_id(self,
+            nfc_target_monitor_signals[signal], 0, &cc->closure, FALSE);
+    }
+    return 0;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+NfcTargetMonitor*
+nfc_target_monitor_new()
+{
+    if (nfc_target_monitor_instance) {
+        g_object_ref(nfc_target_monitor_instance);
+    } else {
+        GError* error = NULL;
+        NfcTargetMonitorObject* self = g_object_new(THIS_TYPE, NULL);
+
+        self->connection = g_bus_get_sync(NFCD_DBUS_TYPE, NULL, &error);
+        if (self->connection) {
+            self->subscription_id[SUBSCRIPTION_ADAPTERS_CHANGED] =
+                nfc_target_monitor_subscribe(self, NFCD_DAEMON_INTERFACE,
+                    "AdaptersChanged", nfc_target_monitor_adapters_changed);
+            self->subscription_id[SUBSCRIPTION_TAGS_CHANGED] =
+                nfc_target_monitor_subscribe(self, NFCD_ADAPTER_INTERFACE,
+                    "TagsChanged", nfc_target_monitor_targets_changed);
+            self->subscription_id[SUBSCRIPTION_PEERS_CHANGED] =
+                nfc_target_monitor_subscribe(self, NFCD_ADAPTER_INTERFACE,
+                    "PeersChanged", nfc_target_monitor_targets_changed);
+            self->watch_id = g_bus_watch_name_on_connection(self->connection,
+                NFCD_DBUS_DAEMON_NAME, G_BUS_NAME_WATCHER_FLAGS_NONE,
+                nfc_target_monitor_daemon_appeared,
+                nfc_target_monitor_daemon_vanished,
+                self, NULL);
+        } else {
+            GERR("Failed to attach to NFC daemon bus: %s", GERRMSG(error));
+            g_error_free(error);
+        }
+        nfc_target_monitor_instance = self;
+    }
+    return &nfc_target_monitor_instance->pub;
+}
+
+NfcTargetMonitor*
+nfc_target_monitor_ref(
+    NfcTargetMonitor* monitor)
+{
+    gutil_object_ref(nfc_target_monitor_object_cast(monitor));
+    return monitor;
+}
+
+void
+nfc_target_monitor_unref(
+    NfcTargetMonitor* monitor)
+{
+    gutil_object_unref(nfc_target_monitor_object_cast(monitor));
+}
+
+void
+nfc_target_monitor_foreach(
+    NfcTargetMonitor* monitor,
+    NfcTargetMonitorEventFunc callback,
+    void* user_data)
+{
+    NfcTargetMonitorObject* self = nfc_target_monitor_object_cast(monitor);
+
+    if (G_LIKELY(self) && G_LIKELY(callback)) {
+        NfcTargetEvent event;
+        GHashTableIter it;
+        gpointer value;
+
+        /* The time of arrival is unknown */
+        event.time = 0;
+        event.technology = NFC_TECH_NONE;
+        event.uid = NULL;
+        g_object_ref(self);
+        g_hash_table_iter_init(&it, self->adapters);
+        while (g_hash_table_iter_next(&it, NULL, &value)) {
+            NfcTargetMonitorAdapter* adapter = value;
+
+            event.adapter = adapter->path;
+            event.type = NFC_TARGET_TAG_ARRIVED;
+            nfc_target_monitor_foreach_path(self, &event, adapter->tags,
+                callback, user_data);
+            event.type = NFC_TARGET_PEER_ARRIVED;
+            nfc_target_monitor_foreach_path(self, &event, adapter->peers,
+                callback, user_data);
+        }
+        g_object_unref(self);
+    }
+}
+
+gboolean
+nfc_target_monitor_identify_tag(
+    NfcTargetMonitor* monitor,
+    const char* path)
+{
+    NfcTargetMonitorObject* self = nfc_target_monitor_object_cast(monitor);
+
+    if (G_LIKELY(self) && G_LIKELY(path)) {
+        GHashTableIter it;
+        gpointer value;
+
+        g_hash_table_iter_init(&it, self->adapters);
+        while (g_hash_table_iter_next(&it, NULL, &value)) {
+            NfcTargetMonitorAdapter* adapter = value;
+
+            if (gutil_strv_contains(adapter->tags, path)) {
+                nfc_target_monitor_identify(self, adapter->path, path,
+                    g_get_monotonic_time());
+                return TRUE;
+            }
+        }
+    }
+    return FALSE;
+}
+
+gulong
+nfc_target_monitor_add_property_handler(
+    NfcTargetMonitor* monitor,
+    NFC_TARGET_MONITOR_PROPERTY property,
+    NfcTargetMonitorPropertyFunc callback,
+    void* user_data)
+{
+    NfcTargetMonitorObject* self = nfc_target_monitor_object_cast(monitor);
+
+    return G_LIKELY(self) ? nfc_client_base_add_property_handler(&self->base,
+        property, (NfcClientBasePropertyFunc) callback, user_data) : 0;
+}
+
+gulong
+nfc_target_monitor_add_event_handler(
+    NfcTargetMonitor* monitor,
+    NfcTargetMonitorEventFunc callback,
+    void* user_data)
+{
+    return nfc_target_monitor_add_handler
+        (nfc_target_monitor_object_cast(monitor), SIGNAL_EVENT,
+            callback, user_data);
+}
+
+gulong
+nfc_target_monitor_add_tag_identified_handler(
+    NfcTargetMonitor* monitor,
+    NfcTargetMonitorEventFunc callback,
+    void* user_data)
+{
+    return nfc_target_monitor_add_handler
+        (nfc_target_monitor_object_cast(monitor), SIGNAL_TAG_IDENTIFIED,
+            callback, user_data);
+}
+
+void
+nfc_target_monitor_remove_handler(
+    NfcTargetMonitor* monitor,
+    gulong id)
+{
+    if (G_LIKELY(id)) {
+        NfcTargetMonitorObject* self = nfc_target_monitor_object_cast(monitor);
+
+        if (G_LIKELY(self)) {
+            g_signal_handler_disconnect(self, id);
+        }
+    }
+}
+
+void
+nfc_target_monitor_remove_handlers(
+    NfcTargetMonitor* monitor,
+    gulong* ids,
+    guint n)
+{
+    gutil_disconnect_handlers(nfc_target_monitor_object_cast(monitor), ids, n);
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+nfc_target_monitor_object_init(
+    NfcTargetMonitorObject* self)
+{
+    GVERBOSE_("");
+    self->adapters = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+        nfc_target_monitor_adapter_free);
+}
+
+static
+void
+nfc_target_monitor_object_finalize(
+    GObject* object)
+{
+    NfcTargetMonitorObject* self = THIS(object);
+    guint i;
+
+    GVERBOSE_("");
+    GASSERT(nfc_target_monitor_instance == self);
+    nfc_target_monitor_instance = NULL;
+    nfc_target_monitor_cancel_queries(self);
+    if (self->watch_id) {
+        g_bus_unwatch_name(self->watch_id);
+    }
+    if (self->connection) {
+        for (i = 0; i < SUBSCRIPTION_COUNT; i++) {
+            if (self->subscription_id[i]) {
+                g_dbus_connection_signal_unsubscribe(self->connection,
+                    self->subscription_id[i]);
+            }
+        }
+        g_object_unref(self->connection);
+    }
+    g_hash_table_destroy(self->adapters);
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+nfc_target_monitor_object_class_init(
+    NfcTargetMonitorObjectClass* klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = nfc_target_monitor_object_finalize;
+    klass->public_offset = G_STRUCT_OFFSET(NfcTargetMonitorObject, pub);
+    klass->valid_offset = G_STRUCT_OFFSET(NfcTargetMonitorObject, pub.valid);
+    nfc_target_monitor_signals[SIGNAL_EVENT] =
+        g_signal_new(SIGNAL_EVENT_NAME, G_OBJECT_CLASS_TYPE(klass),
+            G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE,
+            1, G_TYPE_POINTER);
+    nfc_target_monitor_signals[SIGNAL_TAG_IDENTIFIED] =
+        g_signal_new(SIGNAL_TAG_IDENTIFIED_NAME, G_OBJECT_CLASS_TYPE(klass),
+            G_SIGNAL_RUN_FIRST, 0, NULL, NULL, NULL, G_TYPE_NONE,
+            1, G_TYPE_POINTER);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
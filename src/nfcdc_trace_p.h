@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+#ifndef NFCDC_TRACE_PRIVATE_H
+#define NFCDC_TRACE_PRIVATE_H
+
+/*
+ * USDT probes, compiled in with make USDT=1 (requires sys/sdt.h).
+ * Disabled probes are a single nop and don't evaluate anything except
+ * the arguments, which are kept cheap. List them with something like:
+ *
+ *   perf list 'sdt_libgnfcdc:*'
+ *   bpftrace -l 'usdt:/usr/lib/libgnfcdc.so.*:*'
+ *
+ * Probes:
+ *
+ *   transmit__start(call, path, ins)
+ *   transmit__done(call, sw, ok)
+ *   transceive__start(call, path, size)
+ *   transceive__done(call, ok)
+ *   init__start(path, op)
+ *   init__done(path, op, ok)
+ *   signals__emit(object, queued_signals)
+ *   signals__done(object)
+ *
+ * where op is NFC_CLIENT_OP value identifying the GetAll variant.
+ */
+
+#ifdef NFCDC_USDT
+#  include <sys/sdt.h>
+#  define NFCDC_TRACE1(name,a) DTRACE_PROBE1(libgnfcdc,name,a)
+#  define NFCDC_TRACE2(name,a,b) DTRACE_PROBE2(libgnfcdc,name,a,b)
+#  define NFCDC_TRACE3(name,a,b,c) DTRACE_PROBE3(libgnfcdc,name,a,b,c)
+#else
+#  define NFCDC_TRACE1(name,a) ((void)0)
+#  define NFCDC_TRACE2(name,a,b) ((void)0)
+#  define NFCDC_TRACE3(name,a,b,c) ((void)0)
+#endif
+
+#endif /* NFCDC_TRACE_PRIVATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
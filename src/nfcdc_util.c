@@ -40,6 +40,8 @@
 
 #include <gutil_misc.h>
 
+#include <gio/gio.h>
+
 GUtilData*
 nfc_data_copy(
     const void* data,
@@ -113,7 +115,7 @@ nfc_parse_dict(
                 GUtilData* data = nfc_data_from_variant(dict_value);
 
                 if (data) {
-                    DUMP_DATA("  ", name, "=", data);
+                    DUMP_PARAM("  ", name, "=", data);
                     g_hash_table_insert(params, GINT_TO_POINTER(key), data);
                 }
                 g_variant_unref(dict_value);
@@ -155,6 +157,37 @@ nfc_params_equal(
     }
 }
 
+gboolean
+nfc_deadline_expired(
+    gint64 deadline)
+{
+    return deadline && g_get_monotonic_time() >= deadline;
+}
+
+guint
+nfc_deadline_timeout_add(
+    gint64 deadline,
+    GSourceFunc func,
+    gpointer data)
+{
+    if (deadline) {
+        const gint64 left = deadline - g_get_monotonic_time();
+
+        /* Round up to milliseconds, so that we don't fire too early */
+        return g_timeout_add((left > 0) ? (guint)
+            MIN((left + 999) / 1000, G_MAXUINT) : 0, func, data);
+    }
+    return 0;
+}
+
+GError*
+nfc_deadline_error(
+    void)
+{
+    return g_error_new_literal(G_IO_ERROR, G_IO_ERROR_TIMED_OUT,
+        "Deadline expired");
+}
+
 /*
  * Local Variables:
  * mode: C
@@ -69,6 +69,25 @@ nfc_params_equal(
     GHashTable* params2)
     G_GNUC_INTERNAL;
 
+/* Deadlines are g_get_monotonic_time() based, zero means no deadline */
+
+gboolean
+nfc_deadline_expired(
+    gint64 deadline)
+    G_GNUC_INTERNAL;
+
+guint
+nfc_deadline_timeout_add(
+    gint64 deadline,
+    GSourceFunc func,
+    gpointer data)
+    G_GNUC_INTERNAL;
+
+GError*
+nfc_deadline_error(
+    void)
+    G_GNUC_INTERNAL;
+
 #endif /* NFCDC_UTIL_PRIVATE_H */
 
 /*
@@ -0,0 +1,699 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+/*
+ * Reader-side benchmarks. Normally run by the run-bench script against
+ * nfc-mock on a private bus, but works against any nfcd with an ISO-DEP
+ * tag present. Results are printed to stdout as JSON, one object per
+ * line.
+ */
+
+#include "nfcdc_adapter.h"
+#include "nfcdc_daemon.h"
+#include "nfcdc_isodep.h"
+#include "nfcdc_tag.h"
+
+#include <gutil_log.h>
+#include <gutil_misc.h>
+#include <gutil_strv.h>
+
+#include <gio/gio.h>
+
+#include <stdlib.h>
+
+#define RET_OK (0)
+#define RET_ERR (1)
+
+#define BENCH_TIMEOUT_MS (5000)
+#define BENCH_TICK_MS (100)
+
+#define MOCK_CONTROL_INTERFACE "org.sailfishos.nfc.Mock"
+#define MOCK_DAEMON_NAME "org.sailfishos.nfc.daemon"
+
+typedef struct bench {
+    int count;
+    int depth;
+    int handlers;
+    int size;
+    const char* filter;
+    NfcDaemonClient* daemon;
+    NfcAdapterClient* adapter;
+    NfcIsoDepClient* isodep;
+    NfcIsoDepApdu apdu;
+    guint issued;
+    guint completed;
+    guint failed;
+    guint dispatched;
+} Bench;
+
+typedef
+gboolean
+(*BenchCheckFunc)(
+    gpointer data);
+
+/*==========================================================================*
+ * Allocation counter
+ *==========================================================================*/
+
+/*
+ * Counts malloc(), calloc() and realloc() calls made by the process,
+ * including those made by glib and the D-Bus worker thread. This is
+ * glibc specific, elsewhere the counter stays at zero.
+ */
+
+static gint bench_allocs = 0;
+
+#ifdef __GLIBC__
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+void*
+malloc(
+    size_t size)
+{
+    g_atomic_int_inc(&bench_allocs);
+    return __libc_malloc(size);
+}
+
+void*
+calloc(
+    size_t nmemb,
+    size_t size)
+{
+    g_atomic_int_inc(&bench_allocs);
+    return __libc_calloc(nmemb, size);
+}
+
+void*
+realloc(
+    void* ptr,
+    size_t size)
+{
+    g_atomic_int_inc(&bench_allocs);
+    return __libc_realloc(ptr, size);
+}
+
+#endif /* __GLIBC__ */
+
+static inline
+guint
+bench_allocs_get(
+    void)
+{
+    return (guint) g_atomic_int_get(&bench_allocs);
+}
+
+/*==========================================================================*
+ * Utilities
+ *==========================================================================*/
+
+static
+gboolean
+bench_tick(
+    gpointer data)
+{
+    /* Just wakes up the main loop */
+    return G_SOURCE_CONTINUE;
+}
+
+static
+gboolean
+bench_wait(
+    BenchCheckFunc check,
+    gpointer data)
+{
+    const gint64 deadline = g_get_monotonic_time() +
+        BENCH_TIMEOUT_MS * G_GINT64_CONSTANT(1000);
+
+    /*
+     * Nothing is allocated here, not to count it as the cost of the
+     * operation being measured. The ticker started by bench_run() makes
+     * sure that the deadline gets checked even if nothing happens.
+     */
+    while (!check(data)) {
+        if (g_get_monotonic_time() >= deadline) {
+            GERR("Timed out");
+            return FALSE;
+        }
+        g_main_context_iteration(NULL, TRUE);
+    }
+    return TRUE;
+}
+
+static
+int
+bench_compare_samples(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const gint64 sa = *(const gint64*)a;
+    const gint64 sb = *(const gint64*)b;
+
+    return (sa < sb) ? -1 : (sa > sb) ? 1 : 0;
+}
+
+static
+void
+bench_report_latency(
+    const char* test,
+    GArray* samples,
+    guint allocs)
+{
+    const guint n = samples->len;
+
+    if (n) {
+        const gint64* s;
+        gint64 sum = 0;
+        guint i;
+
+        g_array_sort(samples, bench_compare_samples);
+        s = (const gint64*) samples->data;
+        for (i = 0; i < n; i++) {
+            sum += s[i];
+        }
+        printf("{\"test\":\"%s\",\"count\":%u,\"min_us\":%" G_GINT64_FORMAT
+            ",\"p50_us\":%" G_GINT64_FORMAT ",\"p90_us\":%" G_GINT64_FORMAT
+            ",\"p99_us\":%" G_GINT64_FORMAT ",\"max_us\":%" G_GINT64_FORMAT
+            ",\"mean_us\":%.1f,\"allocs_per_op\":%.1f}\n", test, n, s[0],
+            s[n / 2], s[n * 9 / 10], s[n * 99 / 100], s[n - 1],
+            (double) sum / n, (double) allocs / n);
+        fflush(stdout);
+    }
+}
+
+static
+gboolean
+bench_enabled(
+    Bench* bench,
+    const char* test)
+{
+    return !bench->filter || g_str_has_prefix(test, bench->filter);
+}
+
+/*==========================================================================*
+ * Init latency
+ *==========================================================================*/
+
+static
+gboolean
+bench_daemon_ready(
+    gpointer data)
+{
+    NfcDaemonClient* daemon = data;
+
+    return daemon->valid && daemon->present;
+}
+
+static
+gboolean
+bench_adapter_ready(
+    gpointer data)
+{
+    NfcAdapterClient* adapter = data;
+
+    return adapter->valid;
+}
+
+static
+gboolean
+bench_tag_ready(
+    gpointer data)
+{
+    NfcTagClient* tag = data;
+
+    return tag->valid;
+}
+
+static
+gboolean
+bench_isodep_ready(
+    gpointer data)
+{
+    NfcIsoDepClient* isodep = data;
+
+    return isodep->valid;
+}
+
+static
+gboolean
+bench_init_step(
+    GArray* samples,
+    guint* allocs,
+    BenchCheckFunc ready,
+    gpointer object,
+    gint64 t0,
+    guint a0)
+{
+    if (bench_wait(ready, object)) {
+        const gint64 dt = g_get_monotonic_time() - t0;
+
+        g_array_append_val(samples, dt);
+        *allocs += bench_allocs_get() - a0;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+gboolean
+bench_init(
+    Bench* bench)
+{
+    static const char* tests[] = {
+        "init.daemon", "init.adapter", "init.tag", "init.isodep"
+    };
+    GArray* samples[G_N_ELEMENTS(tests)];
+    guint allocs[G_N_ELEMENTS(tests)];
+    char* adapter_path = g_strdup(bench->adapter->path);
+    char* tag_path = g_strdup(bench->isodep->path);
+    gboolean ok = TRUE;
+    guint i, k;
+
+    /* Preallocated, appending a sample doesn't allocate anything */
+    for (k = 0; k < G_N_ELEMENTS(tests); k++) {
+        samples[k] = g_array_sized_new(FALSE, FALSE, sizeof(gint64),
+            bench->count);
+        allocs[k] = 0;
+    }
+
+    /*
+     * Drop the objects we are holding, so that each iteration creates
+     * everything from scratch. Only the bus connection stays cached.
+     */
+    nfc_isodep_client_unref(bench->isodep);
+    nfc_adapter_client_unref(bench->adapter);
+    nfc_daemon_client_unref(bench->daemon);
+    bench->isodep = NULL;
+    bench->adapter = NULL;
+    bench->daemon = NULL;
+
+    for (i = 0; i < (guint) bench->count && ok; i++) {
+        NfcDaemonClient* daemon;
+        NfcAdapterClient* adapter = NULL;
+        NfcTagClient* tag = NULL;
+        NfcIsoDepClient* isodep = NULL;
+        guint a0 = bench_allocs_get();
+        gint64 t0 = g_get_monotonic_time();
+
+        daemon = nfc_daemon_client_new();
+        ok = bench_init_step(samples[0], allocs + 0, bench_daemon_ready,
+            daemon, t0, a0);
+        if (ok) {
+            a0 = bench_allocs_get();
+            t0 = g_get_monotonic_time();
+            adapter = nfc_adapter_client_new(adapter_path);
+            ok = bench_init_step(samples[1], allocs + 1, bench_adapter_ready,
+                adapter, t0, a0);
+        }
+        if (ok) {
+            a0 = bench_allocs_get();
+            t0 = g_get_monotonic_time();
+            tag = nfc_tag_client_new(tag_path);
+            ok = bench_init_step(samples[2], allocs + 2, bench_tag_ready,
+                tag, t0, a0);
+        }
+        if (ok) {
+            a0 = bench_allocs_get();
+            t0 = g_get_monotonic_time();
+            isodep = nfc_isodep_client_new(tag_path);
+            ok = bench_init_step(samples[3], allocs + 3, bench_isodep_ready,
+                isodep, t0, a0);
+        }
+        nfc_isodep_client_unref(isodep);
+        nfc_tag_client_unref(tag);
+        nfc_adapter_client_unref(adapter);
+        nfc_daemon_client_unref(daemon);
+    }
+
+    for (k = 0; k < G_N_ELEMENTS(tests); k++) {
+        bench_report_latency(tests[k], samples[k], allocs[k]);
+        g_array_free(samples[k], TRUE);
+    }
+
+    /* Restore the state for the other tests */
+    bench->daemon = nfc_daemon_client_new();
+    bench->adapter = nfc_adapter_client_new(adapter_path);
+    bench->isodep = nfc_isodep_client_new(tag_path);
+    g_free(adapter_path);
+    g_free(tag_path);
+    return ok && bench_wait(bench_isodep_ready, bench->isodep) &&
+        bench_wait(bench_adapter_ready, bench->adapter);
+}
+
+/*==========================================================================*
+ * APDU round trip and throughput
+ *==========================================================================*/
+
+static
+void
+bench_transmit_done(
+    NfcIsoDepClient* isodep,
+    const GUtilData* response,
+    guint sw,
+    const GError* error,
+    void* user_data)
+{
+    Bench* bench = user_data;
+
+    bench->completed++;
+    if (error || sw != 0x9000) {
+        bench->failed++;
+    }
+}
+
+static
+gboolean
+bench_transmit_completed(
+    gpointer data)
+{
+    Bench* bench = data;
+
+    return bench->completed == bench->issued;
+}
+
+static
+gboolean
+bench_apdu_rtt(
+    Bench* bench)
+{
+    /* Preallocated, appending a sample doesn't allocate anything */
+    GArray* samples = g_array_sized_new(FALSE, FALSE, sizeof(gint64),
+        bench->count);
+    const guint a0 = bench_allocs_get();
+    gboolean ok = TRUE;
+    guint i;
+
+    bench->issued = bench->completed = bench->failed = 0;
+    for (i = 0; i < (guint) bench->count && ok; i++) {
+        const gint64 t0 = g_get_monotonic_time();
+
+        bench->issued++;
+        ok = nfc_isodep_client_transmit(bench->isodep, &bench->apdu, NULL,
+            bench_transmit_done, bench, NULL) &&
+            bench_wait(bench_transmit_completed, bench);
+        if (ok) {
+            const gint64 dt = g_get_monotonic_time() - t0;
+
+            g_array_append_val(samples, dt);
+        }
+    }
+    bench_report_latency("apdu.rtt", samples, bench_allocs_get() - a0);
+    g_array_free(samples, TRUE);
+    return ok && !bench->failed;
+}
+
+static
+void
+bench_pipeline_done(
+    NfcIsoDepClient* isodep,
+    const GUtilData* response,
+    guint sw,
+    const GError* error,
+    void* user_data)
+{
+    Bench* bench = user_data;
+
+    bench_transmit_done(isodep, response, sw, error, user_data);
+    if (bench->issued < (guint) bench->count) {
+        bench->issued++;
+        nfc_isodep_client_transmit(isodep, &bench->apdu, NULL,
+            bench_pipeline_done, bench, NULL);
+    }
+}
+
+static
+gboolean
+bench_pipeline_finished(
+    gpointer data)
+{
+    Bench* bench = data;
+
+    return bench->completed == (guint) bench->count;
+}
+
+static
+gboolean
+bench_apdu_throughput(
+    Bench* bench)
+{
+    const guint a0 = bench_allocs_get();
+    const gint64 t0 = g_get_monotonic_time();
+    gboolean ok;
+    gint64 dt;
+    guint i;
+
+    /* Keep up to depth APDUs in flight */
+    bench->issued = bench->completed = bench->failed = 0;
+    for (i = 0; i < (guint) bench->depth && i < (guint) bench->count; i++) {
+        bench->issued++;
+        nfc_isodep_client_transmit(bench->isodep, &bench->apdu, NULL,
+            bench_pipeline_done, bench, NULL);
+    }
+    ok = bench_wait(bench_pipeline_finished, bench);
+    dt = g_get_monotonic_time() - t0;
+    if (ok && dt > 0) {
+        printf("{\"test\":\"apdu.throughput\",\"count\":%u,\"depth\":%d,"
+            "\"size\":%d,\"elapsed_us\":%" G_GINT64_FORMAT ",\"ops_per_sec\":"
+            "%.1f,\"allocs_per_op\":%.1f}\n", bench->completed, bench->depth,
+            bench->size, dt, bench->completed * 1e6 / dt,
+            (double) (bench_allocs_get() - a0) / bench->completed);
+        fflush(stdout);
+    }
+    return ok && !bench->failed;
+}
+
+/*==========================================================================*
+ * Property dispatch
+ *==========================================================================*/
+
+static
+void
+bench_mode_changed(
+    NfcAdapterClient* adapter,
+    NFC_ADAPTER_PROPERTY property,
+    void* user_data)
+{
+    ((Bench*) user_data)->dispatched++;
+}
+
+static
+gboolean
+bench_dispatch_finished(
+    gpointer data)
+{
+    Bench* bench = data;
+
+    return bench->dispatched >= (guint) (bench->count * bench->handlers);
+}
+
+static
+gboolean
+bench_property_dispatch(
+    Bench* bench)
+{
+    GDBusConnection* bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, NULL);
+    gulong* ids = g_new(gulong, bench->handlers);
+    gboolean ok = FALSE;
+    guint a0;
+    gint64 t0;
+    int i;
+
+    for (i = 0; i < bench->handlers; i++) {
+        ids[i] = nfc_adapter_client_add_property_handler(bench->adapter,
+            NFC_ADAPTER_PROPERTY_MODE, bench_mode_changed, bench);
+    }
+
+    /* Only nfc-mock knows how to do this */
+    bench->dispatched = 0;
+    a0 = bench_allocs_get();
+    t0 = g_get_monotonic_time();
+    if (bus) {
+        g_dbus_connection_call(bus, MOCK_DAEMON_NAME, "/",
+            MOCK_CONTROL_INTERFACE, "EmitModeChanged",
+            g_variant_new("(u)", bench->count), NULL,
+            G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL, NULL);
+        ok = bench_wait(bench_dispatch_finished, bench);
+    }
+    if (ok) {
+        const gint64 dt = g_get_monotonic_time() - t0;
+
+        printf("{\"test\":\"property.dispatch\",\"count\":%d,"
+            "\"handlers\":%d,\"elapsed_us\":%" G_GINT64_FORMAT ","
+            "\"us_per_signal\":%.2f,\"allocs_per_op\":%.1f}\n",
+            bench->count, bench->handlers, dt, (double) dt / bench->count,
+            (double) (bench_allocs_get() - a0) / bench->count);
+        fflush(stdout);
+    }
+
+    nfc_adapter_client_remove_handlers(bench->adapter, ids, bench->handlers);
+    g_free(ids);
+    if (bus) {
+        g_object_unref(bus);
+    }
+    return ok;
+}
+
+/*==========================================================================*
+ * Main
+ *==========================================================================*/
+
+static
+gboolean
+bench_setup(
+    Bench* bench)
+{
+    bench->daemon = nfc_daemon_client_new();
+    if (bench_wait(bench_daemon_ready, bench->daemon) &&
+        bench->daemon->adapters[0]) {
+        bench->adapter = nfc_adapter_client_new(bench->daemon->adapters[0]);
+        if (bench_wait(bench_adapter_ready, bench->adapter) &&
+            bench->adapter->tags[0]) {
+            bench->isodep = nfc_isodep_client_new(bench->adapter->tags[0]);
+            if (bench_wait(bench_isodep_ready, bench->isodep) &&
+                bench->isodep->present) {
+                return TRUE;
+            }
+        }
+    }
+    GERR("No ISO-DEP tag found");
+    return FALSE;
+}
+
+static
+int
+bench_run(
+    Bench* bench)
+{
+    const guint tick_id = g_timeout_add(BENCH_TICK_MS, bench_tick, NULL);
+    int ret = RET_ERR;
+
+    if (bench_setup(bench)) {
+        void* data = g_malloc0(bench->size);
+
+        /* Not a SELECT, to keep the library's SELECT cache out of it */
+        bench->apdu.cla = 0x00;
+        bench->apdu.ins = 0xb0; /* READ BINARY */
+        bench->apdu.data.bytes = data;
+        bench->apdu.data.size = bench->size;
+        if ((!bench_enabled(bench, "init") || bench_init(bench)) &&
+            (!bench_enabled(bench, "apdu.rtt") || bench_apdu_rtt(bench)) &&
+            (!bench_enabled(bench, "apdu.throughput") ||
+            bench_apdu_throughput(bench)) &&
+            (!bench_enabled(bench, "property") ||
+            bench_property_dispatch(bench))) {
+            ret = RET_OK;
+        }
+        g_free(data);
+    }
+    nfc_isodep_client_unref(bench->isodep);
+    nfc_adapter_client_unref(bench->adapter);
+    nfc_daemon_client_unref(bench->daemon);
+    g_source_remove(tick_id);
+    return ret;
+}
+
+static
+gboolean
+bench_opt_verbose(
+    const gchar* name,
+    const gchar* value,
+    gpointer user_data,
+    GError** error)
+{
+    gutil_log_default.level = GLOG_LEVEL_VERBOSE;
+    return TRUE;
+}
+
+int main(int argc, char* argv[])
+{
+    int ret = RET_ERR;
+    char* filter = NULL;
+    Bench bench;
+    GOptionEntry entries[] = {
+        { "verbose", 'v', G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK,
+          bench_opt_verbose, "Enable verbose output", NULL },
+        { "count", 'n', 0, G_OPTION_ARG_INT, &bench.count,
+          "Number of iterations [1000]", "N" },
+        { "depth", 'd', 0, G_OPTION_ARG_INT, &bench.depth,
+          "APDUs in flight for the throughput test [8]", "N" },
+        { "handlers", 'H', 0, G_OPTION_ARG_INT, &bench.handlers,
+          "Property handlers for the dispatch test [4]", "N" },
+        { "size", 's', 0, G_OPTION_ARG_INT, &bench.size,
+          "APDU payload size [16]", "BYTES" },
+        { "test", 't', 0, G_OPTION_ARG_STRING, &filter,
+          "Run tests starting with PREFIX (init, apdu, property)",
+          "PREFIX" },
+        { NULL }
+    };
+    GError* error = NULL;
+    GOptionContext* options = g_option_context_new(NULL);
+
+    memset(&bench, 0, sizeof(bench));
+    bench.count = 1000;
+    bench.depth = 8;
+    bench.handlers = 4;
+    bench.size = 16;
+    gutil_log_default.level = GLOG_LEVEL_ERR;
+    gutil_log_set_type(GLOG_TYPE_STDERR, "nfc-bench");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (g_option_context_parse(options, &argc, &argv, &error) &&
+        argc == 1 && bench.count > 0 && bench.depth > 0 &&
+        bench.handlers > 0 && bench.size >= 0 && bench.size <= 0xff) {
+        bench.filter = filter;
+        ret = bench_run(&bench);
+    } else if (error) {
+        GERR("%s", error->message);
+        g_error_free(error);
+    } else {
+        char* help = g_option_context_get_help(options, TRUE, NULL);
+
+        fprintf(stderr, "%s", help);
+        g_free(help);
+    }
+    g_option_context_free(options);
+    g_free(filter);
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
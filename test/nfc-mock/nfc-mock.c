@@ -0,0 +1,1549 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+/*
+ * Programmable nfcd stand-in, built from the same D-Bus spec files as
+ * the library. Exports Daemon, Settings, Adapter, Tag, IsoDep and Peer
+ * objects on the bus pointed to by DBUS_SYSTEM_BUS_ADDRESS, which is
+ * normally a private bus started by the test scripts.
+ *
+ * Behavior is controlled by a script (-s FILE, one command per line)
+ * and/or at runtime with org.sailfishos.nfc.Mock.Run(s command) on "/".
+ * Commands:
+ *
+ *   version daemon|adapter|tag|isodep|peer N
+ *       Interface version reported from now on (1..4). Methods which
+ *       appeared in later versions fail with UnknownMethod.
+ *   latency MS
+ *       Delay all replies by MS milliseconds
+ *   tag-add
+ *   tag-remove [PATH]
+ *       ISO-DEP tag arrival and removal (the oldest one by default)
+ *   peer-add
+ *   peer-remove [PATH]
+ *   mode HEX
+ *       Change the current mode and emit the ModeChanged signals
+ *   apdu CLAINSP1P2 DATA|* RESPONSE|- SW
+ *       Add an entry to the APDU responder table, e.g.
+ *       apdu 00A40400 A000000151000000 - 9000
+ *       Unmatched APDUs get 6D00 if the table isn't empty, otherwise
+ *       they are echoed back with 9000.
+ *   apdu-clear
+ *   sleep MS
+ *       Pause the script
+ *   exit [CODE]
+ *
+ * Empty lines and lines starting with # are ignored.
+ */
+
+#include "org.sailfishos.nfc.Adapter.h"
+#include "org.sailfishos.nfc.Daemon.h"
+#include "org.sailfishos.nfc.IsoDep.h"
+#include "org.sailfishos.nfc.Peer.h"
+#include "org.sailfishos.nfc.Settings.h"
+#include "org.sailfishos.nfc.Tag.h"
+
+#include <gutil_log.h>
+#include <gutil_misc.h>
+
+#include <gio/gunixfdlist.h>
+#include <glib-unix.h>
+
+#include <string.h>
+
+#define RET_OK (0)
+#define RET_ERR (1)
+
+#define MOCK_DAEMON_NAME "org.sailfishos.nfc.daemon"
+#define MOCK_SETTINGS_NAME "org.sailfishos.nfc.settings"
+#define MOCK_ADAPTER_PATH "/nfc0"
+#define MOCK_DAEMON_VERSION (0x01020200) /* 1.2.2 */
+
+#define MOCK_MODE_P2P_INITIATOR (0x01)
+#define MOCK_MODE_READER_WRITER (0x02)
+#define MOCK_MODE_P2P_TARGET (0x04)
+#define MOCK_MODE_CARD_EMULATION (0x08)
+#define MOCK_MODE_ALL (0x0f)
+#define MOCK_TECH_ALL (0x07)
+
+#define MOCK_TECH_NFC_A (1)
+#define MOCK_PROTOCOL_T4A (8)
+#define MOCK_PEER_WKS (0x03) /* Link Management and SDP */
+
+#define MOCK_SW_INS_NOT_SUPPORTED (0x6d00)
+#define MOCK_SW_OK (0x9000)
+
+#define MOCK_CONTROL_INTERFACE "org.sailfishos.nfc.Mock"
+
+static const char mock_control_xml[] =
+    "<node>"
+    "  <interface name='" MOCK_CONTROL_INTERFACE "'>"
+    "    <method name='Run'>"
+    "      <arg name='command' type='s' direction='in'/>"
+    "    </method>"
+    "    <method name='EmitModeChanged'>"
+    "      <arg name='count' type='u' direction='in'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+typedef enum mock_iface {
+    MOCK_IFACE_DAEMON,
+    MOCK_IFACE_ADAPTER,
+    MOCK_IFACE_TAG,
+    MOCK_IFACE_ISODEP,
+    MOCK_IFACE_PEER,
+    MOCK_IFACE_COUNT
+} MOCK_IFACE;
+
+static const char* const mock_iface_names[] = {
+    "daemon", "adapter", "tag", "isodep", "peer"
+};
+
+G_STATIC_ASSERT(G_N_ELEMENTS(mock_iface_names) == MOCK_IFACE_COUNT);
+
+/* The latest versions known to the library */
+static const int mock_iface_max_version[] = { 4, 4, 4, 3, 1 };
+
+G_STATIC_ASSERT(G_N_ELEMENTS(mock_iface_max_version) == MOCK_IFACE_COUNT);
+
+typedef struct mock_apdu {
+    guint32 header;     /* CLA INS P1 P2 */
+    GBytes* data;       /* NULL matches any data */
+    GBytes* response;
+    guint sw;
+} MockApdu;
+
+/* Both start with the path, see mock_paths() */
+typedef struct mock_tag {
+    char* path;
+    OrgSailfishosNfcTag* tag;
+    OrgSailfishosNfcIsoDep* isodep;
+} MockTag;
+
+typedef struct mock_peer {
+    char* path;
+    OrgSailfishosNfcPeer* peer;
+} MockPeer;
+
+typedef struct mock {
+    GMainLoop* loop;
+    GDBusConnection* connection;
+    OrgSailfishosNfcDaemon* daemon;
+    OrgSailfishosNfcSettings* settings;
+    OrgSailfishosNfcAdapter* adapter;
+    GDBusNodeInfo* control_info;
+    guint control_id;
+    guint own_daemon_id;
+    guint own_settings_id;
+    guint names_owned;
+    int version[MOCK_IFACE_COUNT];
+    guint latency;
+    GPtrArray* tags;
+    GPtrArray* peers;
+    guint last_tag;
+    guint last_peer;
+    GSList* apdus;
+    guint mode;
+    guint last_request_id;
+    char** script;
+    guint script_pos;
+    guint script_sleep_id;
+    int ret;
+} Mock;
+
+typedef struct mock_reply {
+    GDBusMethodInvocation* call;
+    GVariant* value;
+} MockReply;
+
+static
+void
+mock_script_continue(
+    Mock* mock);
+
+/*==========================================================================*
+ * Utilities
+ *==========================================================================*/
+
+static const char* const mock_none[] = { NULL };
+
+static
+gboolean
+mock_signal(
+    gpointer user_data)
+{
+    Mock* mock = user_data;
+
+    GDEBUG("Signal caught, exiting...");
+    g_main_loop_quit(mock->loop);
+    return G_SOURCE_CONTINUE;
+}
+
+static
+const char**
+mock_paths(
+    GPtrArray* list)
+{
+    /* The strings are owned by the objects, the array must be g_free'd */
+    const char** paths = g_new(const char*, list->len + 1);
+    guint i;
+
+    for (i = 0; i < list->len; i++) {
+        paths[i] = *((char**) g_ptr_array_index(list, i));
+    }
+    paths[i] = NULL;
+    return paths;
+}
+
+static
+GVariant*
+mock_empty_dict(
+    void)
+{
+    return g_variant_new_array(G_VARIANT_TYPE("{sv}"), NULL, 0);
+}
+
+static
+gboolean
+mock_reply_timeout(
+    gpointer user_data)
+{
+    MockReply* reply = user_data;
+
+    g_dbus_method_invocation_return_value(reply->call, reply->value);
+    reply->call = NULL;
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mock_reply_free(
+    gpointer user_data)
+{
+    MockReply* reply = user_data;
+
+    if (reply->call) {
+        g_dbus_method_invocation_return_error_literal(reply->call,
+            G_DBUS_ERROR, G_DBUS_ERROR_FAILED, "Cancelled");
+    }
+    if (reply->value) {
+        g_variant_unref(reply->value);
+    }
+    g_slice_free(MockReply, reply);
+}
+
+/* Takes ownership of the invocation, value may be floating or NULL */
+static
+void
+mock_return(
+    Mock* mock,
+    GDBusMethodInvocation* call,
+    GVariant* value)
+{
+    if (mock->latency) {
+        MockReply* reply = g_slice_new(MockReply);
+
+        reply->call = call;
+        reply->value = value ? g_variant_ref_sink(value) : NULL;
+        g_timeout_add_full(G_PRIORITY_DEFAULT, mock->latency,
+            mock_reply_timeout, reply, mock_reply_free);
+    } else {
+        g_dbus_method_invocation_return_value(call, value);
+    }
+}
+
+/* Fails the call if the method doesn't exist in the current version */
+static
+gboolean
+mock_check_version(
+    Mock* mock,
+    MOCK_IFACE iface,
+    int min_version,
+    GDBusMethodInvocation* call)
+{
+    if (mock->version[iface] >= min_version) {
+        return TRUE;
+    } else {
+        g_dbus_method_invocation_return_error(call, G_DBUS_ERROR,
+            G_DBUS_ERROR_UNKNOWN_METHOD, "%s requires %s version %d",
+            g_dbus_method_invocation_get_method_name(call),
+            mock_iface_names[iface], min_version);
+        return FALSE;
+    }
+}
+
+/*==========================================================================*
+ * org.sailfishos.nfc.Daemon
+ *==========================================================================*/
+
+static const char* const mock_adapters[] = { MOCK_ADAPTER_PATH, NULL };
+
+static
+gboolean
+mock_daemon_get_all(
+    OrgSailfishosNfcDaemon* daemon,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    mock_return(mock, call, g_variant_new("(i^ao)",
+        mock->version[MOCK_IFACE_DAEMON], mock_adapters));
+    return TRUE;
+}
+
+static
+gboolean
+mock_daemon_get_all2(
+    OrgSailfishosNfcDaemon* daemon,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_DAEMON, 2, call)) {
+        mock_return(mock, call, g_variant_new("(i^aoi)",
+            mock->version[MOCK_IFACE_DAEMON], mock_adapters,
+            MOCK_DAEMON_VERSION));
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_daemon_get_all3(
+    OrgSailfishosNfcDaemon* daemon,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_DAEMON, 3, call)) {
+        mock_return(mock, call, g_variant_new("(i^aoiu)",
+            mock->version[MOCK_IFACE_DAEMON], mock_adapters,
+            MOCK_DAEMON_VERSION, mock->mode));
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_daemon_get_all4(
+    OrgSailfishosNfcDaemon* daemon,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_DAEMON, 4, call)) {
+        mock_return(mock, call, g_variant_new("(i^aoiuu)",
+            mock->version[MOCK_IFACE_DAEMON], mock_adapters,
+            MOCK_DAEMON_VERSION, mock->mode, MOCK_TECH_ALL));
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_daemon_request_mode(
+    OrgSailfishosNfcDaemon* daemon,
+    GDBusMethodInvocation* call,
+    guint enable,
+    guint disable,
+    Mock* mock)
+{
+    /* Requests are accepted but ignored */
+    if (mock_check_version(mock, MOCK_IFACE_DAEMON, 3, call)) {
+        mock_return(mock, call, g_variant_new("(u)",
+            ++mock->last_request_id));
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_daemon_request_techs(
+    OrgSailfishosNfcDaemon* daemon,
+    GDBusMethodInvocation* call,
+    guint allow,
+    guint disallow,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_DAEMON, 4, call)) {
+        mock_return(mock, call, g_variant_new("(u)",
+            ++mock->last_request_id));
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_daemon_release(
+    OrgSailfishosNfcDaemon* daemon,
+    GDBusMethodInvocation* call,
+    guint id,
+    Mock* mock)
+{
+    mock_return(mock, call, NULL);
+    return TRUE;
+}
+
+/*==========================================================================*
+ * org.sailfishos.nfc.Settings
+ *==========================================================================*/
+
+static
+gboolean
+mock_settings_get_enabled(
+    OrgSailfishosNfcSettings* settings,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    mock_return(mock, call, g_variant_new("(b)", TRUE));
+    return TRUE;
+}
+
+/*==========================================================================*
+ * org.sailfishos.nfc.Adapter
+ *==========================================================================*/
+
+static
+gboolean
+mock_adapter_get_interface_version(
+    OrgSailfishosNfcAdapter* adapter,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    mock_return(mock, call, g_variant_new("(i)",
+        mock->version[MOCK_IFACE_ADAPTER]));
+    return TRUE;
+}
+
+static
+void
+mock_adapter_return_all(
+    Mock* mock,
+    GDBusMethodInvocation* call,
+    int n)
+{
+    const int version = mock->version[MOCK_IFACE_ADAPTER];
+    const guint modes = MOCK_MODE_ALL;
+    const char** tags = mock_paths(mock->tags);
+    const char** peers = mock_paths(mock->peers);
+    const gboolean present = tags[0] || peers[0];
+    GVariant* value;
+
+    switch (n) {
+    case 1:
+        value = g_variant_new("(ibbuub^ao)", version, TRUE, TRUE, modes,
+            mock->mode, present, tags);
+        break;
+    case 2:
+        value = g_variant_new("(ibbuub^ao^ao)", version, TRUE, TRUE, modes,
+            mock->mode, present, tags, peers);
+        break;
+    case 3:
+        value = g_variant_new("(ibbuub^ao^ao^aou)", version, TRUE, TRUE,
+            modes, mock->mode, present, tags, peers, mock_none,
+            MOCK_TECH_ALL);
+        break;
+    default:
+        value = g_variant_new("(ibbuub^ao^ao^aou@a{sv})", version, TRUE,
+            TRUE, modes, mock->mode, present, tags, peers, mock_none,
+            MOCK_TECH_ALL, mock_empty_dict());
+        break;
+    }
+    mock_return(mock, call, value);
+    g_free(tags);
+    g_free(peers);
+}
+
+static
+gboolean
+mock_adapter_get_all(
+    OrgSailfishosNfcAdapter* adapter,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    mock_adapter_return_all(mock, call, 1);
+    return TRUE;
+}
+
+static
+gboolean
+mock_adapter_get_all2(
+    OrgSailfishosNfcAdapter* adapter,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_ADAPTER, 2, call)) {
+        mock_adapter_return_all(mock, call, 2);
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_adapter_get_all3(
+    OrgSailfishosNfcAdapter* adapter,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_ADAPTER, 3, call)) {
+        mock_adapter_return_all(mock, call, 3);
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_adapter_get_all4(
+    OrgSailfishosNfcAdapter* adapter,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_ADAPTER, 4, call)) {
+        mock_adapter_return_all(mock, call, 4);
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_adapter_request_params(
+    OrgSailfishosNfcAdapter* adapter,
+    GDBusMethodInvocation* call,
+    GVariant* params,
+    gboolean reset,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_ADAPTER, 4, call)) {
+        mock_return(mock, call, g_variant_new("(u)",
+            ++mock->last_request_id));
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_adapter_release_params(
+    OrgSailfishosNfcAdapter* adapter,
+    GDBusMethodInvocation* call,
+    guint id,
+    Mock* mock)
+{
+    mock_return(mock, call, NULL);
+    return TRUE;
+}
+
+static
+void
+mock_adapter_tags_changed(
+    Mock* mock)
+{
+    const char** tags = mock_paths(mock->tags);
+
+    org_sailfishos_nfc_adapter_emit_tags_changed(mock->adapter, tags);
+    org_sailfishos_nfc_adapter_emit_target_present_changed(mock->adapter,
+        mock->tags->len || mock->peers->len);
+    g_free(tags);
+}
+
+static
+void
+mock_adapter_peers_changed(
+    Mock* mock)
+{
+    const char** peers = mock_paths(mock->peers);
+
+    org_sailfishos_nfc_adapter_emit_peers_changed(mock->adapter, peers);
+    org_sailfishos_nfc_adapter_emit_target_present_changed(mock->adapter,
+        mock->tags->len || mock->peers->len);
+    g_free(peers);
+}
+
+/*==========================================================================*
+ * org.sailfishos.nfc.Tag and org.sailfishos.nfc.IsoDep
+ *==========================================================================*/
+
+static const char* const mock_tag_interfaces[] = {
+    "org.sailfishos.nfc.Tag",
+    "org.sailfishos.nfc.IsoDep",
+    NULL
+};
+
+static
+void
+mock_tag_remove(
+    Mock* mock,
+    MockTag* tag);
+
+static
+gboolean
+mock_tag_get_all(
+    OrgSailfishosNfcTag* tag,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    mock_return(mock, call, g_variant_new("(ibuuu^as^ao)",
+        mock->version[MOCK_IFACE_TAG], TRUE, MOCK_TECH_NFC_A,
+        MOCK_PROTOCOL_T4A, 0, mock_tag_interfaces, mock_none));
+    return TRUE;
+}
+
+static
+gboolean
+mock_tag_get_all3(
+    OrgSailfishosNfcTag* tag,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_TAG, 3, call)) {
+        mock_return(mock, call, g_variant_new("(ibuuu^as^ao@a{sv})",
+            mock->version[MOCK_IFACE_TAG], TRUE, MOCK_TECH_NFC_A,
+            MOCK_PROTOCOL_T4A, 0, mock_tag_interfaces, mock_none,
+            mock_empty_dict()));
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_tag_deactivate(
+    OrgSailfishosNfcTag* skeleton,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    guint i;
+
+    mock_return(mock, call, NULL);
+    for (i = 0; i < mock->tags->len; i++) {
+        MockTag* tag = g_ptr_array_index(mock->tags, i);
+
+        if (tag->tag == skeleton) {
+            mock_tag_remove(mock, tag);
+            break;
+        }
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_tag_acquire(
+    OrgSailfishosNfcTag* tag,
+    GDBusMethodInvocation* call,
+    gboolean wait,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_TAG, 2, call)) {
+        mock_return(mock, call, NULL);
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_tag_release(
+    OrgSailfishosNfcTag* tag,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_TAG, 2, call)) {
+        mock_return(mock, call, NULL);
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_tag_transceive(
+    OrgSailfishosNfcTag* tag,
+    GDBusMethodInvocation* call,
+    GVariant* data,
+    Mock* mock)
+{
+    /* Echo the data back */
+    if (mock_check_version(mock, MOCK_IFACE_TAG, 4, call)) {
+        mock_return(mock, call, g_variant_new("(@ay)", data));
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_isodep_get_all(
+    OrgSailfishosNfcIsoDep* isodep,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    mock_return(mock, call, g_variant_new("(i)",
+        mock->version[MOCK_IFACE_ISODEP]));
+    return TRUE;
+}
+
+static
+gboolean
+mock_isodep_get_all2(
+    OrgSailfishosNfcIsoDep* isodep,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_ISODEP, 2, call)) {
+        mock_return(mock, call, g_variant_new("(i@a{sv})",
+            mock->version[MOCK_IFACE_ISODEP], mock_empty_dict()));
+    }
+    return TRUE;
+}
+
+static
+gboolean
+mock_isodep_reset(
+    OrgSailfishosNfcIsoDep* isodep,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    if (mock_check_version(mock, MOCK_IFACE_ISODEP, 3, call)) {
+        mock_return(mock, call, NULL);
+    }
+    return TRUE;
+}
+
+static
+const MockApdu*
+mock_apdu_lookup(
+    Mock* mock,
+    guint32 header,
+    GVariant* data)
+{
+    GSList* l;
+
+    for (l = mock->apdus; l; l = l->next) {
+        const MockApdu* apdu = l->data;
+
+        if (apdu->header == header) {
+            if (apdu->data) {
+                gsize size;
+                const void* bytes = g_variant_get_fixed_array(data, &size, 1);
+                GUtilData expected;
+
+                gutil_data_from_bytes(&expected, apdu->data);
+                if (expected.size == size &&
+                    !memcmp(expected.bytes, bytes, size)) {
+                    return apdu;
+                }
+            } else {
+                return apdu;
+            }
+        }
+    }
+    return NULL;
+}
+
+static
+gboolean
+mock_isodep_transmit(
+    OrgSailfishosNfcIsoDep* isodep,
+    GDBusMethodInvocation* call,
+    guchar cla,
+    guchar ins,
+    guchar p1,
+    guchar p2,
+    GVariant* data,
+    guint le,
+    Mock* mock)
+{
+    const guint32 header = ((guint32) cla << 24) | ((guint32) ins << 16) |
+        ((guint32) p1 << 8) | p2;
+    const MockApdu* apdu = mock_apdu_lookup(mock, header, data);
+    GVariant* value;
+
+    if (apdu) {
+        GUtilData resp;
+
+        gutil_data_from_bytes(&resp, apdu->response);
+        value = g_variant_new("(@ayyy)", gutil_data_copy_as_variant(&resp),
+            (guchar) (apdu->sw >> 8), (guchar) apdu->sw);
+    } else if (mock->apdus) {
+        value = g_variant_new("(@ayyy)", g_variant_new_fixed_array
+            (G_VARIANT_TYPE_BYTE, NULL, 0, 1),
+            (guchar) (MOCK_SW_INS_NOT_SUPPORTED >> 8),
+            (guchar) MOCK_SW_INS_NOT_SUPPORTED);
+    } else {
+        /* Echo the data back */
+        value = g_variant_new("(@ayyy)", data, (guchar) (MOCK_SW_OK >> 8),
+            (guchar) MOCK_SW_OK);
+    }
+    mock_return(mock, call, value);
+    return TRUE;
+}
+
+static
+MockTag*
+mock_tag_new(
+    Mock* mock)
+{
+    MockTag* tag = g_new0(MockTag, 1);
+    GError* error = NULL;
+
+    tag->path = g_strdup_printf(MOCK_ADAPTER_PATH "/tag%u", mock->last_tag++);
+    tag->tag = org_sailfishos_nfc_tag_skeleton_new();
+    tag->isodep = org_sailfishos_nfc_iso_dep_skeleton_new();
+    g_signal_connect(tag->tag, "handle-get-all",
+        G_CALLBACK(mock_tag_get_all), mock);
+    g_signal_connect(tag->tag, "handle-get-all3",
+        G_CALLBACK(mock_tag_get_all3), mock);
+    g_signal_connect(tag->tag, "handle-deactivate",
+        G_CALLBACK(mock_tag_deactivate), mock);
+    g_signal_connect(tag->tag, "handle-acquire",
+        G_CALLBACK(mock_tag_acquire), mock);
+    g_signal_connect(tag->tag, "handle-release",
+        G_CALLBACK(mock_tag_release), mock);
+    g_signal_connect(tag->tag, "handle-transceive",
+        G_CALLBACK(mock_tag_transceive), mock);
+    g_signal_connect(tag->isodep, "handle-get-all",
+        G_CALLBACK(mock_isodep_get_all), mock);
+    g_signal_connect(tag->isodep, "handle-get-all2",
+        G_CALLBACK(mock_isodep_get_all2), mock);
+    g_signal_connect(tag->isodep, "handle-transmit",
+        G_CALLBACK(mock_isodep_transmit), mock);
+    g_signal_connect(tag->isodep, "handle-reset",
+        G_CALLBACK(mock_isodep_reset), mock);
+    if (!g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON
+        (tag->tag), mock->connection, tag->path, &error) ||
+        !g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON
+        (tag->isodep), mock->connection, tag->path, &error)) {
+        GERR("%s: %s", tag->path, GERRMSG(error));
+        g_error_free(error);
+    }
+    GDEBUG("Tag %s", tag->path);
+    return tag;
+}
+
+static
+void
+mock_tag_free(
+    gpointer data)
+{
+    MockTag* tag = data;
+
+    g_dbus_interface_skeleton_unexport(G_DBUS_INTERFACE_SKELETON(tag->tag));
+    g_dbus_interface_skeleton_unexport(G_DBUS_INTERFACE_SKELETON
+        (tag->isodep));
+    g_object_unref(tag->tag);
+    g_object_unref(tag->isodep);
+    g_free(tag->path);
+    g_free(tag);
+}
+
+static
+void
+mock_tag_remove(
+    Mock* mock,
+    MockTag* tag)
+{
+    GDEBUG("Tag %s is gone", tag->path);
+    if (mock->version[MOCK_IFACE_TAG] >= 2) {
+        org_sailfishos_nfc_tag_emit_removed(tag->tag);
+    }
+    g_ptr_array_remove(mock->tags, tag);
+    mock_adapter_tags_changed(mock);
+}
+
+/*==========================================================================*
+ * org.sailfishos.nfc.Peer
+ *==========================================================================*/
+
+static const char* const mock_peer_interfaces[] = {
+    "org.sailfishos.nfc.Peer",
+    NULL
+};
+
+static
+gboolean
+mock_peer_get_all(
+    OrgSailfishosNfcPeer* peer,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    mock_return(mock, call, g_variant_new("(ibu^asu)",
+        mock->version[MOCK_IFACE_PEER], TRUE, MOCK_TECH_NFC_A,
+        mock_peer_interfaces, MOCK_PEER_WKS));
+    return TRUE;
+}
+
+static
+gboolean
+mock_peer_deactivate(
+    OrgSailfishosNfcPeer* peer,
+    GDBusMethodInvocation* call,
+    Mock* mock)
+{
+    mock_return(mock, call, NULL);
+    return TRUE;
+}
+
+static
+gboolean
+mock_peer_connect_access_point(
+    OrgSailfishosNfcPeer* peer,
+    GDBusMethodInvocation* call,
+    GUnixFDList* fdl,
+    guint rsap,
+    Mock* mock)
+{
+    g_dbus_method_invocation_return_dbus_error(call,
+        "org.sailfishos.nfc.Error.NotSupported", "No LLCP in the mock");
+    return TRUE;
+}
+
+static
+gboolean
+mock_peer_connect_service_name(
+    OrgSailfishosNfcPeer* peer,
+    GDBusMethodInvocation* call,
+    GUnixFDList* fdl,
+    const char* sn,
+    Mock* mock)
+{
+    g_dbus_method_invocation_return_dbus_error(call,
+        "org.sailfishos.nfc.Error.NotSupported", "No LLCP in the mock");
+    return TRUE;
+}
+
+static
+MockPeer*
+mock_peer_new(
+    Mock* mock)
+{
+    MockPeer* peer = g_new0(MockPeer, 1);
+    GError* error = NULL;
+
+    peer->path = g_strdup_printf(MOCK_ADAPTER_PATH "/peer%u",
+        mock->last_peer++);
+    peer->peer = org_sailfishos_nfc_peer_skeleton_new();
+    g_signal_connect(peer->peer, "handle-get-all",
+        G_CALLBACK(mock_peer_get_all), mock);
+    g_signal_connect(peer->peer, "handle-deactivate",
+        G_CALLBACK(mock_peer_deactivate), mock);
+    g_signal_connect(peer->peer, "handle-connect-access-point",
+        G_CALLBACK(mock_peer_connect_access_point), mock);
+    g_signal_connect(peer->peer, "handle-connect-service-name",
+        G_CALLBACK(mock_peer_connect_service_name), mock);
+    if (!g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON
+        (peer->peer), mock->connection, peer->path, &error)) {
+        GERR("%s: %s", peer->path, GERRMSG(error));
+        g_error_free(error);
+    }
+    GDEBUG("Peer %s", peer->path);
+    return peer;
+}
+
+static
+void
+mock_peer_free(
+    gpointer data)
+{
+    MockPeer* peer = data;
+
+    g_dbus_interface_skeleton_unexport(G_DBUS_INTERFACE_SKELETON
+        (peer->peer));
+    g_object_unref(peer->peer);
+    g_free(peer->path);
+    g_free(peer);
+}
+
+/*==========================================================================*
+ * Commands
+ *==========================================================================*/
+
+static
+void
+mock_apdu_free(
+    gpointer data)
+{
+    MockApdu* apdu = data;
+
+    if (apdu->data) {
+        g_bytes_unref(apdu->data);
+    }
+    g_bytes_unref(apdu->response);
+    g_slice_free(MockApdu, apdu);
+}
+
+static
+GBytes*
+mock_parse_hex(
+    const char* str)
+{
+    const gsize len = strlen(str);
+
+    if (!(len & 1)) {
+        void* bytes = g_malloc(len / 2);
+
+        if (!len || gutil_hex2bin(str, len, bytes)) {
+            return g_bytes_new_take(bytes, len / 2);
+        }
+        g_free(bytes);
+    }
+    return NULL;
+}
+
+static
+gboolean
+mock_parse_uint(
+    const char* str,
+    int base,
+    guint max,
+    guint* value)
+{
+    char* end = NULL;
+    const guint64 n = g_ascii_strtoull(str, &end, base);
+
+    if (end && end != str && !*end && n <= max) {
+        *value = (guint) n;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+gpointer
+mock_find(
+    GPtrArray* list,
+    const char* path)
+{
+    guint i;
+
+    /* Both MockTag and MockPeer start with the path */
+    for (i = 0; i < list->len; i++) {
+        gpointer obj = g_ptr_array_index(list, i);
+
+        if (!path || !strcmp(*((char**) obj), path)) {
+            return obj;
+        }
+    }
+    return NULL;
+}
+
+static
+void
+mock_set_mode(
+    Mock* mock,
+    guint mode)
+{
+    if (mock->mode != mode) {
+        mock->mode = mode;
+        org_sailfishos_nfc_daemon_emit_mode_changed(mock->daemon, mode);
+        org_sailfishos_nfc_adapter_emit_mode_changed(mock->adapter, mode);
+    }
+}
+
+/*
+ * Returns FALSE if the command is invalid. Sets *sleep to non-zero for
+ * the sleep command.
+ */
+static
+gboolean
+mock_exec(
+    Mock* mock,
+    const char* line,
+    guint* sleep)
+{
+    char* buf = g_strstrip(g_strdup(line));
+    char** args = g_strsplit_set(buf, " \t", -1);
+    gboolean ok = FALSE;
+    guint argc, n;
+
+    /* Drop empty tokens left by repeated separators */
+    g_free(buf);
+    for (n = 0, argc = 0; args[n]; n++) {
+        if (args[n][0]) {
+            args[argc++] = args[n];
+        } else {
+            g_free(args[n]);
+        }
+    }
+    args[argc] = NULL;
+
+    if (!argc || args[0][0] == '#') {
+        ok = TRUE;
+    } else if (!strcmp(args[0], "version") && argc == 3) {
+        guint i;
+
+        for (i = 0; i < MOCK_IFACE_COUNT; i++) {
+            if (!strcmp(args[1], mock_iface_names[i])) {
+                if (mock_parse_uint(args[2], 10, mock_iface_max_version[i],
+                    &n) && n > 0) {
+                    mock->version[i] = n;
+                    ok = TRUE;
+                }
+                break;
+            }
+        }
+    } else if (!strcmp(args[0], "latency") && argc == 2) {
+        ok = mock_parse_uint(args[1], 10, G_MAXINT, &mock->latency);
+    } else if (!strcmp(args[0], "tag-add") && argc == 1) {
+        g_ptr_array_add(mock->tags, mock_tag_new(mock));
+        mock_adapter_tags_changed(mock);
+        ok = TRUE;
+    } else if (!strcmp(args[0], "tag-remove") && argc <= 2) {
+        MockTag* tag = mock_find(mock->tags, args[1]);
+
+        if (tag) {
+            mock_tag_remove(mock, tag);
+            ok = TRUE;
+        }
+    } else if (!strcmp(args[0], "peer-add") && argc == 1) {
+        g_ptr_array_add(mock->peers, mock_peer_new(mock));
+        mock_adapter_peers_changed(mock);
+        ok = TRUE;
+    } else if (!strcmp(args[0], "peer-remove") && argc <= 2) {
+        MockPeer* peer = mock_find(mock->peers, args[1]);
+
+        if (peer) {
+            GDEBUG("Peer %s is gone", peer->path);
+            org_sailfishos_nfc_peer_emit_removed(peer->peer);
+            g_ptr_array_remove(mock->peers, peer);
+            mock_adapter_peers_changed(mock);
+            ok = TRUE;
+        }
+    } else if (!strcmp(args[0], "mode") && argc == 2) {
+        if (mock_parse_uint(args[1], 16, MOCK_MODE_ALL, &n)) {
+            mock_set_mode(mock, n);
+            ok = TRUE;
+        }
+    } else if (!strcmp(args[0], "apdu") && argc == 5) {
+        GBytes* header = mock_parse_hex(args[1]);
+        GBytes* data = strcmp(args[2], "*") ? mock_parse_hex(args[2]) : NULL;
+        GBytes* resp = strcmp(args[3], "-") ? mock_parse_hex(args[3]) :
+            g_bytes_new(NULL, 0);
+        guint sw;
+
+        if (header && g_bytes_get_size(header) == 4 &&
+            (data || !strcmp(args[2], "*")) && resp &&
+            mock_parse_uint(args[4], 16, 0xffff, &sw)) {
+            MockApdu* apdu = g_slice_new0(MockApdu);
+            const guint8* h = g_bytes_get_data(header, NULL);
+
+            apdu->header = ((guint32) h[0] << 24) | ((guint32) h[1] << 16) |
+                ((guint32) h[2] << 8) | h[3];
+            apdu->data = data;
+            apdu->response = resp;
+            apdu->sw = sw;
+            mock->apdus = g_slist_append(mock->apdus, apdu);
+            data = resp = NULL;
+            ok = TRUE;
+        }
+        if (header) {
+            g_bytes_unref(header);
+        }
+        if (data) {
+            g_bytes_unref(data);
+        }
+        if (resp) {
+            g_bytes_unref(resp);
+        }
+    } else if (!strcmp(args[0], "apdu-clear") && argc == 1) {
+        g_slist_free_full(mock->apdus, mock_apdu_free);
+        mock->apdus = NULL;
+        ok = TRUE;
+    } else if (!strcmp(args[0], "sleep") && argc == 2) {
+        ok = mock_parse_uint(args[1], 10, G_MAXINT, sleep);
+    } else if (!strcmp(args[0], "exit") && argc <= 2) {
+        n = RET_OK;
+        if (argc == 1 || mock_parse_uint(args[1], 10, 255, &n)) {
+            mock->ret = n;
+            g_main_loop_quit(mock->loop);
+            ok = TRUE;
+        }
+    }
+
+    if (!ok) {
+        GERR("Invalid command: %s", line);
+    }
+    g_strfreev(args);
+    return ok;
+}
+
+static
+gboolean
+mock_script_wakeup(
+    gpointer user_data)
+{
+    Mock* mock = user_data;
+
+    mock->script_sleep_id = 0;
+    mock_script_continue(mock);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+mock_script_continue(
+    Mock* mock)
+{
+    while (mock->script && mock->script[mock->script_pos]) {
+        const char* line = mock->script[mock->script_pos++];
+        guint sleep = 0;
+
+        if (!mock_exec(mock, line, &sleep)) {
+            mock->ret = RET_ERR;
+            g_main_loop_quit(mock->loop);
+            break;
+        } else if (sleep) {
+            mock->script_sleep_id = g_timeout_add(sleep,
+                mock_script_wakeup, mock);
+            break;
+        }
+    }
+}
+
+/*==========================================================================*
+ * org.sailfishos.nfc.Mock
+ *==========================================================================*/
+
+static
+void
+mock_control_method_call(
+    GDBusConnection* connection,
+    const char* sender,
+    const char* path,
+    const char* iface,
+    const char* method,
+    GVariant* params,
+    GDBusMethodInvocation* call,
+    gpointer user_data)
+{
+    Mock* mock = user_data;
+
+    if (!g_strcmp0(method, "Run")) {
+        const char* command = NULL;
+        guint sleep = 0;
+
+        /* Sleep makes no sense here and is ignored */
+        g_variant_get(params, "(&s)", &command);
+        GDEBUG("Running '%s'", command);
+        if (mock_exec(mock, command, &sleep)) {
+            g_dbus_method_invocation_return_value(call, NULL);
+        } else {
+            g_dbus_method_invocation_return_error(call, G_DBUS_ERROR,
+                G_DBUS_ERROR_INVALID_ARGS, "Invalid command: %s", command);
+        }
+    } else if (!g_strcmp0(method, "EmitModeChanged")) {
+        guint i, count;
+
+        /* Flip the mode count times, ending up where we started */
+        g_variant_get(params, "(u)", &count);
+        GDEBUG("Emitting ModeChanged %u time(s)", count);
+        for (i = 0; i < count; i++) {
+            mock->mode ^= MOCK_MODE_CARD_EMULATION;
+            org_sailfishos_nfc_adapter_emit_mode_changed(mock->adapter,
+                mock->mode);
+        }
+        g_dbus_method_invocation_return_value(call, NULL);
+    } else {
+        g_dbus_method_invocation_return_error(call, G_DBUS_ERROR,
+            G_DBUS_ERROR_UNKNOWN_METHOD, "Unknown method %s", method);
+    }
+}
+
+/*==========================================================================*
+ * Setup
+ *==========================================================================*/
+
+static
+void
+mock_name_acquired(
+    GDBusConnection* connection,
+    const char* name,
+    gpointer user_data)
+{
+    Mock* mock = user_data;
+
+    GDEBUG("Acquired service name '%s'", name);
+    if (++mock->names_owned == 2) {
+        GINFO("Ready");
+        mock_script_continue(mock);
+    }
+}
+
+static
+void
+mock_name_lost(
+    GDBusConnection* connection,
+    const char* name,
+    gpointer user_data)
+{
+    Mock* mock = user_data;
+
+    GERR("'%s' service already running or access denied", name);
+    mock->ret = RET_ERR;
+    g_main_loop_quit(mock->loop);
+}
+
+static
+gboolean
+mock_export(
+    Mock* mock,
+    GDBusInterfaceSkeleton* skeleton,
+    const char* path)
+{
+    GError* error = NULL;
+
+    if (g_dbus_interface_skeleton_export(skeleton, mock->connection, path,
+        &error)) {
+        return TRUE;
+    } else {
+        GERR("%s: %s", path, GERRMSG(error));
+        g_error_free(error);
+        return FALSE;
+    }
+}
+
+static
+gboolean
+mock_init(
+    Mock* mock,
+    guint ntags)
+{
+    static const GDBusInterfaceVTable control_vtable = {
+        mock_control_method_call, NULL, NULL
+    };
+    GError* error = NULL;
+    guint i;
+
+    mock->connection = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    if (!mock->connection) {
+        GERR("%s", GERRMSG(error));
+        g_error_free(error);
+        return FALSE;
+    }
+
+    mock->mode = MOCK_MODE_READER_WRITER;
+    mock->tags = g_ptr_array_new_with_free_func(mock_tag_free);
+    mock->peers = g_ptr_array_new_with_free_func(mock_peer_free);
+
+    mock->daemon = org_sailfishos_nfc_daemon_skeleton_new();
+    g_signal_connect(mock->daemon, "handle-get-all",
+        G_CALLBACK(mock_daemon_get_all), mock);
+    g_signal_connect(mock->daemon, "handle-get-all2",
+        G_CALLBACK(mock_daemon_get_all2), mock);
+    g_signal_connect(mock->daemon, "handle-get-all3",
+        G_CALLBACK(mock_daemon_get_all3), mock);
+    g_signal_connect(mock->daemon, "handle-get-all4",
+        G_CALLBACK(mock_daemon_get_all4), mock);
+    g_signal_connect(mock->daemon, "handle-request-mode",
+        G_CALLBACK(mock_daemon_request_mode), mock);
+    g_signal_connect(mock->daemon, "handle-release-mode",
+        G_CALLBACK(mock_daemon_release), mock);
+    g_signal_connect(mock->daemon, "handle-request-techs",
+        G_CALLBACK(mock_daemon_request_techs), mock);
+    g_signal_connect(mock->daemon, "handle-release-techs",
+        G_CALLBACK(mock_daemon_release), mock);
+
+    mock->settings = org_sailfishos_nfc_settings_skeleton_new();
+    g_signal_connect(mock->settings, "handle-get-enabled",
+        G_CALLBACK(mock_settings_get_enabled), mock);
+
+    mock->adapter = org_sailfishos_nfc_adapter_skeleton_new();
+    g_signal_connect(mock->adapter, "handle-get-interface-version",
+        G_CALLBACK(mock_adapter_get_interface_version), mock);
+    g_signal_connect(mock->adapter, "handle-get-all",
+        G_CALLBACK(mock_adapter_get_all), mock);
+    g_signal_connect(mock->adapter, "handle-get-all2",
+        G_CALLBACK(mock_adapter_get_all2), mock);
+    g_signal_connect(mock->adapter, "handle-get-all3",
+        G_CALLBACK(mock_adapter_get_all3), mock);
+    g_signal_connect(mock->adapter, "handle-get-all4",
+        G_CALLBACK(mock_adapter_get_all4), mock);
+    g_signal_connect(mock->adapter, "handle-request-params",
+        G_CALLBACK(mock_adapter_request_params), mock);
+    g_signal_connect(mock->adapter, "handle-release-params",
+        G_CALLBACK(mock_adapter_release_params), mock);
+
+    if (!mock_export(mock, G_DBUS_INTERFACE_SKELETON(mock->daemon), "/") ||
+        !mock_export(mock, G_DBUS_INTERFACE_SKELETON(mock->settings), "/") ||
+        !mock_export(mock, G_DBUS_INTERFACE_SKELETON(mock->adapter),
+        MOCK_ADAPTER_PATH)) {
+        return FALSE;
+    }
+
+    for (i = 0; i < ntags; i++) {
+        g_ptr_array_add(mock->tags, mock_tag_new(mock));
+    }
+
+    mock->control_info = g_dbus_node_info_new_for_xml(mock_control_xml, NULL);
+    mock->control_id = g_dbus_connection_register_object(mock->connection,
+        "/", mock->control_info->interfaces[0], &control_vtable, mock, NULL,
+        NULL);
+
+    mock->own_daemon_id = g_bus_own_name_on_connection(mock->connection,
+        MOCK_DAEMON_NAME, G_BUS_NAME_OWNER_FLAGS_NONE, mock_name_acquired,
+        mock_name_lost, mock, NULL);
+    mock->own_settings_id = g_bus_own_name_on_connection(mock->connection,
+        MOCK_SETTINGS_NAME, G_BUS_NAME_OWNER_FLAGS_NONE, mock_name_acquired,
+        mock_name_lost, mock, NULL);
+    return TRUE;
+}
+
+static
+void
+mock_deinit(
+    Mock* mock)
+{
+    if (mock->script_sleep_id) {
+        g_source_remove(mock->script_sleep_id);
+    }
+    if (mock->own_daemon_id) {
+        g_bus_unown_name(mock->own_daemon_id);
+    }
+    if (mock->own_settings_id) {
+        g_bus_unown_name(mock->own_settings_id);
+    }
+    if (mock->control_id) {
+        g_dbus_connection_unregister_object(mock->connection,
+            mock->control_id);
+    }
+    if (mock->control_info) {
+        g_dbus_node_info_unref(mock->control_info);
+    }
+    if (mock->tags) {
+        g_ptr_array_free(mock->tags, TRUE);
+    }
+    if (mock->peers) {
+        g_ptr_array_free(mock->peers, TRUE);
+    }
+    if (mock->adapter) {
+        g_dbus_interface_skeleton_unexport(G_DBUS_INTERFACE_SKELETON
+            (mock->adapter));
+        g_object_unref(mock->adapter);
+    }
+    if (mock->settings) {
+        g_dbus_interface_skeleton_unexport(G_DBUS_INTERFACE_SKELETON
+            (mock->settings));
+        g_object_unref(mock->settings);
+    }
+    if (mock->daemon) {
+        g_dbus_interface_skeleton_unexport(G_DBUS_INTERFACE_SKELETON
+            (mock->daemon));
+        g_object_unref(mock->daemon);
+    }
+    if (mock->connection) {
+        g_object_unref(mock->connection);
+    }
+    g_slist_free_full(mock->apdus, mock_apdu_free);
+    g_strfreev(mock->script);
+}
+
+static
+gboolean
+mock_opt_verbose(
+    const gchar* name,
+    const gchar* value,
+    gpointer user_data,
+    GError** error)
+{
+    gutil_log_default.level = GLOG_LEVEL_VERBOSE;
+    return TRUE;
+}
+
+int main(int argc, char* argv[])
+{
+    int ret = RET_ERR;
+    int ntags = 1;
+    char* script = NULL;
+    GOptionEntry entries[] = {
+        { "verbose", 'v', G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK,
+          mock_opt_verbose, "Enable verbose output", NULL },
+        { "tags", 't', 0, G_OPTION_ARG_INT, &ntags,
+          "Number of tags present at startup [1]", "N" },
+        { "script", 's', 0, G_OPTION_ARG_FILENAME, &script,
+          "Run commands from FILE", "FILE" },
+        { NULL }
+    };
+    GError* error = NULL;
+    GOptionContext* options = g_option_context_new(NULL);
+
+    gutil_log_set_type(GLOG_TYPE_STDERR, "nfc-mock");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (g_option_context_parse(options, &argc, &argv, &error) &&
+        argc == 1 && ntags >= 0) {
+        Mock mock;
+        char* text = NULL;
+        guint i;
+
+        memset(&mock, 0, sizeof(mock));
+        for (i = 0; i < MOCK_IFACE_COUNT; i++) {
+            mock.version[i] = mock_iface_max_version[i];
+        }
+        if (script && !g_file_get_contents(script, &text, NULL, &error)) {
+            GERR("%s", error->message);
+            g_error_free(error);
+        } else {
+            if (text) {
+                mock.script = g_strsplit(text, "\n", -1);
+                g_free(text);
+            }
+            if (mock_init(&mock, ntags)) {
+                guint sigterm = g_unix_signal_add(SIGTERM, mock_signal,
+                    &mock);
+                guint sigint = g_unix_signal_add(SIGINT, mock_signal, &mock);
+
+                mock.ret = RET_OK;
+                mock.loop = g_main_loop_new(NULL, FALSE);
+                g_main_loop_run(mock.loop);
+                g_source_remove(sigterm);
+                g_source_remove(sigint);
+                g_main_loop_unref(mock.loop);
+                ret = mock.ret;
+            }
+            mock_deinit(&mock);
+        }
+    } else if (error) {
+        GERR("%s", error->message);
+        g_error_free(error);
+    } else {
+        char* help = g_option_context_get_help(options, TRUE, NULL);
+
+        fprintf(stderr, "%s", help);
+        g_free(help);
+    }
+    g_option_context_free(options);
+    g_free(script);
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,757 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+/*
+ * Replays a session captured by nfc_recorder_start() against nfc-mock.
+ * Tag arrivals and removals are taken from the recorded TagsChanged
+ * signals, APDU exchanges from the recorded Transmit calls and their
+ * replies. Before each exchange, nfc-mock is told to give the recorded
+ * response, so the time it takes to get the response back measures
+ * the client side (library and bus) without the card. Steps are issued
+ * with the recorded timing (optionally scaled) and reported on stdout
+ * as JSON, one object per step plus the summary. Recorded adapters are
+ * all mapped to the (single) mock adapter.
+ */
+
+#include "nfcdc_adapter.h"
+#include "nfcdc_daemon.h"
+#include "nfcdc_isodep.h"
+#include "nfcdc_recorder.h"
+
+#include <gutil_log.h>
+#include <gutil_misc.h>
+#include <gutil_strv.h>
+
+#include <gio/gio.h>
+
+#define RET_OK (0)
+#define RET_ERR (1)
+
+#define REPLAY_TIMEOUT_MS (5000)
+
+#define MOCK_CONTROL_INTERFACE "org.sailfishos.nfc.Mock"
+#define MOCK_DAEMON_NAME "org.sailfishos.nfc.daemon"
+
+typedef enum replay_op {
+    REPLAY_TAG_ARRIVED,
+    REPLAY_TAG_GONE,
+    REPLAY_TRANSMIT
+} REPLAY_OP;
+
+static const char* const replay_op_names[] = {
+    "arrival", "departure", "transmit"
+};
+
+typedef struct replay_step {
+    REPLAY_OP op;
+    gint64 time;        /* Relative to the beginning of the recording */
+    gint64 duration;    /* Recorded call duration, transmit only */
+    char* path;         /* Recorded tag path */
+    guint32 serial;
+    gboolean answered;
+    guint8 cla;
+    guint8 ins;
+    guint8 p1;
+    guint8 p2;
+    guint le;
+    GBytes* data;
+    GBytes* resp;
+    guint sw;
+} ReplayStep;
+
+typedef struct replay {
+    double speed;
+    GPtrArray* steps;
+    GDBusConnection* bus;
+    NfcDaemonClient* daemon;
+    NfcAdapterClient* adapter;
+    GHashTable* paths;      /* Recorded tag path => mock tag path */
+    GHashTable* isodeps;    /* Mock tag path => NfcIsoDepClient */
+    NfcIsoDepClient* isodep;
+    gboolean done;
+    guint sw;
+    GBytes* resp;
+    guint skipped;
+    guint failed;
+    guint mismatched;
+} Replay;
+
+typedef
+gboolean
+(*ReplayCheckFunc)(
+    Replay* replay);
+
+/*==========================================================================*
+ * Utilities
+ *==========================================================================*/
+
+static
+gboolean
+replay_timeout(
+    gpointer data)
+{
+    *((gboolean*) data) = TRUE;
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+replay_wait(
+    Replay* replay,
+    ReplayCheckFunc check)
+{
+    gboolean timed_out = FALSE;
+    guint id = g_timeout_add(REPLAY_TIMEOUT_MS, replay_timeout, &timed_out);
+
+    while (!check(replay) && !timed_out) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    if (!timed_out) {
+        g_source_remove(id);
+        return TRUE;
+    } else {
+        GERR("Timed out");
+        return FALSE;
+    }
+}
+
+static
+void
+replay_sleep_until(
+    gint64 deadline)
+{
+    const gint64 now = g_get_monotonic_time();
+
+    if (deadline > now) {
+        gboolean expired = FALSE;
+
+        g_timeout_add((guint) ((deadline - now + 999) / 1000),
+            replay_timeout, &expired);
+        while (!expired) {
+            g_main_context_iteration(NULL, TRUE);
+        }
+    }
+}
+
+/* Returns the empty string placeholder if there's no data */
+static
+char*
+replay_hex(
+    GBytes* bytes,
+    const char* empty)
+{
+    gsize size = 0;
+    const guint8* data = bytes ? g_bytes_get_data(bytes, &size) : NULL;
+
+    return size ? gutil_bin2hex(data, size, TRUE) : g_strdup(empty);
+}
+
+static
+gboolean
+replay_mock_run(
+    Replay* replay,
+    const char* command)
+{
+    GError* error = NULL;
+    GVariant* ret = g_dbus_connection_call_sync(replay->bus,
+        MOCK_DAEMON_NAME, "/", MOCK_CONTROL_INTERFACE, "Run",
+        g_variant_new("(s)", command), NULL, G_DBUS_CALL_FLAGS_NONE, -1,
+        NULL, &error);
+
+    if (ret) {
+        g_variant_unref(ret);
+        return TRUE;
+    } else {
+        GERR("%s: %s", command, GERRMSG(error));
+        g_error_free(error);
+        return FALSE;
+    }
+}
+
+/*==========================================================================*
+ * Recording
+ *==========================================================================*/
+
+static
+void
+replay_step_free(
+    gpointer data)
+{
+    ReplayStep* step = data;
+
+    if (step->data) {
+        g_bytes_unref(step->data);
+    }
+    if (step->resp) {
+        g_bytes_unref(step->resp);
+    }
+    g_free(step->path);
+    g_free(step);
+}
+
+static
+ReplayStep*
+replay_step_new(
+    REPLAY_OP op,
+    gint64 time,
+    const char* path)
+{
+    ReplayStep* step = g_new0(ReplayStep, 1);
+
+    step->op = op;
+    step->time = time;
+    step->path = g_strdup(path);
+    return step;
+}
+
+static
+GVariant*
+replay_body(
+    const guint8* ptr,
+    const char* signature,
+    gsize size)
+{
+    char* type = g_strconcat("(", signature, ")", NULL);
+    GVariant* body = NULL;
+
+    /* Copy the data to make sure it's properly aligned */
+    if (g_variant_type_string_is_valid(type)) {
+        void* copy = g_malloc(size);
+
+        memcpy(copy, ptr, size);
+        body = g_variant_ref_sink(g_variant_new_from_data
+            (G_VARIANT_TYPE(type), copy, size, FALSE, g_free, copy));
+    }
+    g_free(type);
+    return body;
+}
+
+static
+void
+replay_tags_changed(
+    Replay* replay,
+    GHashTable* tags,
+    const char* adapter,
+    GVariant* body,
+    gint64 time)
+{
+    GStrV* prev = g_hash_table_lookup(tags, adapter);
+    GStrV* list = NULL;
+    GStrV* ptr;
+
+    g_variant_get(body, "(^ao)", &list);
+    for (ptr = list; *ptr; ptr++) {
+        if (!gutil_strv_contains(prev, *ptr)) {
+            g_ptr_array_add(replay->steps, replay_step_new(REPLAY_TAG_ARRIVED,
+                time, *ptr));
+        }
+    }
+    for (ptr = prev; ptr && *ptr; ptr++) {
+        if (!gutil_strv_contains(list, *ptr)) {
+            g_ptr_array_add(replay->steps, replay_step_new(REPLAY_TAG_GONE,
+                time, *ptr));
+        }
+    }
+    g_hash_table_insert(tags, g_strdup(adapter), list);
+}
+
+static
+ReplayStep*
+replay_find_call(
+    Replay* replay,
+    guint32 serial)
+{
+    guint i = replay->steps->len;
+
+    while (i > 0) {
+        ReplayStep* step = g_ptr_array_index(replay->steps, --i);
+
+        if (step->op == REPLAY_TRANSMIT && step->serial == serial &&
+            !step->answered) {
+            return step;
+        }
+    }
+    return NULL;
+}
+
+static
+void
+replay_record(
+    Replay* replay,
+    GHashTable* tags,
+    const NfcRecorderRecord* rec,
+    const guint8* ptr,
+    gint64 t0)
+{
+    char* path = g_strndup((char*) ptr, rec->path_len);
+    char* member = g_strndup((char*) ptr + rec->path_len, rec->member_len);
+    char* sig = g_strndup((char*) ptr + rec->path_len + rec->member_len,
+        rec->signature_len);
+    GVariant* body = (rec->flags & NFC_RECORDER_FLAG_TRUNCATED) ? NULL :
+        replay_body(ptr + rec->path_len + rec->member_len +
+            rec->signature_len, sig, rec->body_len);
+    const gint64 time = rec->time - t0;
+    const gboolean incoming = (rec->flags & NFC_RECORDER_FLAG_INCOMING);
+
+    if (body) {
+        ReplayStep* step;
+
+        if (incoming && rec->type == G_DBUS_MESSAGE_TYPE_SIGNAL &&
+            !strcmp(member, "TagsChanged") && !strcmp(sig, "ao")) {
+            replay_tags_changed(replay, tags, path, body, time);
+        } else if (!incoming && rec->type == G_DBUS_MESSAGE_TYPE_METHOD_CALL
+            && !strcmp(member, "Transmit") && !strcmp(sig, "yyyyayu")) {
+            GVariant* data = NULL;
+
+            step = replay_step_new(REPLAY_TRANSMIT, time, path);
+            step->serial = rec->serial;
+            g_variant_get(body, "(yyyy@ayu)", &step->cla, &step->ins,
+                &step->p1, &step->p2, &data, &step->le);
+            step->data = g_bytes_new(g_variant_get_data(data),
+                g_variant_get_size(data));
+            g_variant_unref(data);
+            g_ptr_array_add(replay->steps, step);
+        } else if (incoming &&
+            rec->type == G_DBUS_MESSAGE_TYPE_METHOD_RETURN &&
+            !strcmp(sig, "ayyy") &&
+            (step = replay_find_call(replay, rec->reply_serial)) != NULL) {
+            GVariant* data = NULL;
+            guint8 sw1, sw2;
+
+            g_variant_get(body, "(@ayyy)", &data, &sw1, &sw2);
+            step->answered = TRUE;
+            step->duration = time - step->time;
+            step->resp = g_bytes_new(g_variant_get_data(data),
+                g_variant_get_size(data));
+            step->sw = NFC_ISODEP_SW(sw1, sw2);
+            g_variant_unref(data);
+        }
+        g_variant_unref(body);
+    }
+    g_free(path);
+    g_free(member);
+    g_free(sig);
+}
+
+static
+gboolean
+replay_load(
+    Replay* replay,
+    const char* file)
+{
+    gchar* contents = NULL;
+    gsize length = 0;
+    GError* error = NULL;
+    gboolean ok = FALSE;
+
+    if (g_file_get_contents(file, &contents, &length, &error)) {
+        NfcRecorderHeader h;
+
+        if (length >= sizeof(h)) {
+            memcpy(&h, contents, sizeof(h));
+        }
+        if (length < sizeof(h) || memcmp(h.magic, NFC_RECORDER_MAGIC,
+            sizeof(h.magic)) || h.version != NFC_RECORDER_VERSION ||
+            length < h.header_size + h.data_size) {
+            GERR("%s: not a recording", file);
+        } else {
+            const guint8* data = (guint8*) contents + h.header_size;
+            GHashTable* tags = g_hash_table_new_full(g_str_hash, g_str_equal,
+                g_free, (GDestroyNotify) g_strfreev);
+            gsize pos = h.tail;
+            gint64 t0 = 0;
+            guint64 i;
+
+            for (i = 0; i < h.count; i++) {
+                NfcRecorderRecord rec;
+
+                if (pos + sizeof(rec) > h.data_size ||
+                    !((NfcRecorderRecord*) (data + pos))->size) {
+                    pos = 0;
+                }
+                memcpy(&rec, data + pos, sizeof(rec));
+                if (rec.size < sizeof(rec) || pos + rec.size > h.data_size) {
+                    GWARN("%s: broken record at %lu", file, (gulong) pos);
+                    break;
+                }
+                if (!i) {
+                    t0 = rec.time;
+                }
+                replay_record(replay, tags, &rec, data + pos + sizeof(rec),
+                    t0);
+                pos += rec.size;
+            }
+            g_hash_table_destroy(tags);
+            GDEBUG("%u step(s) loaded", replay->steps->len);
+            ok = TRUE;
+        }
+        g_free(contents);
+    } else {
+        GERR("%s", GERRMSG(error));
+        g_error_free(error);
+    }
+    return ok;
+}
+
+/*==========================================================================*
+ * Replay
+ *==========================================================================*/
+
+static
+gboolean
+replay_daemon_ready(
+    Replay* replay)
+{
+    return replay->daemon->valid && replay->daemon->present;
+}
+
+static
+gboolean
+replay_adapter_ready(
+    Replay* replay)
+{
+    return replay->adapter->valid;
+}
+
+static
+gboolean
+replay_isodep_ready(
+    Replay* replay)
+{
+    return replay->isodep->valid && replay->isodep->present;
+}
+
+static
+gboolean
+replay_isodep_gone(
+    Replay* replay)
+{
+    return replay->isodep->valid && !replay->isodep->present;
+}
+
+static
+gboolean
+replay_new_tag(
+    Replay* replay)
+{
+    const GStrV* ptr;
+
+    for (ptr = replay->adapter->tags; *ptr; ptr++) {
+        if (!g_hash_table_contains(replay->isodeps, *ptr)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static
+gboolean
+replay_done(
+    Replay* replay)
+{
+    return replay->done;
+}
+
+static
+void
+replay_transmit_done(
+    NfcIsoDepClient* isodep,
+    const GUtilData* response,
+    guint sw,
+    const GError* error,
+    void* user_data)
+{
+    Replay* replay = user_data;
+
+    replay->done = TRUE;
+    replay->sw = error ? 0 : sw;
+    replay->resp = response ? g_bytes_new(response->bytes, response->size) :
+        NULL;
+}
+
+static
+gboolean
+replay_arrival(
+    Replay* replay,
+    ReplayStep* step)
+{
+    const GStrV* ptr;
+
+    if (replay_mock_run(replay, "tag-add") &&
+        replay_wait(replay, replay_new_tag)) {
+        for (ptr = replay->adapter->tags; *ptr; ptr++) {
+            if (!g_hash_table_contains(replay->isodeps, *ptr)) {
+                replay->isodep = nfc_isodep_client_new(*ptr);
+                g_hash_table_insert(replay->isodeps, g_strdup(*ptr),
+                    replay->isodep);
+                g_hash_table_insert(replay->paths, g_strdup(step->path),
+                    g_strdup(*ptr));
+                return replay_wait(replay, replay_isodep_ready);
+            }
+        }
+    }
+    return FALSE;
+}
+
+static
+gboolean
+replay_departure(
+    Replay* replay,
+    ReplayStep* step)
+{
+    const char* path = g_hash_table_lookup(replay->paths, step->path);
+
+    replay->isodep = path ? g_hash_table_lookup(replay->isodeps, path) : NULL;
+    if (replay->isodep) {
+        char* cmd = g_strconcat("tag-remove ", path, NULL);
+        gboolean ok = replay_mock_run(replay, cmd) &&
+            replay_wait(replay, replay_isodep_gone);
+
+        g_free(cmd);
+        g_hash_table_remove(replay->isodeps, path);
+        g_hash_table_remove(replay->paths, step->path);
+        replay->isodep = NULL;
+        return ok;
+    }
+    replay->skipped++;
+    return TRUE;
+}
+
+static
+gboolean
+replay_transmit(
+    Replay* replay,
+    ReplayStep* step,
+    gint64* elapsed)
+{
+    const char* path = g_hash_table_lookup(replay->paths, step->path);
+    NfcIsoDepClient* isodep = path ?
+        g_hash_table_lookup(replay->isodeps, path) : NULL;
+    char* data = replay_hex(step->data, "*");
+    char* resp = replay_hex(step->resp, "-");
+    char* cmd = g_strdup_printf("apdu %02X%02X%02X%02X %s %s %04X",
+        step->cla, step->ins, step->p1, step->p2, data, resp, step->sw);
+    gboolean ok = FALSE;
+
+    /* The mock is told exactly what to respond */
+    if (isodep && step->answered && replay_mock_run(replay, "apdu-clear") &&
+        replay_mock_run(replay, cmd)) {
+        NfcIsoDepApdu apdu;
+        gint64 t0;
+
+        memset(&apdu, 0, sizeof(apdu));
+        apdu.cla = step->cla;
+        apdu.ins = step->ins;
+        apdu.p1 = step->p1;
+        apdu.p2 = step->p2;
+        apdu.le = step->le;
+        if (step->data) {
+            apdu.data.bytes = g_bytes_get_data(step->data, &apdu.data.size);
+        }
+        replay->done = FALSE;
+        t0 = g_get_monotonic_time();
+        if (nfc_isodep_client_transmit(isodep, &apdu, NULL,
+            replay_transmit_done, replay, NULL) &&
+            replay_wait(replay, replay_done)) {
+            *elapsed = g_get_monotonic_time() - t0;
+            if (replay->sw != step->sw || !replay->resp ||
+                !g_bytes_equal(replay->resp, step->resp)) {
+                replay->mismatched++;
+            }
+            ok = TRUE;
+        }
+        if (replay->resp) {
+            g_bytes_unref(replay->resp);
+            replay->resp = NULL;
+        }
+    } else {
+        replay->skipped++;
+        ok = TRUE;
+        *elapsed = -1;
+    }
+    g_free(cmd);
+    g_free(data);
+    g_free(resp);
+    return ok;
+}
+
+static
+int
+replay_run(
+    Replay* replay)
+{
+    int ret = RET_ERR;
+
+    replay->bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, NULL);
+    replay->daemon = nfc_daemon_client_new();
+    if (replay->bus && replay_wait(replay, replay_daemon_ready) &&
+        replay->daemon->adapters[0]) {
+        replay->adapter = nfc_adapter_client_new(replay->daemon->adapters[0]);
+        if (replay_wait(replay, replay_adapter_ready)) {
+            const gint64 start = g_get_monotonic_time();
+            gint64 client_us = 0, recorded_us = 0;
+            guint i, n = 0;
+
+            ret = RET_OK;
+            for (i = 0; i < replay->steps->len && ret == RET_OK; i++) {
+                ReplayStep* step = g_ptr_array_index(replay->steps, i);
+                gint64 t0, elapsed = -1;
+                gboolean ok;
+
+                if (replay->speed > 0) {
+                    replay_sleep_until(start + (gint64) (step->time /
+                        replay->speed));
+                }
+                t0 = g_get_monotonic_time();
+                switch (step->op) {
+                case REPLAY_TAG_ARRIVED:
+                    ok = replay_arrival(replay, step);
+                    elapsed = g_get_monotonic_time() - t0;
+                    break;
+                case REPLAY_TAG_GONE:
+                    ok = replay_departure(replay, step);
+                    elapsed = g_get_monotonic_time() - t0;
+                    break;
+                default:
+                    ok = replay_transmit(replay, step, &elapsed);
+                    break;
+                }
+                if (!ok) {
+                    replay->failed++;
+                    ret = RET_ERR;
+                }
+                printf("{\"step\":%u,\"op\":\"%s\",\"path\":\"%s\","
+                    "\"time_us\":%" G_GINT64_FORMAT ",\"replay_us\":%"
+                    G_GINT64_FORMAT, i, replay_op_names[step->op],
+                    step->path, step->time, elapsed);
+                if (step->op == REPLAY_TRANSMIT && step->answered &&
+                    elapsed >= 0) {
+                    printf(",\"recorded_us\":%" G_GINT64_FORMAT ",\"delta_us"
+                        "\":%" G_GINT64_FORMAT, step->duration, elapsed -
+                        step->duration);
+                    client_us += elapsed;
+                    recorded_us += step->duration;
+                    n++;
+                }
+                printf(",\"ok\":%s}\n", ok ? "true" : "false");
+            }
+            printf("{\"summary\":true,\"steps\":%u,\"transmits\":%u,"
+                "\"skipped\":%u,\"failed\":%u,\"mismatched\":%u,"
+                "\"client_us\":%" G_GINT64_FORMAT ",\"recorded_us\":%"
+                G_GINT64_FORMAT "}\n", replay->steps->len, n,
+                replay->skipped, replay->failed, replay->mismatched,
+                client_us, recorded_us);
+            fflush(stdout);
+        }
+    } else {
+        GERR("No NFC adapter found");
+    }
+    nfc_adapter_client_unref(replay->adapter);
+    nfc_daemon_client_unref(replay->daemon);
+    if (replay->bus) {
+        g_object_unref(replay->bus);
+    }
+    return ret;
+}
+
+/*==========================================================================*
+ * Main
+ *==========================================================================*/
+
+static
+gboolean
+replay_opt_verbose(
+    const gchar* name,
+    const gchar* value,
+    gpointer user_data,
+    GError** error)
+{
+    gutil_log_default.level = GLOG_LEVEL_VERBOSE;
+    return TRUE;
+}
+
+int main(int argc, char* argv[])
+{
+    int ret = RET_ERR;
+    Replay replay;
+    GOptionEntry entries[] = {
+        { "verbose", 'v', G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK,
+          replay_opt_verbose, "Enable verbose output", NULL },
+        { "speed", 's', 0, G_OPTION_ARG_DOUBLE, &replay.speed,
+          "Timing scale, 0 to go as fast as possible [1]", "X" },
+        { NULL }
+    };
+    GError* error = NULL;
+    GOptionContext* options = g_option_context_new("FILE");
+
+    memset(&replay, 0, sizeof(replay));
+    replay.speed = 1;
+    gutil_log_default.level = GLOG_LEVEL_ERR;
+    gutil_log_set_type(GLOG_TYPE_STDERR, "nfc-replay");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (g_option_context_parse(options, &argc, &argv, &error) &&
+        argc == 2 && replay.speed >= 0) {
+        replay.steps = g_ptr_array_new_with_free_func(replay_step_free);
+        replay.paths = g_hash_table_new_full(g_str_hash, g_str_equal,
+            g_free, g_free);
+        replay.isodeps = g_hash_table_new_full(g_str_hash, g_str_equal,
+            g_free, (GDestroyNotify) nfc_isodep_client_unref);
+        if (replay_load(&replay, argv[1])) {
+            ret = replay_run(&replay);
+        }
+        g_hash_table_destroy(replay.isodeps);
+        g_hash_table_destroy(replay.paths);
+        g_ptr_array_free(replay.steps, TRUE);
+    } else if (error) {
+        GERR("%s", error->message);
+        g_error_free(error);
+    } else {
+        char* help = g_option_context_get_help(options, TRUE, NULL);
+
+        fprintf(stderr, "%s", help);
+        g_free(help);
+    }
+    g_option_context_free(options);
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,869 @@
+/*
+ * Copyright (C) 2025 Slava Monich <slava@monich.com>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in
+ *      the documentation and/or other materials provided with the
+ *      distribution.
+ *   3. Neither the names of the copyright holders nor the names of its
+ *      contributors may be used to endorse or promote products derived
+ *      from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation
+ * are those of the authors and should not be interpreted as representing
+ * any official policies, either expressed or implied.
+ */
+
+/*
+ * Tag and peer churn stress test. Makes nfc-mock add and remove tags
+ * and peers at a high rate while clients are being created, locked,
+ * transmitting and unreffed, then checks for leaked objects, missed or
+ * duplicated property signals and RSS growth. Also reports how long it
+ * takes a tag client to become valid. Normally run by "make stress"
+ * on a private bus. The result is printed to stdout as a JSON object.
+ */
+
+#include "nfcdc_adapter.h"
+#include "nfcdc_daemon.h"
+#include "nfcdc_isodep.h"
+#include "nfcdc_peer.h"
+#include "nfcdc_stats.h"
+#include "nfcdc_tag.h"
+
+#include <gutil_log.h>
+#include <gutil_misc.h>
+#include <gutil_strv.h>
+
+#include <gio/gio.h>
+
+#include <unistd.h>
+
+#define RET_OK (0)
+#define RET_ERR (1)
+
+#define STRESS_TIMEOUT_MS (5000)
+#define STRESS_TICK_MS (10)
+#define STRESS_MAX_PENDING (256)
+#define STRESS_PEER_EVERY (8)
+
+#define MOCK_CONTROL_INTERFACE "org.sailfishos.nfc.Mock"
+#define MOCK_DAEMON_NAME "org.sailfishos.nfc.daemon"
+
+typedef struct stress {
+    int duration;
+    int rate;
+    int max_tags;
+    GDBusConnection* bus;
+    NfcDaemonClient* daemon;
+    NfcAdapterClient* adapter;
+    gulong adapter_id[2];
+    GHashTable* targets;
+    GHashTable* peers;
+    GHashTable* seen;
+    GSList* dying;
+    guint drop_id;
+    char** last_tags;
+    char** last_peers;
+    GArray* samples;
+    NfcIsoDepApdu apdu;
+    guint churn_id;
+    guint ops;
+    guint pending;
+    guint mock_tags;
+    guint mock_peers;
+    guint tags_added;
+    guint peers_added;
+    guint run_errors;
+    guint abandoned;
+    guint locks;
+    guint transmits;
+    guint transmit_errors;
+    guint duplicates;
+    guint missed;
+    guint stale;
+} Stress;
+
+typedef struct stress_target {
+    Stress* stress;
+    NfcTagClient* tag;
+    NfcIsoDepClient* isodep;
+    NfcTagClientLock* lock;
+    GCancellable* cancel;
+    gulong tag_id[2];
+    gulong isodep_id;
+    gint64 t0;
+    gboolean valid;
+    gboolean present;
+    gboolean ready;
+    gboolean transmitting;
+    gboolean transmitted;
+    guint gone;
+} StressTarget;
+
+typedef
+gboolean
+(*StressCheckFunc)(
+    Stress* stress);
+
+/*==========================================================================*
+ * Utilities
+ *==========================================================================*/
+
+static
+gboolean
+stress_timeout(
+    gpointer data)
+{
+    *((gboolean*) data) = TRUE;
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+stress_wait(
+    Stress* stress,
+    StressCheckFunc check)
+{
+    gboolean timed_out = FALSE;
+    guint id = g_timeout_add(STRESS_TIMEOUT_MS, stress_timeout, &timed_out);
+
+    while (!check(stress) && !timed_out) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    if (!timed_out) {
+        g_source_remove(id);
+        return TRUE;
+    } else {
+        GERR("Timed out");
+        return FALSE;
+    }
+}
+
+static
+guint
+stress_rss_kb(
+    void)
+{
+    char* buf = NULL;
+    guint kb = 0;
+
+    /* The second field of statm is the resident set size in pages */
+    if (g_file_get_contents("/proc/self/statm", &buf, NULL, NULL)) {
+        unsigned long size, resident;
+
+        if (sscanf(buf, "%lu %lu", &size, &resident) == 2) {
+            kb = (guint) (resident * (sysconf(_SC_PAGESIZE) / 1024));
+        }
+        g_free(buf);
+    }
+    return kb;
+}
+
+static
+int
+stress_compare_samples(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const gint64 sa = *(const gint64*)a;
+    const gint64 sb = *(const gint64*)b;
+
+    return (sa < sb) ? -1 : (sa > sb) ? 1 : 0;
+}
+
+static
+gint64
+stress_sample(
+    GArray* samples,
+    guint percent)
+{
+    const guint n = samples->len;
+
+    return n ? g_array_index(samples, gint64, MIN(n * percent / 100, n - 1))
+        : 0;
+}
+
+/*==========================================================================*
+ * Tags
+ *==========================================================================*/
+
+static
+void
+stress_target_check(
+    StressTarget* target);
+
+static
+void
+stress_target_locked(
+    NfcTagClient* tag,
+    NfcTagClientLock* lock,
+    const GError* error,
+    void* user_data)
+{
+    StressTarget* target = user_data;
+
+    if (lock) {
+        target->stress->locks++;
+        target->lock = nfc_tag_client_lock_ref(lock);
+        stress_target_check(target);
+    }
+}
+
+static
+void
+stress_target_transmit_done(
+    NfcIsoDepClient* isodep,
+    const GUtilData* response,
+    guint sw,
+    const GError* error,
+    void* user_data)
+{
+    StressTarget* target = user_data;
+    Stress* stress = target->stress;
+
+    /* Not invoked if the call has been cancelled */
+    target->transmitting = FALSE;
+    target->transmitted = TRUE;
+    if (error || sw != 0x9000) {
+        stress->transmit_errors++;
+    } else {
+        stress->transmits++;
+    }
+
+    /* Done with the tag, let others have it */
+    nfc_tag_client_lock_unref(target->lock);
+    target->lock = NULL;
+}
+
+static
+void
+stress_target_check(
+    StressTarget* target)
+{
+    Stress* stress = target->stress;
+    NfcTagClient* tag = target->tag;
+    NfcIsoDepClient* isodep = target->isodep;
+
+    if (!target->ready && tag->valid && tag->present) {
+        const gint64 dt = g_get_monotonic_time() - target->t0;
+
+        target->ready = TRUE;
+        g_array_append_val(stress->samples, dt);
+        nfc_tag_client_acquire_lock(tag, TRUE, target->cancel,
+            stress_target_locked, target, NULL);
+    }
+    if (target->lock && !target->transmitting && !target->transmitted &&
+        isodep->valid && isodep->present) {
+        target->transmitting = nfc_isodep_client_transmit(isodep,
+            &stress->apdu, target->cancel, stress_target_transmit_done,
+            target, NULL);
+    }
+}
+
+static
+void
+stress_tag_changed(
+    NfcTagClient* tag,
+    NFC_TAG_PROPERTY property,
+    void* user_data)
+{
+    StressTarget* target = user_data;
+    Stress* stress = target->stress;
+
+    /* Every signal must reflect an actual change */
+    if (property == NFC_TAG_PROPERTY_VALID) {
+        if (target->valid == tag->valid) {
+            stress->duplicates++;
+        }
+        target->valid = tag->valid;
+    } else {
+        if (target->present == tag->present) {
+            stress->duplicates++;
+        } else if (!tag->present) {
+            target->gone++;
+        }
+        target->present = tag->present;
+    }
+    stress_target_check(target);
+}
+
+static
+void
+stress_isodep_changed(
+    NfcIsoDepClient* isodep,
+    NFC_ISODEP_PROPERTY property,
+    void* user_data)
+{
+    stress_target_check(user_data);
+}
+
+static
+StressTarget*
+stress_target_new(
+    Stress* stress,
+    const char* path)
+{
+    StressTarget* target = g_new0(StressTarget, 1);
+
+    target->stress = stress;
+    target->t0 = g_get_monotonic_time();
+    target->cancel = g_cancellable_new();
+    target->tag = nfc_tag_client_new(path);
+    target->isodep = nfc_isodep_client_new(path);
+    target->valid = target->tag->valid;
+    target->present = target->tag->present;
+    target->tag_id[0] = nfc_tag_client_add_property_handler(target->tag,
+        NFC_TAG_PROPERTY_VALID, stress_tag_changed, target);
+    target->tag_id[1] = nfc_tag_client_add_property_handler(target->tag,
+        NFC_TAG_PROPERTY_PRESENT, stress_tag_changed, target);
+    target->isodep_id = nfc_isodep_client_add_property_handler
+        (target->isodep, NFC_ISODEP_PROPERTY_ANY, stress_isodep_changed,
+            target);
+    stress_target_check(target);
+    return target;
+}
+
+static
+void
+stress_target_free(
+    StressTarget* target)
+{
+    Stress* stress = target->stress;
+
+    /* The tag client must have noticed that the tag is gone */
+    if (target->tag->present) {
+        stress->stale++;
+    }
+    if (target->gone > 1) {
+        stress->duplicates += target->gone - 1;
+    } else if (target->ready && !target->gone) {
+        stress->missed++;
+    }
+    if (!target->ready) {
+        stress->abandoned++;
+    }
+
+    /* Cancel whatever is still pending and let it all go */
+    g_cancellable_cancel(target->cancel);
+    g_object_unref(target->cancel);
+    nfc_tag_client_lock_unref(target->lock);
+    nfc_tag_client_remove_all_handlers(target->tag, target->tag_id);
+    nfc_isodep_client_remove_handler(target->isodep, target->isodep_id);
+    nfc_isodep_client_unref(target->isodep);
+    nfc_tag_client_unref(target->tag);
+    g_free(target);
+}
+
+/*==========================================================================*
+ * Adapter
+ *==========================================================================*/
+
+static
+void
+stress_drop_dying(
+    Stress* stress)
+{
+    GSList* dying = stress->dying;
+    GSList* l;
+
+    stress->dying = NULL;
+    for (l = dying; l; l = l->next) {
+        stress_target_free(l->data);
+    }
+    g_slist_free(dying);
+}
+
+static
+gboolean
+stress_drop_idle(
+    gpointer user_data)
+{
+    Stress* stress = user_data;
+
+    stress->drop_id = 0;
+    stress_drop_dying(stress);
+    return G_SOURCE_REMOVE;
+}
+
+/* Counts paths which haven't been seen yet */
+static
+guint
+stress_new_paths(
+    Stress* stress,
+    const GStrV* paths)
+{
+    guint n = 0;
+
+    while (*paths) {
+        const char* path = *paths++;
+
+        if (!g_hash_table_contains(stress->seen, path)) {
+            g_hash_table_add(stress->seen, g_strdup(path));
+            n++;
+        }
+    }
+    return n;
+}
+
+static
+void
+stress_tags_changed(
+    Stress* stress)
+{
+    NfcAdapterClient* adapter = stress->adapter;
+    const GStrV* tags = adapter->tags;
+    GHashTableIter it;
+    gpointer key, value;
+    const GStrV* ptr;
+
+    if (gutil_strv_equal(stress->last_tags, tags)) {
+        stress->duplicates++;
+        return;
+    }
+    g_strfreev(stress->last_tags);
+    stress->last_tags = g_strdupv((char**) tags);
+
+    /*
+     * Tag clients are dropped on idle, to give them a chance to see
+     * the same change and clear the present flag.
+     */
+    g_hash_table_iter_init(&it, stress->targets);
+    while (g_hash_table_iter_next(&it, &key, &value)) {
+        if (!gutil_strv_contains(tags, key)) {
+            stress->dying = g_slist_append(stress->dying, value);
+            g_hash_table_iter_remove(&it);
+        }
+    }
+    if (stress->dying && !stress->drop_id) {
+        stress->drop_id = g_idle_add(stress_drop_idle, stress);
+    }
+
+    stress_new_paths(stress, tags);
+    for (ptr = tags; *ptr; ptr++) {
+        if (!g_hash_table_contains(stress->targets, *ptr)) {
+            g_hash_table_insert(stress->targets, g_strdup(*ptr),
+                stress_target_new(stress, *ptr));
+        }
+    }
+}
+
+static
+void
+stress_peers_changed(
+    Stress* stress)
+{
+    NfcAdapterClient* adapter = stress->adapter;
+    const GStrV* peers = adapter->peers;
+    GHashTableIter it;
+    gpointer key;
+    const GStrV* ptr;
+
+    if (gutil_strv_equal(stress->last_peers, peers)) {
+        stress->duplicates++;
+        return;
+    }
+    g_strfreev(stress->last_peers);
+    stress->last_peers = g_strdupv((char**) peers);
+
+    g_hash_table_iter_init(&it, stress->peers);
+    while (g_hash_table_iter_next(&it, &key, NULL)) {
+        if (!gutil_strv_contains(peers, key)) {
+            g_hash_table_iter_remove(&it);
+        }
+    }
+    stress_new_paths(stress, peers);
+    for (ptr = peers; *ptr; ptr++) {
+        if (!g_hash_table_contains(stress->peers, *ptr)) {
+            g_hash_table_insert(stress->peers, g_strdup(*ptr),
+                nfc_peer_client_new(*ptr));
+        }
+    }
+}
+
+static
+void
+stress_adapter_changed(
+    NfcAdapterClient* adapter,
+    NFC_ADAPTER_PROPERTY property,
+    void* user_data)
+{
+    Stress* stress = user_data;
+
+    if (property == NFC_ADAPTER_PROPERTY_TAGS) {
+        stress_tags_changed(stress);
+    } else {
+        stress_peers_changed(stress);
+    }
+}
+
+/*==========================================================================*
+ * Churn
+ *==========================================================================*/
+
+typedef enum stress_op {
+    STRESS_TAG_ADD,
+    STRESS_TAG_REMOVE,
+    STRESS_PEER_ADD,
+    STRESS_PEER_REMOVE
+} STRESS_OP;
+
+typedef struct stress_run {
+    Stress* stress;
+    STRESS_OP op;
+} StressRun;
+
+static
+void
+stress_run_done(
+    GObject* bus,
+    GAsyncResult* result,
+    gpointer user_data)
+{
+    StressRun* run = user_data;
+    Stress* stress = run->stress;
+    GError* error = NULL;
+    GVariant* ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(bus),
+        result, &error);
+
+    stress->pending--;
+    if (ret) {
+        if (run->op == STRESS_TAG_ADD) {
+            stress->tags_added++;
+        } else if (run->op == STRESS_PEER_ADD) {
+            stress->peers_added++;
+        }
+        g_variant_unref(ret);
+    } else {
+        GDEBUG("%s", GERRMSG(error));
+        stress->run_errors++;
+        g_error_free(error);
+    }
+    g_free(run);
+}
+
+static
+void
+stress_run(
+    Stress* stress,
+    STRESS_OP op)
+{
+    static const char* commands[] = {
+        "tag-add", "tag-remove", "peer-add", "peer-remove"
+    };
+    StressRun* run = g_new(StressRun, 1);
+
+    /* The mock executes the commands in the order they were sent */
+    switch (op) {
+    case STRESS_TAG_ADD: stress->mock_tags++; break;
+    case STRESS_TAG_REMOVE: stress->mock_tags--; break;
+    case STRESS_PEER_ADD: stress->mock_peers++; break;
+    case STRESS_PEER_REMOVE: stress->mock_peers--; break;
+    }
+    run->stress = stress;
+    run->op = op;
+    stress->pending++;
+    g_dbus_connection_call(stress->bus, MOCK_DAEMON_NAME, "/",
+        MOCK_CONTROL_INTERFACE, "Run", g_variant_new("(s)", commands[op]),
+        NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, stress_run_done, run);
+}
+
+static
+gboolean
+stress_churn(
+    gpointer user_data)
+{
+    Stress* stress = user_data;
+    guint n = MAX(stress->rate * STRESS_TICK_MS / 1000, 1);
+
+    /* Don't let the queue grow without limit if the bus can't keep up */
+    while (n-- > 0 && stress->pending < STRESS_MAX_PENDING) {
+        if (!(++stress->ops % STRESS_PEER_EVERY)) {
+            stress_run(stress, stress->mock_peers ? STRESS_PEER_REMOVE :
+                STRESS_PEER_ADD);
+        } else {
+            stress_run(stress, (stress->mock_tags < (guint) stress->max_tags)
+                ? STRESS_TAG_ADD : STRESS_TAG_REMOVE);
+        }
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static
+gboolean
+stress_timer_expired(
+    gpointer data)
+{
+    *((gboolean*) data) = TRUE;
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+stress_idle(
+    Stress* stress)
+{
+    return !stress->pending;
+}
+
+static
+gboolean
+stress_drained(
+    Stress* stress)
+{
+    return !stress->pending && !stress->adapter->tags[0] &&
+        !stress->adapter->peers[0] && !stress->dying &&
+        !g_hash_table_size(stress->targets) &&
+        !g_hash_table_size(stress->peers);
+}
+
+/*==========================================================================*
+ * Main
+ *==========================================================================*/
+
+static
+gboolean
+stress_daemon_ready(
+    Stress* stress)
+{
+    return stress->daemon->valid && stress->daemon->present;
+}
+
+static
+gboolean
+stress_adapter_ready(
+    Stress* stress)
+{
+    return stress->adapter->valid;
+}
+
+static
+gboolean
+stress_setup(
+    Stress* stress)
+{
+    stress->bus = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, NULL);
+    stress->daemon = nfc_daemon_client_new();
+    if (stress->bus && stress_wait(stress, stress_daemon_ready) &&
+        stress->daemon->adapters[0]) {
+        stress->adapter = nfc_adapter_client_new(stress->daemon->adapters[0]);
+        if (stress_wait(stress, stress_adapter_ready)) {
+            stress->adapter_id[0] = nfc_adapter_client_add_property_handler
+                (stress->adapter, NFC_ADAPTER_PROPERTY_TAGS,
+                    stress_adapter_changed, stress);
+            stress->adapter_id[1] = nfc_adapter_client_add_property_handler
+                (stress->adapter, NFC_ADAPTER_PROPERTY_PEERS,
+                    stress_adapter_changed, stress);
+            stress->last_tags = g_strdupv((char**) stress->adapter->tags);
+            stress->last_peers = g_strdupv((char**) stress->adapter->peers);
+            return TRUE;
+        }
+    }
+    GERR("No NFC adapter found");
+    return FALSE;
+}
+
+static
+int
+stress_run_all(
+    Stress* stress)
+{
+    int ret = RET_ERR;
+
+    stress->targets = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        NULL);
+    stress->peers = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) nfc_peer_client_unref);
+    stress->seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        NULL);
+    stress->samples = g_array_new(FALSE, FALSE, sizeof(gint64));
+    stress->apdu.ins = 0xb0; /* READ BINARY */
+
+    if (stress_setup(stress)) {
+        const guint rss0 = stress_rss_kb();
+        const gint64 t0 = g_get_monotonic_time();
+        gboolean done = FALSE;
+        guint timer = g_timeout_add_seconds(stress->duration,
+            stress_timer_expired, &done);
+        guint rss1, seen0, added, leaked[NFC_CLIENT_OBJECT_COUNT];
+        gboolean ok;
+        gint64 dt;
+        guint i;
+
+        /* Tags which were there before we started don't count */
+        stress_new_paths(stress, stress->adapter->tags);
+        stress_new_paths(stress, stress->adapter->peers);
+        seen0 = g_hash_table_size(stress->seen);
+        stress->mock_tags = gutil_strv_length(stress->adapter->tags);
+        stress->mock_peers = gutil_strv_length(stress->adapter->peers);
+
+        stress->churn_id = g_timeout_add(STRESS_TICK_MS, stress_churn,
+            stress);
+        while (!done) {
+            g_main_context_iteration(NULL, TRUE);
+        }
+        g_source_remove(stress->churn_id);
+        stress->churn_id = 0;
+        dt = g_get_monotonic_time() - t0;
+        GDEBUG("Draining");
+
+        /* Remove everything and wait until the dust settles */
+        ok = stress_wait(stress, stress_idle);
+        while (stress->mock_tags) {
+            stress_run(stress, STRESS_TAG_REMOVE);
+        }
+        while (stress->mock_peers) {
+            stress_run(stress, STRESS_PEER_REMOVE);
+        }
+        ok = stress_wait(stress, stress_drained) && ok;
+        while (g_main_context_iteration(NULL, FALSE));
+
+        /* Only the adapter should be alive at this point */
+        for (i = 0; i < NFC_CLIENT_OBJECT_COUNT; i++) {
+            leaked[i] = nfc_client_stats_live_objects(i);
+        }
+        leaked[NFC_CLIENT_OBJECT_ADAPTER]--;
+
+        /* Each arrival must have shown up in TagsChanged or PeersChanged */
+        added = stress->tags_added + stress->peers_added;
+        if (added > g_hash_table_size(stress->seen) - seen0) {
+            stress->missed += added - (g_hash_table_size(stress->seen) -
+                seen0);
+        }
+        rss1 = stress_rss_kb();
+
+        g_array_sort(stress->samples, stress_compare_samples);
+        printf("{\"test\":\"churn\",\"elapsed_us\":%" G_GINT64_FORMAT
+            ",\"tags\":%u,\"peers\":%u,\"run_errors\":%u,\"ready\":%u,"
+            "\"abandoned\":%u,\"valid_p50_us\":%" G_GINT64_FORMAT
+            ",\"valid_p99_us\":%" G_GINT64_FORMAT ",\"valid_max_us\":%"
+            G_GINT64_FORMAT ",\"locks\":%u,\"transmits\":%u,"
+            "\"transmit_errors\":%u,\"duplicate_signals\":%u,"
+            "\"missed_signals\":%u,\"stale_present\":%u,"
+            "\"leaked_tags\":%u,\"leaked_isodeps\":%u,\"leaked_peers\":%u,"
+            "\"leaked_adapters\":%u,\"rss_start_kb\":%u,\"rss_end_kb\":%u}\n",
+            dt, stress->tags_added, stress->peers_added, stress->run_errors,
+            stress->samples->len, stress->abandoned,
+            stress_sample(stress->samples, 50),
+            stress_sample(stress->samples, 99),
+            stress_sample(stress->samples, 100), stress->locks,
+            stress->transmits, stress->transmit_errors, stress->duplicates,
+            stress->missed, stress->stale,
+            leaked[NFC_CLIENT_OBJECT_TAG], leaked[NFC_CLIENT_OBJECT_ISODEP],
+            leaked[NFC_CLIENT_OBJECT_PEER],
+            leaked[NFC_CLIENT_OBJECT_ADAPTER], rss0, rss1);
+        fflush(stdout);
+
+        if (ok && !stress->run_errors && !stress->duplicates &&
+            !stress->missed && !stress->stale &&
+            !leaked[NFC_CLIENT_OBJECT_TAG] &&
+            !leaked[NFC_CLIENT_OBJECT_ISODEP] &&
+            !leaked[NFC_CLIENT_OBJECT_PEER] &&
+            !leaked[NFC_CLIENT_OBJECT_ADAPTER]) {
+            ret = RET_OK;
+        }
+        if (!done) {
+            g_source_remove(timer);
+        }
+    }
+
+    if (stress->drop_id) {
+        g_source_remove(stress->drop_id);
+    }
+    stress_drop_dying(stress);
+    g_hash_table_destroy(stress->targets);
+    g_hash_table_destroy(stress->peers);
+    g_hash_table_destroy(stress->seen);
+    g_array_free(stress->samples, TRUE);
+    g_strfreev(stress->last_tags);
+    g_strfreev(stress->last_peers);
+    nfc_adapter_client_remove_all_handlers(stress->adapter,
+        stress->adapter_id);
+    nfc_adapter_client_unref(stress->adapter);
+    nfc_daemon_client_unref(stress->daemon);
+    if (stress->bus) {
+        g_object_unref(stress->bus);
+    }
+    return ret;
+}
+
+static
+gboolean
+stress_opt_verbose(
+    const gchar* name,
+    const gchar* value,
+    gpointer user_data,
+    GError** error)
+{
+    gutil_log_default.level = GLOG_LEVEL_VERBOSE;
+    return TRUE;
+}
+
+int main(int argc, char* argv[])
+{
+    int ret = RET_ERR;
+    Stress stress;
+    GOptionEntry entries[] = {
+        { "verbose", 'v', G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK,
+          stress_opt_verbose, "Enable verbose output", NULL },
+        { "duration", 'd', 0, G_OPTION_ARG_INT, &stress.duration,
+          "Test duration [10]", "SEC" },
+        { "rate", 'r', 0, G_OPTION_ARG_INT, &stress.rate,
+          "Arrivals and removals per second [2000]", "N" },
+        { "tags", 't', 0, G_OPTION_ARG_INT, &stress.max_tags,
+          "Maximum number of tags present at once [4]", "N" },
+        { NULL }
+    };
+    GError* error = NULL;
+    GOptionContext* options = g_option_context_new(NULL);
+
+    memset(&stress, 0, sizeof(stress));
+    stress.duration = 10;
+    stress.rate = 2000;
+    stress.max_tags = 4;
+    gutil_log_default.level = GLOG_LEVEL_ERR;
+    gutil_log_set_type(GLOG_TYPE_STDERR, "nfc-stress");
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (g_option_context_parse(options, &argc, &argv, &error) &&
+        argc == 1 && stress.duration > 0 && stress.rate > 0 &&
+        stress.max_tags > 0) {
+        ret = stress_run_all(&stress);
+    } else if (error) {
+        GERR("%s", error->message);
+        g_error_free(error);
+    } else {
+        char* help = g_option_context_get_help(options, TRUE, NULL);
+
+        fprintf(stderr, "%s", help);
+        g_free(help);
+    }
+    g_option_context_free(options);
+    return ret;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
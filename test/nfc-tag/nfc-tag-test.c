@@ -192,6 +192,9 @@ app_tag_changed(
         app_dump_strv("NDEF records", tag->ndef_records);
         break;
     case NFC_TAG_PROPERTY_TECHNOLOGY: /* Never changes */
+    case NFC_TAG_PROPERTY_CONGESTED:
+    case NFC_TAG_PROPERTY_RETRYING:
+    case NFC_TAG_PROPERTY_POLL_PARAMS:
     case NFC_TAG_PROPERTY_ANY:
     case NFC_TAG_PROPERTY_COUNT:
         break;